@@ -149,6 +149,12 @@ template <typename T> const T &Array<T>::operator[](size_t index) const {
 }
 
 template <typename T> Array<T> &Array<T>::operator=(Array<T> &&rhs) noexcept {
+  if (this == &rhs) {
+    return *this;
+  }
+  if (m_delete_data && m_data)
+    free(m_data);
+
   m_data = rhs.m_data;
   m_size = rhs.m_size;
   m_delete_data = rhs.m_delete_data;
@@ -25,9 +25,95 @@
 
 #include "d3plot.hpp"
 #include <ctime>
+#include <thread>
 
 namespace dro {
 
+StateRange::StateRange(d3plot_file &plot_file, unsigned int fields)
+    : m_plot_file(&plot_file), m_iter(new d3plot_state_iter) {
+  if (!d3plot_state_iter_begin(m_plot_file, m_iter.get(), fields)) {
+    m_iter.reset();
+    throw D3plot::Exception(String(m_plot_file->error_string, false));
+  }
+}
+
+StateRange::~StateRange() noexcept {
+  if (m_iter)
+    d3plot_state_iter_end(m_iter.get());
+}
+
+const d3plot_state_data *StateRange::next() {
+  const d3plot_state_data *data = d3plot_state_iter_next(m_iter.get());
+  if (!data && m_plot_file->error_string) {
+    throw D3plot::Exception(String(m_plot_file->error_string, false));
+  }
+
+  return data;
+}
+
+ZoneMap::ZoneMap(ZoneMap &&rhs) noexcept : m_zone_map(rhs.m_zone_map) {
+  rhs.m_zone_map.min = nullptr;
+  rhs.m_zone_map.max = nullptr;
+  rhs.m_zone_map.num_states = 0;
+  rhs.m_zone_map.num_parts = 0;
+}
+
+ZoneMap::~ZoneMap() noexcept { d3plot_free_zone_map(&m_zone_map); }
+
+ZoneMap &ZoneMap::operator=(ZoneMap &&rhs) noexcept {
+  if (this != &rhs) {
+    d3plot_free_zone_map(&m_zone_map);
+    m_zone_map = rhs.m_zone_map;
+    rhs.m_zone_map.min = nullptr;
+    rhs.m_zone_map.max = nullptr;
+    rhs.m_zone_map.num_states = 0;
+    rhs.m_zone_map.num_parts = 0;
+  }
+  return *this;
+}
+
+double ZoneMap::min(size_t state, size_t part_index, int quantity) const {
+  if (state >= m_zone_map.num_states || part_index >= m_zone_map.num_parts ||
+      quantity < 0 || quantity >= D3PLT_ZONE_QUANTITY_COUNT) {
+    throw std::runtime_error("Index out of Range");
+  }
+
+  return m_zone_map.min[(state * m_zone_map.num_parts + part_index) *
+                            D3PLT_ZONE_QUANTITY_COUNT +
+                        quantity];
+}
+
+double ZoneMap::max(size_t state, size_t part_index, int quantity) const {
+  if (state >= m_zone_map.num_states || part_index >= m_zone_map.num_parts ||
+      quantity < 0 || quantity >= D3PLT_ZONE_QUANTITY_COUNT) {
+    throw std::runtime_error("Index out of Range");
+  }
+
+  return m_zone_map.max[(state * m_zone_map.num_parts + part_index) *
+                            D3PLT_ZONE_QUANTITY_COUNT +
+                        quantity];
+}
+
+Array<size_t> ZoneMap::states(int quantity, double min_value, double max_value,
+                              const std::vector<size_t> &part_indices) const {
+  size_t num_states;
+  size_t *states = d3plot_zone_map_states(
+      &m_zone_map, quantity, min_value, max_value,
+      part_indices.empty() ? nullptr : part_indices.data(),
+      part_indices.size(), &num_states);
+
+  return Array<size_t>(states, num_states);
+}
+
+Array<size_t> ZoneMap::parts(size_t state, int quantity, double min_value,
+                             double max_value) const {
+  size_t num_parts;
+  size_t *parts = d3plot_zone_map_parts(&m_zone_map, state, quantity,
+                                        min_value, max_value, &num_parts);
+
+  return Array<size_t>(parts, num_parts);
+}
+
 D3plot::Exception::Exception(String error_str) noexcept
     : m_error_str(std::move(error_str)) {}
 
@@ -48,8 +134,40 @@ D3plot::D3plot(const std::filesystem::path &root_file_name) {
   }
 }
 
+D3plot::D3plot(const std::filesystem::path &root_file_name,
+               const std::filesystem::path &index_file_name) {
+  m_handle = d3plot_open_indexed(root_file_name.string().c_str(),
+                                 index_file_name.string().c_str());
+  if (m_handle.error_string) {
+    char *error_string = m_handle.error_string;
+    m_handle.error_string = NULL;
+    d3plot_close(&m_handle);
+
+    throw Exception(String(error_string));
+  }
+}
+
 D3plot::~D3plot() noexcept { d3plot_close(&m_handle); }
 
+size_t D3plot::refresh() {
+  const size_t old_num_states = m_handle.num_states;
+  if (!d3plot_refresh(&m_handle)) {
+    char *error_string = m_handle.error_string;
+    m_handle.error_string = NULL;
+    throw Exception(String(error_string));
+  }
+
+  return m_handle.num_states - old_num_states;
+}
+
+void D3plot::write_index(const std::filesystem::path &index_file_name) {
+  if (!d3plot_write_index(&m_handle, index_file_name.string().c_str())) {
+    char *error_string = m_handle.error_string;
+    m_handle.error_string = NULL;
+    throw Exception(String(error_string));
+  }
+}
+
 Array<d3_word> D3plot::read_node_ids() {
   size_t num_ids;
   d3_word *ids = d3plot_read_node_ids(&m_handle, &num_ids);
@@ -92,6 +210,20 @@ Array<d3_word> D3plot::read_all_element_ids() {
   return Array<d3_word>(ids, num_ids);
 }
 
+Array<d3_word>
+D3plot::read_all_element_ids_origin(Array<uint8_t> &element_types,
+                                    Array<size_t> &element_indices) {
+  size_t num_ids;
+  uint8_t *types;
+  size_t *indices;
+  d3_word *ids =
+      d3plot_read_all_element_ids_origin(&m_handle, &num_ids, &types, &indices);
+
+  element_types = Array<uint8_t>(types, num_ids);
+  element_indices = Array<size_t>(indices, num_ids);
+  return Array<d3_word>(ids, num_ids);
+}
+
 Array<d3_word> D3plot::read_part_ids() {
   size_t num_ids;
   d3_word *ids = d3plot_read_part_ids(&m_handle, &num_ids);
@@ -113,6 +245,30 @@ std::vector<String> D3plot::read_part_titles() {
   return vec;
 }
 
+Array<size_t> D3plot::node_indices(const std::vector<d3_word> &ids) {
+  return lookup_indices(ids, d3plot_node_indices);
+}
+
+Array<size_t> D3plot::solid_indices(const std::vector<d3_word> &ids) {
+  return lookup_indices(ids, d3plot_solid_indices);
+}
+
+Array<size_t> D3plot::thick_shell_indices(const std::vector<d3_word> &ids) {
+  return lookup_indices(ids, d3plot_thick_shell_indices);
+}
+
+Array<size_t> D3plot::beam_indices(const std::vector<d3_word> &ids) {
+  return lookup_indices(ids, d3plot_beam_indices);
+}
+
+Array<size_t> D3plot::shell_indices(const std::vector<d3_word> &ids) {
+  return lookup_indices(ids, d3plot_shell_indices);
+}
+
+Array<size_t> D3plot::part_indices(const std::vector<d3_word> &ids) {
+  return lookup_indices(ids, d3plot_part_indices);
+}
+
 Array<dVec3> D3plot::read_node_coordinates(size_t state) {
   size_t num_nodes;
   dVec3 *nodes = reinterpret_cast<dVec3 *>(
@@ -137,10 +293,84 @@ Array<dVec3> D3plot::read_node_acceleration(size_t state) {
   return Array<dVec3>(nodes, num_nodes);
 }
 
+Array<dVec3> D3plot::read_node_initial_coordinates() {
+  size_t num_nodes;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(
+      d3plot_read_node_initial_coordinates(&m_handle, &num_nodes));
+
+  return Array<dVec3>(nodes, num_nodes);
+}
+
+Array<dVec3> D3plot::read_node_displacement(size_t state) {
+  size_t num_nodes;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(
+      d3plot_read_node_displacement(&m_handle, state, &num_nodes));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<dVec3>(nodes, num_nodes);
+}
+
+Array<double> D3plot::read_node_displacement_magnitude(size_t state) {
+  size_t num_nodes;
+  double *magnitudes =
+      d3plot_read_node_displacement_magnitude(&m_handle, state, &num_nodes);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<double>(magnitudes, num_nodes);
+}
+
 double D3plot::read_time(size_t state) {
   return d3plot_read_time(&m_handle, state);
 }
 
+Array<double> D3plot::read_times() {
+  size_t num_states;
+  double *times = d3plot_read_times(&m_handle, &num_states);
+
+  return Array<double>(times, num_states);
+}
+
+Array<double> D3plot::read_global_history(size_t *num_globals) {
+  size_t num_states, _num_globals;
+  double *history =
+      d3plot_read_global_history(&m_handle, &num_states, &_num_globals);
+  if (num_globals) {
+    *num_globals = _num_globals;
+  }
+
+  return Array<double>(history, num_states * _num_globals);
+}
+
+std::vector<Array<double>>
+D3plot::read_part_global_history(unsigned int quantities, size_t *num_parts) {
+  double *histories[D3PLT_PART_QUANTITY_COUNT];
+  size_t num_states, _num_parts;
+  if (!d3plot_read_part_global_history(&m_handle, quantities, histories,
+                                       &num_states, &_num_parts)) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+  if (num_parts) {
+    *num_parts = _num_parts;
+  }
+
+  std::vector<Array<double>> vec;
+  vec.reserve(D3PLT_PART_QUANTITY_COUNT);
+  for (size_t i = 0; i < D3PLT_PART_QUANTITY_COUNT; i++) {
+    const size_t size = histories[i] ? num_states * _num_parts : 0;
+    vec.emplace_back(histories[i], size);
+  }
+
+  return vec;
+}
+
+size_t D3plot::find_state(double time) {
+  return d3plot_find_state(&m_handle, time);
+}
+
 Array<d3plot_solid> D3plot::read_solids_state(size_t state) {
   size_t num_elements;
   d3plot_solid *elements =
@@ -185,6 +415,708 @@ Array<d3plot_shell> D3plot::read_shells_state(size_t state) {
   return Array<d3plot_shell>(elements, num_elements);
 }
 
+Array<double> D3plot::read_solids_von_mises(size_t state) {
+  size_t num_elements;
+  double *values =
+      d3plot_read_solids_von_mises(&m_handle, state, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<double>(values, num_elements);
+}
+
+Array<double> D3plot::read_solids_pressure(size_t state) {
+  size_t num_elements;
+  double *values = d3plot_read_solids_pressure(&m_handle, state, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<double>(values, num_elements);
+}
+
+Array<dVec3> D3plot::read_solids_principal_stresses(size_t state) {
+  size_t num_elements;
+  dVec3 *values = reinterpret_cast<dVec3 *>(
+      d3plot_read_solids_principal_stresses(&m_handle, state, &num_elements));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<dVec3>(values, num_elements);
+}
+
+Array<double> D3plot::read_thick_shells_von_mises(size_t state, int surface) {
+  size_t num_elements;
+  double *values = d3plot_read_thick_shells_von_mises(&m_handle, state,
+                                                      surface, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<double>(values, num_elements);
+}
+
+Array<double> D3plot::read_thick_shells_pressure(size_t state, int surface) {
+  size_t num_elements;
+  double *values = d3plot_read_thick_shells_pressure(&m_handle, state,
+                                                     surface, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<double>(values, num_elements);
+}
+
+Array<dVec3> D3plot::read_thick_shells_principal_stresses(size_t state,
+                                                          int surface) {
+  size_t num_elements;
+  dVec3 *values =
+      reinterpret_cast<dVec3 *>(d3plot_read_thick_shells_principal_stresses(
+          &m_handle, state, surface, &num_elements));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<dVec3>(values, num_elements);
+}
+
+Array<double> D3plot::read_shells_von_mises(size_t state, int surface) {
+  size_t num_elements;
+  double *values =
+      d3plot_read_shells_von_mises(&m_handle, state, surface, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<double>(values, num_elements);
+}
+
+Array<double> D3plot::read_shells_pressure(size_t state, int surface) {
+  size_t num_elements;
+  double *values =
+      d3plot_read_shells_pressure(&m_handle, state, surface, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<double>(values, num_elements);
+}
+
+Array<dVec3> D3plot::read_shells_principal_stresses(size_t state,
+                                                    int surface) {
+  size_t num_elements;
+  dVec3 *values =
+      reinterpret_cast<dVec3 *>(d3plot_read_shells_principal_stresses(
+          &m_handle, state, surface, &num_elements));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<dVec3>(values, num_elements);
+}
+
+Array<uint8_t> D3plot::read_node_deletion(size_t state) {
+  size_t num_items;
+  uint8_t *flags = d3plot_read_node_deletion(&m_handle, state, &num_items);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<uint8_t>(flags, num_items);
+}
+
+Array<uint8_t> D3plot::read_solids_deletion(size_t state) {
+  size_t num_items;
+  uint8_t *flags = d3plot_read_solids_deletion(&m_handle, state, &num_items);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<uint8_t>(flags, num_items);
+}
+
+Array<uint8_t> D3plot::read_thick_shells_deletion(size_t state) {
+  size_t num_items;
+  uint8_t *flags =
+      d3plot_read_thick_shells_deletion(&m_handle, state, &num_items);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<uint8_t>(flags, num_items);
+}
+
+Array<uint8_t> D3plot::read_beams_deletion(size_t state) {
+  size_t num_items;
+  uint8_t *flags = d3plot_read_beams_deletion(&m_handle, state, &num_items);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<uint8_t>(flags, num_items);
+}
+
+Array<uint8_t> D3plot::read_shells_deletion(size_t state) {
+  size_t num_items;
+  uint8_t *flags = d3plot_read_shells_deletion(&m_handle, state, &num_items);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<uint8_t>(flags, num_items);
+}
+
+Array<d3plot_solid>
+D3plot::read_solids_state_alive(size_t state, Array<size_t> &element_indices) {
+  size_t num_elements;
+  size_t *indices;
+  d3plot_solid *elements = d3plot_read_solids_state_alive(
+      &m_handle, state, &num_elements, &indices);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  element_indices = Array<size_t>(indices, num_elements);
+  return Array<d3plot_solid>(elements, num_elements);
+}
+
+Array<d3plot_thick_shell>
+D3plot::read_thick_shells_state_alive(size_t state,
+                                      Array<size_t> &element_indices) {
+  size_t num_elements;
+  size_t *indices;
+  d3plot_thick_shell *elements = d3plot_read_thick_shells_state_alive(
+      &m_handle, state, &num_elements, &indices);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  element_indices = Array<size_t>(indices, num_elements);
+  return Array<d3plot_thick_shell>(elements, num_elements);
+}
+
+Array<d3plot_beam>
+D3plot::read_beams_state_alive(size_t state, Array<size_t> &element_indices) {
+  size_t num_elements;
+  size_t *indices;
+  d3plot_beam *elements = d3plot_read_beams_state_alive(
+      &m_handle, state, &num_elements, &indices);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  element_indices = Array<size_t>(indices, num_elements);
+  return Array<d3plot_beam>(elements, num_elements);
+}
+
+Array<d3plot_shell>
+D3plot::read_shells_state_alive(size_t state, Array<size_t> &element_indices) {
+  size_t num_elements;
+  size_t *indices;
+  d3plot_shell *elements = d3plot_read_shells_state_alive(
+      &m_handle, state, &num_elements, &indices);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  element_indices = Array<size_t>(indices, num_elements);
+  return Array<d3plot_shell>(elements, num_elements);
+}
+
+void D3plot::read_node_coordinates(size_t state, Array<dVec3> &dst) {
+  read_into(state, dst, m_handle.control_data.numnp,
+            d3plot_read_node_coordinates_into);
+}
+
+void D3plot::read_node_velocity(size_t state, Array<dVec3> &dst) {
+  read_into(state, dst, m_handle.control_data.numnp,
+            d3plot_read_node_velocity_into);
+}
+
+void D3plot::read_node_acceleration(size_t state, Array<dVec3> &dst) {
+  read_into(state, dst, m_handle.control_data.numnp,
+            d3plot_read_node_acceleration_into);
+}
+
+void D3plot::read_node_displacement(size_t state, Array<dVec3> &dst) {
+  const size_t num_nodes = m_handle.control_data.numnp;
+  if (dst.size() != num_nodes) {
+    dst = Array<dVec3>(
+        reinterpret_cast<dVec3 *>(malloc(num_nodes * sizeof(dVec3))),
+        num_nodes);
+  }
+
+  if (!d3plot_read_node_displacement_into(
+          &m_handle, state, reinterpret_cast<double *>(dst.data()), NULL)) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+}
+
+void D3plot::read_node_displacement(size_t state, Array<dVec3> &dst,
+                                    Array<double> &magnitudes) {
+  const size_t num_nodes = m_handle.control_data.numnp;
+  if (dst.size() != num_nodes) {
+    dst = Array<dVec3>(
+        reinterpret_cast<dVec3 *>(malloc(num_nodes * sizeof(dVec3))),
+        num_nodes);
+  }
+  if (magnitudes.size() != num_nodes) {
+    magnitudes = Array<double>(
+        reinterpret_cast<double *>(malloc(num_nodes * sizeof(double))),
+        num_nodes);
+  }
+
+  if (!d3plot_read_node_displacement_into(
+          &m_handle, state, reinterpret_cast<double *>(dst.data()),
+          magnitudes.data())) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+}
+
+void D3plot::read_solids_state(size_t state, Array<d3plot_solid> &dst) {
+  read_into(state, dst, m_handle.control_data.nel8,
+            d3plot_read_solids_state_into);
+}
+
+void D3plot::read_thick_shells_state(size_t state,
+                                     Array<d3plot_thick_shell> &dst) {
+  read_into(state, dst, m_handle.control_data.nelt,
+            d3plot_read_thick_shells_state_into);
+}
+
+void D3plot::read_beams_state(size_t state, Array<d3plot_beam> &dst) {
+  read_into(state, dst, m_handle.control_data.nel2,
+            d3plot_read_beams_state_into);
+}
+
+void D3plot::read_shells_state(size_t state, Array<d3plot_shell> &dst) {
+  read_into(state, dst, m_handle.control_data.nel4,
+            d3plot_read_shells_state_into);
+}
+
+void D3plot::set_cache_size(size_t max_cache_size) {
+  d3plot_set_cache_size(&m_handle, max_cache_size);
+}
+
+CachedState<dVec3> D3plot::cached_node_coordinates(size_t state) {
+  return cache_get(state, D3PLT_CACHE_NODE_COORDINATES);
+}
+
+CachedState<dVec3> D3plot::cached_node_velocity(size_t state) {
+  return cache_get(state, D3PLT_CACHE_NODE_VELOCITY);
+}
+
+CachedState<dVec3> D3plot::cached_node_acceleration(size_t state) {
+  return cache_get(state, D3PLT_CACHE_NODE_ACCELERATION);
+}
+
+CachedState<d3plot_solid> D3plot::cached_solids_state(size_t state) {
+  return cache_get(state, D3PLT_CACHE_SOLIDS);
+}
+
+CachedState<d3plot_thick_shell>
+D3plot::cached_thick_shells_state(size_t state) {
+  return cache_get(state, D3PLT_CACHE_THICK_SHELLS);
+}
+
+CachedState<d3plot_beam> D3plot::cached_beams_state(size_t state) {
+  return cache_get(state, D3PLT_CACHE_BEAMS);
+}
+
+CachedState<d3plot_shell> D3plot::cached_shells_state(size_t state) {
+  return cache_get(state, D3PLT_CACHE_SHELLS);
+}
+
+CachedState<dVec3> D3plot::cached_node_displacement(size_t state) {
+  return cache_get(state, D3PLT_CACHE_NODE_DISPLACEMENT);
+}
+
+StateRange D3plot::states(unsigned int fields) {
+  return StateRange(m_handle, fields);
+}
+
+std::vector<Envelope> D3plot::read_envelopes(unsigned int quantities,
+                                             int surface,
+                                             size_t num_threads) {
+  if (num_threads == 0) {
+    num_threads = std::thread::hardware_concurrency();
+  }
+
+  d3plot_envelope envelopes[D3PLT_ENVELOPE_QUANTITY_COUNT];
+  if (!d3plot_read_envelopes(&m_handle, quantities, surface, num_threads,
+                             envelopes)) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  std::vector<Envelope> vec;
+  vec.reserve(D3PLT_ENVELOPE_QUANTITY_COUNT);
+  for (size_t i = 0; i < D3PLT_ENVELOPE_QUANTITY_COUNT; i++) {
+    const d3plot_envelope &envelope = envelopes[i];
+    vec.push_back(Envelope{
+        Array<double>(envelope.max, envelope.num_items),
+        Array<double>(envelope.min, envelope.num_items),
+        Array<size_t>(envelope.max_state, envelope.num_items),
+        Array<size_t>(envelope.min_state, envelope.num_items)});
+  }
+
+  return vec;
+}
+
+ZoneMap D3plot::build_zone_map(unsigned int quantities, int surface) {
+  d3plot_zone_map zone_map;
+  if (!d3plot_build_zone_map(&m_handle, quantities, surface, &zone_map)) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return ZoneMap(zone_map);
+}
+
+ZoneMap D3plot::open_zone_map(const std::filesystem::path &zone_map_file_name,
+                              unsigned int quantities, int surface) {
+  d3plot_zone_map zone_map;
+  if (!d3plot_open_zone_map(&m_handle, quantities, surface,
+                            zone_map_file_name.string().c_str(), &zone_map)) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return ZoneMap(zone_map);
+}
+
+void D3plot::write_zone_map(const ZoneMap &zone_map,
+                            const std::filesystem::path &zone_map_file_name) {
+  if (!d3plot_write_zone_map(&m_handle, &zone_map.get_handle(),
+                             zone_map_file_name.string().c_str())) {
+    char *error_string = m_handle.error_string;
+    m_handle.error_string = NULL;
+    throw Exception(String(error_string));
+  }
+}
+
+Array<fVec3> D3plot::read_node_coordinates_f32(size_t state) {
+  size_t num_nodes;
+  fVec3 *nodes = reinterpret_cast<fVec3 *>(
+      d3plot_read_node_coordinates_f32(&m_handle, state, &num_nodes));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<fVec3>(nodes, num_nodes);
+}
+
+Array<fVec3> D3plot::read_node_velocity_f32(size_t state) {
+  size_t num_nodes;
+  fVec3 *nodes = reinterpret_cast<fVec3 *>(
+      d3plot_read_node_velocity_f32(&m_handle, state, &num_nodes));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<fVec3>(nodes, num_nodes);
+}
+
+Array<fVec3> D3plot::read_node_acceleration_f32(size_t state) {
+  size_t num_nodes;
+  fVec3 *nodes = reinterpret_cast<fVec3 *>(
+      d3plot_read_node_acceleration_f32(&m_handle, state, &num_nodes));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<fVec3>(nodes, num_nodes);
+}
+
+Array<d3plot_solid_f32> D3plot::read_solids_state_f32(size_t state) {
+  size_t num_elements;
+  d3plot_solid_f32 *elements =
+      d3plot_read_solids_state_f32(&m_handle, state, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<d3plot_solid_f32>(elements, num_elements);
+}
+
+Array<d3plot_shell_f32> D3plot::read_shells_state_f32(size_t state) {
+  size_t num_elements;
+  d3plot_shell_f32 *elements =
+      d3plot_read_shells_state_f32(&m_handle, state, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<d3plot_shell_f32>(elements, num_elements);
+}
+
+Array<double> D3plot::read_solids_state_fields(size_t state,
+                                               unsigned int fields,
+                                               size_t *num_values) {
+  size_t num_elements, num_element_values;
+  double *values = d3plot_read_solids_state_fields(
+      &m_handle, state, fields, &num_elements, &num_element_values);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  if (num_values) {
+    *num_values = num_element_values;
+  }
+  return Array<double>(values, num_elements * num_element_values);
+}
+
+Array<double> D3plot::read_thick_shells_state_fields(size_t state,
+                                                     unsigned int fields,
+                                                     size_t *num_values) {
+  size_t num_elements, num_element_values;
+  double *values = d3plot_read_thick_shells_state_fields(
+      &m_handle, state, fields, &num_elements, &num_element_values);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  if (num_values) {
+    *num_values = num_element_values;
+  }
+  return Array<double>(values, num_elements * num_element_values);
+}
+
+Array<double> D3plot::read_shells_state_fields(size_t state,
+                                               unsigned int fields,
+                                               size_t *num_values) {
+  size_t num_elements, num_element_values;
+  double *values = d3plot_read_shells_state_fields(
+      &m_handle, state, fields, &num_elements, &num_element_values);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  if (num_values) {
+    *num_values = num_element_values;
+  }
+  return Array<double>(values, num_elements * num_element_values);
+}
+
+Array<dVec3> D3plot::read_node_coordinates_history(
+    const std::vector<size_t> &node_indices) {
+  size_t num_states;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(d3plot_read_node_coordinates_history(
+      &m_handle, node_indices.data(), node_indices.size(), &num_states));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<dVec3>(nodes, num_states * node_indices.size());
+}
+
+Array<dVec3> D3plot::read_node_velocity_history(
+    const std::vector<size_t> &node_indices) {
+  size_t num_states;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(d3plot_read_node_velocity_history(
+      &m_handle, node_indices.data(), node_indices.size(), &num_states));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<dVec3>(nodes, num_states * node_indices.size());
+}
+
+Array<dVec3> D3plot::read_node_acceleration_history(
+    const std::vector<size_t> &node_indices) {
+  size_t num_states;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(d3plot_read_node_acceleration_history(
+      &m_handle, node_indices.data(), node_indices.size(), &num_states));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<dVec3>(nodes, num_states * node_indices.size());
+}
+
+Array<double>
+D3plot::read_solids_history(const std::vector<size_t> &element_indices,
+                            unsigned int fields, size_t *num_values) {
+  size_t num_states, num_element_values;
+  double *values = d3plot_read_solids_history(
+      &m_handle, element_indices.data(), element_indices.size(), fields,
+      &num_states, &num_element_values);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  if (num_values) {
+    *num_values = num_element_values;
+  }
+  return Array<double>(values, num_states * element_indices.size() *
+                                   num_element_values);
+}
+
+Array<double>
+D3plot::read_thick_shells_history(const std::vector<size_t> &element_indices,
+                                  unsigned int fields, size_t *num_values) {
+  size_t num_states, num_element_values;
+  double *values = d3plot_read_thick_shells_history(
+      &m_handle, element_indices.data(), element_indices.size(), fields,
+      &num_states, &num_element_values);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  if (num_values) {
+    *num_values = num_element_values;
+  }
+  return Array<double>(values, num_states * element_indices.size() *
+                                   num_element_values);
+}
+
+Array<d3plot_beam>
+D3plot::read_beams_history(const std::vector<size_t> &element_indices) {
+  size_t num_states;
+  d3plot_beam *beams = reinterpret_cast<d3plot_beam *>(
+      d3plot_read_beams_history(&m_handle, element_indices.data(),
+                                element_indices.size(), &num_states));
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<d3plot_beam>(beams, num_states * element_indices.size());
+}
+
+Array<double>
+D3plot::read_shells_history(const std::vector<size_t> &element_indices,
+                            unsigned int fields, size_t *num_values) {
+  size_t num_states, num_element_values;
+  double *values = d3plot_read_shells_history(
+      &m_handle, element_indices.data(), element_indices.size(), fields,
+      &num_states, &num_element_values);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  if (num_values) {
+    *num_values = num_element_values;
+  }
+  return Array<double>(values, num_states * element_indices.size() *
+                                   num_element_values);
+}
+
+std::vector<Array<double>> D3plot::read_node_coordinates_soa(size_t state) {
+  return read_soa(state, m_handle.control_data.numnp, 3,
+                  [](d3plot_file *plot_file, size_t state, double **c) {
+                    return d3plot_read_node_coordinates_soa(plot_file, state,
+                                                            c[0], c[1], c[2]);
+                  });
+}
+
+std::vector<Array<double>> D3plot::read_node_velocity_soa(size_t state) {
+  return read_soa(state, m_handle.control_data.numnp, 3,
+                  [](d3plot_file *plot_file, size_t state, double **c) {
+                    return d3plot_read_node_velocity_soa(plot_file, state,
+                                                         c[0], c[1], c[2]);
+                  });
+}
+
+std::vector<Array<double>> D3plot::read_node_acceleration_soa(size_t state) {
+  return read_soa(state, m_handle.control_data.numnp, 3,
+                  [](d3plot_file *plot_file, size_t state, double **c) {
+                    return d3plot_read_node_acceleration_soa(plot_file, state,
+                                                             c[0], c[1], c[2]);
+                  });
+}
+
+std::vector<Array<double>> D3plot::read_solids_state_soa(size_t state) {
+  return read_soa(state, m_handle.control_data.nel8,
+                  sizeof(d3plot_solid) / sizeof(double),
+                  d3plot_read_solids_state_soa);
+}
+
+std::vector<Array<double>> D3plot::read_thick_shells_state_soa(size_t state) {
+  return read_soa(state, m_handle.control_data.nelt,
+                  sizeof(d3plot_thick_shell) / sizeof(double),
+                  d3plot_read_thick_shells_state_soa);
+}
+
+std::vector<Array<double>> D3plot::read_beams_state_soa(size_t state) {
+  return read_soa(state, m_handle.control_data.nel2,
+                  sizeof(d3plot_beam) / sizeof(double),
+                  d3plot_read_beams_state_soa);
+}
+
+std::vector<Array<double>> D3plot::read_shells_state_soa(size_t state) {
+  return read_soa(state, m_handle.control_data.nel4,
+                  sizeof(d3plot_shell) / sizeof(double),
+                  d3plot_read_shells_state_soa);
+}
+
+Array<dVec3> D3plot::read_node_coordinates_at_time(double time) {
+  size_t num_nodes;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(
+      d3plot_read_node_coordinates_at_time(&m_handle, time, &num_nodes));
+
+  return Array<dVec3>(nodes, num_nodes);
+}
+
+Array<dVec3> D3plot::read_node_velocity_at_time(double time) {
+  size_t num_nodes;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(
+      d3plot_read_node_velocity_at_time(&m_handle, time, &num_nodes));
+
+  return Array<dVec3>(nodes, num_nodes);
+}
+
+Array<dVec3> D3plot::read_node_acceleration_at_time(double time) {
+  size_t num_nodes;
+  dVec3 *nodes = reinterpret_cast<dVec3 *>(
+      d3plot_read_node_acceleration_at_time(&m_handle, time, &num_nodes));
+
+  return Array<dVec3>(nodes, num_nodes);
+}
+
+Array<d3plot_solid> D3plot::read_solids_state_at_time(double time) {
+  size_t num_elements;
+  d3plot_solid *elements =
+      d3plot_read_solids_state_at_time(&m_handle, time, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<d3plot_solid>(elements, num_elements);
+}
+
+Array<d3plot_thick_shell>
+D3plot::read_thick_shells_state_at_time(double time) {
+  size_t num_elements;
+  d3plot_thick_shell *elements =
+      d3plot_read_thick_shells_state_at_time(&m_handle, time, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<d3plot_thick_shell>(elements, num_elements);
+}
+
+Array<d3plot_beam> D3plot::read_beams_state_at_time(double time) {
+  size_t num_elements;
+  d3plot_beam *elements =
+      d3plot_read_beams_state_at_time(&m_handle, time, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<d3plot_beam>(elements, num_elements);
+}
+
+Array<d3plot_shell> D3plot::read_shells_state_at_time(double time) {
+  size_t num_elements;
+  d3plot_shell *elements =
+      d3plot_read_shells_state_at_time(&m_handle, time, &num_elements);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return Array<d3plot_shell>(elements, num_elements);
+}
+
 Array<d3plot_solid_con> D3plot::read_solid_elements() {
   size_t num_elements;
   d3plot_solid_con *elements =
@@ -231,4 +1163,80 @@ D3plotPart D3plot::read_part(size_t part_index) {
   return D3plotPart(part);
 }
 
+D3plotPartState D3plot::read_part_state(size_t part_index, size_t state) {
+  d3plot_part_state part_state =
+      d3plot_read_part_state(&m_handle, part_index, state);
+  if (m_handle.error_string) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return D3plotPartState{
+      Array<d3plot_solid>(part_state.solids, part_state.num_solids),
+      Array<d3plot_thick_shell>(part_state.thick_shells,
+                                part_state.num_thick_shells),
+      Array<d3plot_beam>(part_state.beams, part_state.num_beams),
+      Array<d3plot_shell>(part_state.shells, part_state.num_shells)};
+}
+
+d3plot_cached_state *D3plot::cache_get(size_t state, int field) {
+  d3plot_cached_state *entry = d3plot_cache_get(&m_handle, state, field);
+  if (!entry) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  return entry;
+}
+
+template <typename T, typename U>
+void D3plot::read_into(size_t state, Array<T> &dst, size_t num_values,
+                       int (*read_func)(d3plot_file *, size_t, U *)) {
+  if (dst.size() != num_values) {
+    dst = Array<T>(
+        reinterpret_cast<T *>(malloc(num_values * sizeof(T))), num_values);
+  }
+
+  if (!read_func(&m_handle, state, reinterpret_cast<U *>(dst.data()))) {
+    throw Exception(String(m_handle.error_string, false));
+  }
+}
+
+Array<size_t> D3plot::lookup_indices(
+    const std::vector<d3_word> &ids,
+    size_t (*lookup_func)(d3plot_file *, const d3_word *, size_t, size_t *)) {
+  if (ids.empty()) {
+    return Array<size_t>(nullptr, 0);
+  }
+
+  size_t *indices =
+      reinterpret_cast<size_t *>(malloc(ids.size() * sizeof(size_t)));
+  lookup_func(&m_handle, ids.data(), ids.size(), indices);
+
+  return Array<size_t>(indices, ids.size());
+}
+
+std::vector<Array<double>>
+D3plot::read_soa(size_t state, size_t num_elements, size_t num_values,
+                 int (*read_func)(d3plot_file *, size_t, double **)) {
+  std::vector<double *> components(num_values);
+  for (size_t i = 0; i < num_values; i++) {
+    components[i] =
+        reinterpret_cast<double *>(malloc(num_elements * sizeof(double)));
+  }
+
+  if (!read_func(&m_handle, state, components.data())) {
+    for (double *component : components) {
+      free(component);
+    }
+    throw Exception(String(m_handle.error_string, false));
+  }
+
+  std::vector<Array<double>> arrays;
+  arrays.reserve(num_values);
+  for (double *component : components) {
+    arrays.emplace_back(component, num_elements);
+  }
+
+  return arrays;
+}
+
 } // namespace dro
@@ -30,10 +30,212 @@
 #include <d3plot.h>
 #include <exception>
 #include <filesystem>
+#include <memory>
 #include <vector>
 
 namespace dro {
 
+// A read only view of a decoded state inside the state cache of a D3plot.
+// Copies share the same memory, which stays valid until the last copy has been
+// destroyed
+template <typename T> class CachedState {
+public:
+  CachedState(d3plot_cached_state *entry) noexcept : m_entry(entry) {}
+  CachedState(const CachedState<T> &rhs) noexcept : m_entry(rhs.m_entry) {
+    d3plot_cache_retain(m_entry);
+  }
+  CachedState(CachedState<T> &&rhs) noexcept : m_entry(rhs.m_entry) {
+    rhs.m_entry = nullptr;
+  }
+  ~CachedState() noexcept {
+    if (m_entry)
+      d3plot_cache_release(m_entry);
+  }
+
+  CachedState<T> &operator=(const CachedState<T> &rhs) noexcept {
+    if (rhs.m_entry)
+      d3plot_cache_retain(rhs.m_entry);
+    if (m_entry)
+      d3plot_cache_release(m_entry);
+    m_entry = rhs.m_entry;
+    return *this;
+  }
+  CachedState<T> &operator=(CachedState<T> &&rhs) noexcept {
+    if (this != &rhs) {
+      if (m_entry)
+        d3plot_cache_release(m_entry);
+      m_entry = rhs.m_entry;
+      rhs.m_entry = nullptr;
+    }
+    return *this;
+  }
+
+  const T &operator[](size_t index) const {
+    if (index >= size()) {
+      throw std::runtime_error("Index out of Range");
+    }
+    return data()[index];
+  }
+
+  const T *data() const noexcept {
+    return m_entry ? static_cast<const T *>(m_entry->data) : nullptr;
+  }
+  size_t size() const noexcept { return m_entry ? m_entry->num_items : 0; }
+  bool empty() const noexcept { return size() == 0; }
+
+  const T *begin() const noexcept { return data(); }
+  const T *end() const noexcept { return data() + size(); }
+
+private:
+  d3plot_cached_state *m_entry;
+};
+
+// One state returned while streaming the states of a D3plot (see
+// D3plot::states). The fields point into the buffers of the StateRange and are
+// only valid until the range has been advanced. Fields that have not been
+// selected are empty
+class StateView {
+public:
+  StateView(const d3plot_state_data *data) noexcept
+      : m_data(data), m_state(data->state), m_time(data->time) {}
+
+  // The state and time stay valid after the range has been advanced
+  size_t state() const noexcept { return m_state; }
+  double time() const noexcept { return m_time; }
+
+  Array<dVec3> node_coordinates() const noexcept {
+    return field<dVec3>(D3PLT_CACHE_NODE_COORDINATES);
+  }
+  Array<dVec3> node_velocity() const noexcept {
+    return field<dVec3>(D3PLT_CACHE_NODE_VELOCITY);
+  }
+  Array<dVec3> node_acceleration() const noexcept {
+    return field<dVec3>(D3PLT_CACHE_NODE_ACCELERATION);
+  }
+  Array<d3plot_solid> solids() const noexcept {
+    return field<d3plot_solid>(D3PLT_CACHE_SOLIDS);
+  }
+  Array<d3plot_thick_shell> thick_shells() const noexcept {
+    return field<d3plot_thick_shell>(D3PLT_CACHE_THICK_SHELLS);
+  }
+  Array<d3plot_beam> beams() const noexcept {
+    return field<d3plot_beam>(D3PLT_CACHE_BEAMS);
+  }
+  Array<d3plot_shell> shells() const noexcept {
+    return field<d3plot_shell>(D3PLT_CACHE_SHELLS);
+  }
+  Array<dVec3> node_displacement() const noexcept {
+    return field<dVec3>(D3PLT_CACHE_NODE_DISPLACEMENT);
+  }
+
+private:
+  // Returns an Array that does not own the memory of the field
+  template <typename T> Array<T> field(int f) const noexcept {
+    return Array<T>(static_cast<T *>(m_data->data[f]), m_data->num_items[f],
+                    false);
+  }
+
+  const d3plot_state_data *m_data;
+  size_t m_state;
+  double m_time;
+};
+
+// Streams every state of a D3plot. The next state is read by a background
+// thread while the current one is processed. Can only be iterated once
+class StateRange {
+public:
+  class Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using difference_type = std::ptrdiff_t;
+    using value_type = StateView;
+
+    Iterator(StateRange *range, const d3plot_state_data *data) noexcept
+        : m_range(range), m_data(data) {}
+
+    StateView operator*() const noexcept { return StateView(m_data); }
+    Iterator &operator++() {
+      m_data = m_range->next();
+      return *this;
+    }
+    bool operator==(const Iterator &rhs) const noexcept {
+      return m_data == rhs.m_data;
+    }
+    bool operator!=(const Iterator &rhs) const noexcept {
+      return m_data != rhs.m_data;
+    }
+
+  private:
+    StateRange *m_range;
+    const d3plot_state_data *m_data;
+  };
+
+  // fields selects which fields (1 << D3PLT_CACHE_*) are read
+  StateRange(d3plot_file &plot_file, unsigned int fields);
+  StateRange(const StateRange &) = delete;
+  StateRange(StateRange &&rhs) noexcept = default;
+  ~StateRange() noexcept;
+
+  StateRange &operator=(const StateRange &) = delete;
+
+  // Returns the next state or nullptr after the last one
+  const d3plot_state_data *next();
+
+  Iterator begin() { return Iterator(this, next()); }
+  Iterator end() noexcept { return Iterator(this, nullptr); }
+
+private:
+  d3plot_file *m_plot_file;
+  // The iterator is referenced by its background thread and therefore must
+  // not move
+  std::unique_ptr<d3plot_state_iter> m_iter;
+};
+
+// The largest and smallest value of a quantity of every node or element over
+// all states and the first states at which they have been reached (see
+// D3plot::read_envelopes)
+struct Envelope {
+  Array<double> max, min;
+  Array<size_t> max_state, min_state;
+};
+
+// The smallest and largest value of quantities (D3PLT_ZONE_*) of every part at
+// every state (see D3plot::build_zone_map). A range query only needs to read
+// the states and parts returned by states and parts
+class ZoneMap {
+public:
+  ZoneMap(d3plot_zone_map zone_map) noexcept : m_zone_map(zone_map) {}
+  ZoneMap(const ZoneMap &) = delete;
+  ZoneMap(ZoneMap &&rhs) noexcept;
+  ~ZoneMap() noexcept;
+
+  ZoneMap &operator=(const ZoneMap &) = delete;
+  ZoneMap &operator=(ZoneMap &&rhs) noexcept;
+
+  // The smallest and largest value of quantity of a part at a state. Parts
+  // without any value have a min of HUGE_VAL and a max of -HUGE_VAL
+  double min(size_t state, size_t part_index, int quantity) const;
+  double max(size_t state, size_t part_index, int quantity) const;
+  // Returns the states at which any part of part_indices (all parts if empty)
+  // may hold a value of quantity inside [min_value, max_value]
+  Array<size_t> states(int quantity, double min_value, double max_value,
+                       const std::vector<size_t> &part_indices = {}) const;
+  // Returns the parts that may hold a value of quantity inside
+  // [min_value, max_value] at state
+  Array<size_t> parts(size_t state, int quantity, double min_value,
+                      double max_value) const;
+
+  size_t num_states() const noexcept { return m_zone_map.num_states; }
+  size_t num_parts() const noexcept { return m_zone_map.num_parts; }
+  // The quantities (1 << D3PLT_ZONE_*) that have been summarized
+  unsigned int quantities() const noexcept { return m_zone_map.quantities; }
+  int surface() const noexcept { return m_zone_map.surface; }
+  const d3plot_zone_map &get_handle() const noexcept { return m_zone_map; }
+
+private:
+  d3plot_zone_map m_zone_map;
+};
+
 // This holds all data needed to read d3plot files
 class D3plot {
 public:
@@ -50,8 +252,18 @@ public:
   // Open a d3plot file family by giving the root file name
   // Example: d3plot of d3plot01, d3plot02, d3plot03, etc.
   D3plot(const std::filesystem::path &root_file_name);
+  // Open a d3plot file family and load its layout from an index file. The
+  // index file is (re)written if it does not exist or is outdated
+  D3plot(const std::filesystem::path &root_file_name,
+         const std::filesystem::path &index_file_name);
   ~D3plot() noexcept;
 
+  // Look for states that have been written since opening or the last refresh.
+  // Returns the number of new states
+  size_t refresh();
+  // Write the layout of the files into an index file
+  void write_index(const std::filesystem::path &index_file_name);
+
   // Read all ids of the nodes
   Array<d3_word> read_node_ids();
   // Read all ids of the solid elements
@@ -64,19 +276,54 @@ public:
   Array<d3_word> read_solid_shell_element_ids();
   // Read all ids of the solid, beam, shell and solid shell elements
   Array<d3_word> read_all_element_ids();
+  // Same as read_all_element_ids, but also returns the type (D3PLT_ELEMENT_*)
+  // and the index inside the elements of that type of every id
+  Array<d3_word> read_all_element_ids_origin(Array<uint8_t> &element_types,
+                                             Array<size_t> &element_indices);
   // Read all ids of the parts
   Array<d3_word> read_part_ids();
   // Returns a vector containing all part titles as null terminated strings
   std::vector<String> read_part_titles();
 
+  // The following functions return the indices of node, element or part ids.
+  // Ids that do not exist are returned as D3PLT_INVALID_INDEX
+  Array<size_t> node_indices(const std::vector<d3_word> &ids);
+  Array<size_t> solid_indices(const std::vector<d3_word> &ids);
+  Array<size_t> thick_shell_indices(const std::vector<d3_word> &ids);
+  Array<size_t> beam_indices(const std::vector<d3_word> &ids);
+  Array<size_t> shell_indices(const std::vector<d3_word> &ids);
+  Array<size_t> part_indices(const std::vector<d3_word> &ids);
+
   // Read the node coordinates of all nodes of a given state (time step)
   Array<dVec3> read_node_coordinates(size_t state);
   // Read the node velocity of all nodes of a given state (time step)
   Array<dVec3> read_node_velocity(size_t state);
   // Read the node acceleration of all nodes of a given state (time step)
   Array<dVec3> read_node_acceleration(size_t state);
+  // Read the node coordinates before the first state (GEOMETRY DATA)
+  Array<dVec3> read_node_initial_coordinates();
+  // Read the displacement (coordinates minus initial coordinates) of all nodes
+  // of a given state (time step)
+  Array<dVec3> read_node_displacement(size_t state);
+  // Read the length of the displacement of all nodes of a given state
+  Array<double> read_node_displacement_magnitude(size_t state);
   // Read the time of a given state (time step) in milliseconds
   double read_time(size_t state);
+  // Returns the times of all states (time steps) in milliseconds
+  Array<double> read_times();
+  // Returns all NGLBV values of the GLOBAL block (see D3PLT_GLOBAL_*) of all
+  // states as a num_time_steps() * num_globals matrix
+  Array<double> read_global_history(size_t *num_globals = nullptr);
+  // Returns the values of every part out of the GLOBAL block of all states as
+  // D3PLT_PART_QUANTITY_COUNT matrices of num_time_steps() * num_parts values
+  // indexed by D3PLT_PART_*. The matrices of quantities whose bit (1 <<
+  // D3PLT_PART_*) is not set are empty
+  std::vector<Array<double>>
+  read_part_global_history(unsigned int quantities = D3PLT_PART_ALL,
+                           size_t *num_parts = nullptr);
+  // Returns the index of the last state (time step) whose time is less than or
+  // equal to time
+  size_t find_state(double time);
   // Returns stress, strain (if NEIPH >= 6) for a given state
   Array<d3plot_solid> read_solids_state(size_t state);
   // Returns stress, strain (if ISTRN == 1) for a given state
@@ -89,6 +336,176 @@ public:
   // pg. 36) of all shells for a given state
   Array<d3plot_shell> read_shells_state(size_t state);
 
+  // The following overloads work the same as the functions above, but write
+  // into dst. dst is only reallocated if it does not have the correct size, so
+  // that it can be reused for every state
+  void read_node_coordinates(size_t state, Array<dVec3> &dst);
+  void read_node_velocity(size_t state, Array<dVec3> &dst);
+  void read_node_acceleration(size_t state, Array<dVec3> &dst);
+  void read_node_displacement(size_t state, Array<dVec3> &dst);
+  // Also writes the length of every displacement into magnitudes
+  void read_node_displacement(size_t state, Array<dVec3> &dst,
+                              Array<double> &magnitudes);
+  void read_solids_state(size_t state, Array<d3plot_solid> &dst);
+  void read_thick_shells_state(size_t state, Array<d3plot_thick_shell> &dst);
+  void read_beams_state(size_t state, Array<d3plot_beam> &dst);
+  void read_shells_state(size_t state, Array<d3plot_shell> &dst);
+
+  // Returns the von Mises stress, the pressure or the three principal stresses
+  // (in descending order) of every element for a given state. They are
+  // computed directly from the stresses inside the files. surface
+  // (D3PLT_SURFACE_*) selects the integration point of shells and thick shells
+  Array<double> read_solids_von_mises(size_t state);
+  Array<double> read_solids_pressure(size_t state);
+  Array<dVec3> read_solids_principal_stresses(size_t state);
+  Array<double> read_thick_shells_von_mises(size_t state,
+                                            int surface = D3PLT_SURFACE_MID);
+  Array<double> read_thick_shells_pressure(size_t state,
+                                           int surface = D3PLT_SURFACE_MID);
+  Array<dVec3>
+  read_thick_shells_principal_stresses(size_t state,
+                                       int surface = D3PLT_SURFACE_MID);
+  Array<double> read_shells_von_mises(size_t state,
+                                      int surface = D3PLT_SURFACE_MID);
+  Array<double> read_shells_pressure(size_t state,
+                                     int surface = D3PLT_SURFACE_MID);
+  Array<dVec3> read_shells_principal_stresses(size_t state,
+                                              int surface = D3PLT_SURFACE_MID);
+
+  // Returns one flag per node that is 1 if the node is active and 0 if it has
+  // been deleted. Only available if MDLOPT == 1
+  Array<uint8_t> read_node_deletion(size_t state);
+  // Returns one flag per element that is 1 if the element is active and 0 if
+  // it has been deleted. Only available if MDLOPT == 2
+  Array<uint8_t> read_solids_deletion(size_t state);
+  Array<uint8_t> read_thick_shells_deletion(size_t state);
+  Array<uint8_t> read_beams_deletion(size_t state);
+  Array<uint8_t> read_shells_deletion(size_t state);
+  // Same as read_solids_state etc., but only return the active elements of a
+  // state. The indices of the returned elements are stored in element_indices.
+  // If MDLOPT != 2 all elements are returned
+  Array<d3plot_solid> read_solids_state_alive(size_t state,
+                                              Array<size_t> &element_indices);
+  Array<d3plot_thick_shell>
+  read_thick_shells_state_alive(size_t state, Array<size_t> &element_indices);
+  Array<d3plot_beam> read_beams_state_alive(size_t state,
+                                            Array<size_t> &element_indices);
+  Array<d3plot_shell> read_shells_state_alive(size_t state,
+                                              Array<size_t> &element_indices);
+
+  // Set the memory budget of the state cache in bytes. 0 disables the cache
+  void set_cache_size(size_t max_cache_size);
+  // The following functions return the same as the functions above, but keep
+  // the states inside the state cache, so that reading them again does not
+  // need to touch the files. The returned states are shared without copying
+  CachedState<dVec3> cached_node_coordinates(size_t state);
+  CachedState<dVec3> cached_node_velocity(size_t state);
+  CachedState<dVec3> cached_node_acceleration(size_t state);
+  CachedState<d3plot_solid> cached_solids_state(size_t state);
+  CachedState<d3plot_thick_shell> cached_thick_shells_state(size_t state);
+  CachedState<d3plot_beam> cached_beams_state(size_t state);
+  CachedState<d3plot_shell> cached_shells_state(size_t state);
+  CachedState<dVec3> cached_node_displacement(size_t state);
+
+  // Stream every state. fields selects which fields (1 << D3PLT_CACHE_*) are
+  // read. The buffers of the states are allocated once and the next state is
+  // read in the background while the current one is processed.
+  // Example: for (const auto state : plot_file.states()) { ... }
+  StateRange states(unsigned int fields = D3PLT_ITER_ALL);
+  // Reduce quantities (1 << D3PLT_ENVELOPE_*) to their largest and smallest
+  // value per node or element over all states in one pass. Returns
+  // D3PLT_ENVELOPE_QUANTITY_COUNT envelopes indexed by D3PLT_ENVELOPE_*, of
+  // which the ones that have not been selected are empty. The states are
+  // split between num_threads threads (0 uses one per core)
+  std::vector<Envelope>
+  read_envelopes(unsigned int quantities = D3PLT_ENVELOPE_ALL,
+                 int surface = D3PLT_SURFACE_MID, size_t num_threads = 0);
+  // Summarize quantities (1 << D3PLT_ZONE_*) by their smallest and largest
+  // value per part and state in one pass over all states
+  ZoneMap build_zone_map(unsigned int quantities = D3PLT_ZONE_ALL,
+                         int surface = D3PLT_SURFACE_MID);
+  // Load a zone map from a file. It is built and the file is (re)written if it
+  // does not exist, is outdated or does not hold all quantities at surface
+  ZoneMap open_zone_map(const std::filesystem::path &zone_map_file_name,
+                        unsigned int quantities = D3PLT_ZONE_ALL,
+                        int surface = D3PLT_SURFACE_MID);
+  // Write a zone map into a file which can be loaded by open_zone_map
+  void write_zone_map(const ZoneMap &zone_map,
+                      const std::filesystem::path &zone_map_file_name);
+
+  // The following functions work the same as their counterparts without _f32,
+  // but return single precision values
+  Array<fVec3> read_node_coordinates_f32(size_t state);
+  Array<fVec3> read_node_velocity_f32(size_t state);
+  Array<fVec3> read_node_acceleration_f32(size_t state);
+  Array<d3plot_solid_f32> read_solids_state_f32(size_t state);
+  Array<d3plot_shell_f32> read_shells_state_f32(size_t state);
+
+  // The following functions work the same as their counterparts without
+  // _fields, but only read the values selected by fields (D3PLT_FIELD_*). The
+  // values of an element are stored in the order of the element struct. If
+  // num_values is not nullptr it is set to the number of values per element
+  Array<double> read_solids_state_fields(size_t state, unsigned int fields,
+                                         size_t *num_values = nullptr);
+  Array<double> read_thick_shells_state_fields(size_t state,
+                                               unsigned int fields,
+                                               size_t *num_values = nullptr);
+  Array<double> read_shells_state_fields(size_t state, unsigned int fields,
+                                         size_t *num_values = nullptr);
+
+  // The following functions work the same as their counterparts without _soa,
+  // but return every component in its own array. The node functions return
+  // the x, y and z arrays and the element functions one array per value of the
+  // element struct (see D3PLT_COMPONENT)
+  std::vector<Array<double>> read_node_coordinates_soa(size_t state);
+  std::vector<Array<double>> read_node_velocity_soa(size_t state);
+  std::vector<Array<double>> read_node_acceleration_soa(size_t state);
+  std::vector<Array<double>> read_solids_state_soa(size_t state);
+  std::vector<Array<double>> read_thick_shells_state_soa(size_t state);
+  std::vector<Array<double>> read_beams_state_soa(size_t state);
+  std::vector<Array<double>> read_shells_state_soa(size_t state);
+
+  // Read the node coordinates, velocity or acceleration of the nodes at
+  // node_indices over all states. Returns num_time_steps() * node_indices.size()
+  // values, in which the values of a state are stored in the order of
+  // node_indices
+  Array<dVec3>
+  read_node_coordinates_history(const std::vector<size_t> &node_indices);
+  Array<dVec3>
+  read_node_velocity_history(const std::vector<size_t> &node_indices);
+  Array<dVec3>
+  read_node_acceleration_history(const std::vector<size_t> &node_indices);
+
+  // The following functions read the values of the elements at
+  // element_indices over all states. fields selects the values (see the
+  // _fields functions). Returns num_time_steps() * element_indices.size() *
+  // num_values values, in which the elements of a state are stored in the
+  // order of element_indices
+  Array<double>
+  read_solids_history(const std::vector<size_t> &element_indices,
+                      unsigned int fields = D3PLT_FIELD_ALL,
+                      size_t *num_values = nullptr);
+  Array<double>
+  read_thick_shells_history(const std::vector<size_t> &element_indices,
+                            unsigned int fields = D3PLT_FIELD_ALL,
+                            size_t *num_values = nullptr);
+  Array<d3plot_beam>
+  read_beams_history(const std::vector<size_t> &element_indices);
+  Array<double>
+  read_shells_history(const std::vector<size_t> &element_indices,
+                      unsigned int fields = D3PLT_FIELD_ALL,
+                      size_t *num_values = nullptr);
+
+  // The following functions read the two states around time (in milliseconds)
+  // and interpolate linearly between them
+  Array<dVec3> read_node_coordinates_at_time(double time);
+  Array<dVec3> read_node_velocity_at_time(double time);
+  Array<dVec3> read_node_acceleration_at_time(double time);
+  Array<d3plot_solid> read_solids_state_at_time(double time);
+  Array<d3plot_thick_shell> read_thick_shells_state_at_time(double time);
+  Array<d3plot_beam> read_beams_state_at_time(double time);
+  Array<d3plot_shell> read_shells_state_at_time(double time);
+
   // Returns the node connectivity + material number of all 8 node solid
   // elements
   Array<d3plot_solid_con> read_solid_elements();
@@ -108,6 +525,8 @@ public:
   // Returns all elements of a part. The part_index can retrieved by iterating
   // over the array returned by read_part_ids
   D3plotPart read_part(size_t part_index);
+  // Returns the states of all elements of a part at a given state
+  D3plotPartState read_part_state(size_t part_index, size_t state);
 
   // Returns the number of states (time steps)
   inline size_t num_time_steps() const { return m_handle.num_states; }
@@ -116,6 +535,27 @@ public:
   inline const d3plot_file &get_handle() const { return m_handle; }
 
 private:
+  // Allocate num_values arrays of num_elements values and fill them using
+  // read_func
+  std::vector<Array<double>>
+  read_soa(size_t state, size_t num_elements, size_t num_values,
+           int (*read_func)(d3plot_file *, size_t, double **));
+
+  // Reallocate dst if it does not hold num_values values and fill it using
+  // read_func
+  template <typename T, typename U>
+  void read_into(size_t state, Array<T> &dst, size_t num_values,
+                 int (*read_func)(d3plot_file *, size_t, U *));
+
+  // Get a field (D3PLT_CACHE_*) of a state from the state cache
+  d3plot_cached_state *cache_get(size_t state, int field);
+
+  // Look up the indices of ids using lookup_func
+  Array<size_t> lookup_indices(const std::vector<d3_word> &ids,
+                               size_t (*lookup_func)(d3plot_file *,
+                                                     const d3_word *, size_t,
+                                                     size_t *));
+
   // The underlying C handle of the d3plot file
   d3plot_file m_handle;
 };
@@ -46,4 +46,13 @@ private:
   d3plot_part m_part;
 };
 
+// The element states of a single part. The elements are stored in the same
+// order as the ids of D3plotPart
+struct D3plotPartState {
+  Array<d3plot_solid> solids;
+  Array<d3plot_thick_shell> thick_shells;
+  Array<d3plot_beam> beams;
+  Array<d3plot_shell> shells;
+};
+
 } // namespace dro
@@ -43,6 +43,7 @@ d3_buffer d3_buffer_open(const char *root_file_name) {
   buffer.file_handles = NULL;
   buffer.file_sizes = NULL;
   buffer.error_string = NULL;
+  buffer.root_file_name = NULL;
 
   /* Store number 01 through 999*/
   char numbers[3];
@@ -98,6 +99,9 @@ d3_buffer d3_buffer_open(const char *root_file_name) {
 
   free(file_name_buffer);
 
+  buffer.root_file_name = malloc(root_len + 1);
+  memcpy(buffer.root_file_name, root_file_name, root_len + 1);
+
   if (buffer.num_file_handles == 0) {
     buffer.error_string = malloc(32 + root_len + 1);
     sprintf(buffer.error_string, "No files with the name %s do exist",
@@ -135,6 +139,86 @@ d3_buffer d3_buffer_open(const char *root_file_name) {
   return buffer;
 }
 
+int d3_buffer_refresh(d3_buffer *buffer) {
+  const size_t root_len = strlen(buffer->root_file_name);
+  /* Store the root name + numbers + '\0'*/
+  char *file_name_buffer = malloc(root_len + 3 + 1);
+  memcpy(file_name_buffer, buffer->root_file_name, root_len);
+  file_name_buffer[root_len] = '\0';
+
+  /* The files that are already open could still be written to*/
+  size_t i = 0;
+  while (i < buffer->num_file_handles) {
+    FILE *file = buffer->file_handles[i];
+    const long cur_file_pos = ftell(file);
+    long file_size = -1;
+    if (cur_file_pos >= 0 && fseek(file, 0, SEEK_END) == 0) {
+      file_size = ftell(file);
+    }
+    if (file_size < 0 || fseek(file, cur_file_pos, SEEK_SET) != 0) {
+      const char *error_string = strerror(errno);
+      /* The root file does not have a number*/
+      if (i != 0) {
+        sprintf(&file_name_buffer[root_len], i < 10 ? "%02d" : "%d", (int)i);
+      }
+      buffer->error_string =
+          malloc(root_len + 3 + 2 + strlen(error_string) + 1);
+      sprintf(buffer->error_string, "%s: %s", file_name_buffer, error_string);
+      free(file_name_buffer);
+      return 0;
+    }
+    buffer->file_sizes[i] = file_size;
+
+    i++;
+  }
+
+  while (i < 1000) {
+    sprintf(&file_name_buffer[root_len], i < 10 ? "%02d" : "%d", (int)i);
+    if (access(file_name_buffer, F_OK) != 0) {
+      break;
+    }
+
+    FILE *file = fopen(file_name_buffer, "rb");
+    if (!file) {
+      const char *error_string = strerror(errno);
+      buffer->error_string =
+          malloc(root_len + 3 + 2 + strlen(error_string) + 1);
+      sprintf(buffer->error_string, "%s: %s", file_name_buffer, error_string);
+      free(file_name_buffer);
+      return 0;
+    }
+
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+      file_size = ftell(file);
+    }
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+      const char *error_string = strerror(errno);
+      buffer->error_string =
+          malloc(root_len + 3 + 2 + strlen(error_string) + 1);
+      sprintf(buffer->error_string, "%s: %s", file_name_buffer, error_string);
+      fclose(file);
+      free(file_name_buffer);
+      return 0;
+    }
+
+    buffer->num_file_handles++;
+    buffer->file_handles = realloc(buffer->file_handles,
+                                   buffer->num_file_handles * sizeof(FILE *));
+    buffer->file_handles[buffer->num_file_handles - 1] = file;
+
+    buffer->file_sizes =
+        realloc(buffer->file_sizes, buffer->num_file_handles * sizeof(size_t));
+    buffer->file_sizes[buffer->num_file_handles - 1] = file_size;
+
+    i++;
+  }
+
+  free(file_name_buffer);
+
+  return 1;
+}
+
 void d3_buffer_close(d3_buffer *buffer) {
   /* Close all files*/
   buffer->cur_file_handle = 0;
@@ -145,11 +229,13 @@ void d3_buffer_close(d3_buffer *buffer) {
   free(buffer->file_handles);
   free(buffer->file_sizes);
   free(buffer->error_string);
+  free(buffer->root_file_name);
 
   /* Set everything to NULL so that access after close does not crash*/
   buffer->file_handles = NULL;
   buffer->file_sizes = NULL;
   buffer->error_string = NULL;
+  buffer->root_file_name = NULL;
   buffer->num_file_handles = 0;
   buffer->cur_word = 0;
 }
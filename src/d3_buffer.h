@@ -35,6 +35,8 @@ typedef struct {
   size_t num_file_handles;
   size_t cur_file_handle;
   size_t cur_word;
+  /* Needed to find files that have been added to the family after opening*/
+  char *root_file_name;
 
   uint8_t word_size; /* 4 byte for single precision and 8 byte for double
                         precision*/
@@ -48,6 +50,9 @@ extern "C" {
 /* Opens all d3plot files that belong to this root_file_name and also detects
  * the word_size*/
 d3_buffer d3_buffer_open(const char *root_file_name);
+/* Update the sizes of all files and open all files that have been added to the
+ * family since d3_buffer_open. Returns 0 on failure and sets error_string*/
+int d3_buffer_refresh(d3_buffer *buffer);
 /* Cleans everything up. Should be called sometime after d3_buffer_open*/
 void d3_buffer_close(d3_buffer *buffer);
 /* Read a given number of words from the current position. words already needs
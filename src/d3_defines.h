@@ -25,6 +25,7 @@
 
 #ifndef D3_DEFINES_H
 #define D3_DEFINES_H
+#include <stddef.h>
 #include <stdint.h>
 #ifdef __cplusplus
 #include <array>
@@ -160,6 +161,83 @@ typedef struct {
   double internal_energy;
 } d3plot_shell;
 
+/* The element states of a single part. The elements are stored in the same
+ * order as the ids of d3plot_part*/
+typedef struct {
+  d3plot_solid *solids;
+  d3plot_thick_shell *thick_shells;
+  d3plot_beam *beams;
+  d3plot_shell *shells;
+
+  size_t num_solids;
+  size_t num_thick_shells;
+  size_t num_beams;
+  size_t num_shells;
+} d3plot_part_state;
+
+/* Single precision versions of the structs above. They are returned by the
+ * _f32 functions*/
+typedef struct {
+  float x;
+  float y;
+  float z;
+  union {
+    float xy;
+    float yx;
+  };
+  union {
+    float yz;
+    float zy;
+  };
+  union {
+    float zx;
+    float xz;
+  };
+} d3plot_tensor_f32;
+
+typedef struct {
+  union {
+    d3plot_tensor_f32 sigma;
+    d3plot_tensor_f32 stress;
+  };
+  union {
+    float effective_plastic_strain;
+    float material_dependent_value;
+  };
+  float extra1;
+  float extra2;
+  union {
+    d3plot_tensor_f32 epsilon;
+    d3plot_tensor_f32 strain;
+  };
+} d3plot_solid_f32;
+
+typedef struct {
+  union {
+    d3plot_tensor_f32 sigma;
+    d3plot_tensor_f32 stress;
+  };
+  union {
+    float effective_plastic_strain;
+    float material_dependent_value;
+  };
+} d3plot_surface_f32;
+
+typedef struct {
+  d3plot_surface_f32 mid;
+  d3plot_surface_f32 inner;
+  d3plot_surface_f32 outer;
+  union {
+    d3plot_tensor_f32 inner_epsilon;
+    d3plot_tensor_f32 inner_strain;
+  };
+  union {
+    d3plot_tensor_f32 outer_epsilon;
+    d3plot_tensor_f32 outer_strain;
+  };
+  float internal_energy;
+} d3plot_shell_f32;
+
 #define D3_FILE_TYPE_D3PLOT 1
 #define D3_FILE_TYPE_D3DRLF 2
 #define D3_FILE_TYPE_D3THDT 3
@@ -208,4 +286,93 @@ typedef struct {
 #define D3PLT_PTR_STATES (D3PLT_PTR_STATE_ELEMENT_SHELL + 1)
 #define D3PLT_PTR_COUNT D3PLT_PTR_STATES
 
+/* The element types*/
+#define D3PLT_ELEMENT_SOLID 0
+#define D3PLT_ELEMENT_THICK_SHELL 1
+#define D3PLT_ELEMENT_BEAM 2
+#define D3PLT_ELEMENT_SHELL 3
+#define D3PLT_ELEMENT_TYPE_COUNT 4
+
+/* Returned by the id lookups for ids that do not exist*/
+#define D3PLT_INVALID_INDEX ((size_t)-1)
+
+/* Used by value maps for values that are not inside the files*/
+#define D3PLT_NO_VALUE ((size_t)-1)
+
+/* Field masks of the _fields functions. They select which values of the
+ * element state structs are read*/
+#define D3PLT_FIELD_STRESS (1 << 0)
+#define D3PLT_FIELD_EFFECTIVE_PLASTIC_STRAIN (1 << 1)
+/* extra1 and extra2 of d3plot_solid*/
+#define D3PLT_FIELD_EXTRA (1 << 2)
+#define D3PLT_FIELD_STRAIN (1 << 3)
+#define D3PLT_FIELD_INTERNAL_ENERGY (1 << 4)
+#define D3PLT_FIELD_ALL 0x1F
+
+/* The indices of the first values of the GLOBAL block of a state (see
+ * d3plot_read_global_history). They are followed by the internal energy,
+ * kinetic energy, X, Y and Z velocity, mass and force of every material and
+ * the forces of the rigid walls*/
+#define D3PLT_GLOBAL_KINETIC_ENERGY 0
+#define D3PLT_GLOBAL_INTERNAL_ENERGY 1
+#define D3PLT_GLOBAL_TOTAL_ENERGY 2
+#define D3PLT_GLOBAL_VELOCITY_X 3
+#define D3PLT_GLOBAL_VELOCITY_Y 4
+#define D3PLT_GLOBAL_VELOCITY_Z 5
+
+/* The values of every part inside the GLOBAL block of a state (see
+ * d3plot_read_part_global_history). The bits of quantities are
+ * (1 << D3PLT_PART_*)*/
+#define D3PLT_PART_INTERNAL_ENERGY 0
+#define D3PLT_PART_KINETIC_ENERGY 1
+#define D3PLT_PART_VELOCITY_X 2
+#define D3PLT_PART_VELOCITY_Y 3
+#define D3PLT_PART_VELOCITY_Z 4
+#define D3PLT_PART_MASS 5
+#define D3PLT_PART_FORCE 6
+#define D3PLT_PART_QUANTITY_COUNT 7
+#define D3PLT_PART_ALL ((1 << D3PLT_PART_QUANTITY_COUNT) - 1)
+
+/* The surfaces of shells and thick shells*/
+#define D3PLT_SURFACE_MID 0
+#define D3PLT_SURFACE_INNER 1
+#define D3PLT_SURFACE_OUTER 2
+
+/* The quantities that can be derived from the stress tensors of elements*/
+#define D3PLT_STRESS_VON_MISES 0
+#define D3PLT_STRESS_PRESSURE 1
+/* Three values per element in descending order*/
+#define D3PLT_STRESS_PRINCIPAL 2
+
+/* The quantities of d3plot_read_envelopes. The bits of quantities are
+ * (1 << D3PLT_ENVELOPE_*). The displacement is reduced by its length and the
+ * element quantities by the values of one surface*/
+#define D3PLT_ENVELOPE_NODE_DISPLACEMENT 0
+#define D3PLT_ENVELOPE_SOLID_VON_MISES 1
+#define D3PLT_ENVELOPE_SOLID_PLASTIC_STRAIN 2
+#define D3PLT_ENVELOPE_THICK_SHELL_VON_MISES 3
+#define D3PLT_ENVELOPE_THICK_SHELL_PLASTIC_STRAIN 4
+#define D3PLT_ENVELOPE_SHELL_VON_MISES 5
+#define D3PLT_ENVELOPE_SHELL_PLASTIC_STRAIN 6
+#define D3PLT_ENVELOPE_QUANTITY_COUNT 7
+#define D3PLT_ENVELOPE_ALL ((1 << D3PLT_ENVELOPE_QUANTITY_COUNT) - 1)
+
+/* The quantities of d3plot_build_zone_map. The bits of quantities are
+ * (1 << D3PLT_ZONE_*). The node quantities of a part are summarized over the
+ * nodes of its elements, the velocity by its length and the element quantities
+ * by the values of solids and of one surface of shells and thick shells*/
+#define D3PLT_ZONE_COORDINATE_X 0
+#define D3PLT_ZONE_COORDINATE_Y 1
+#define D3PLT_ZONE_COORDINATE_Z 2
+#define D3PLT_ZONE_VELOCITY 3
+#define D3PLT_ZONE_PLASTIC_STRAIN 4
+#define D3PLT_ZONE_VON_MISES 5
+#define D3PLT_ZONE_QUANTITY_COUNT 6
+#define D3PLT_ZONE_ALL ((1 << D3PLT_ZONE_QUANTITY_COUNT) - 1)
+
+/* The index of a value inside of an element state struct. Used to index the
+ * component arrays of the _soa functions.
+ * Example: D3PLT_COMPONENT(d3plot_solid, sigma.x)*/
+#define D3PLT_COMPONENT(type, member) (offsetof(type, member) / sizeof(double))
+
 #endif
\ No newline at end of file
@@ -0,0 +1,1393 @@
+/***********************************************************************************
+ *                         This file is part of dynareadout
+ *                    https://github.com/PucklaMotzer09/dynareadout
+ ***********************************************************************************
+ * Copyright (c) 2022 PucklaMotzer09
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ * that you wrote the original software. If you use this software in a product,
+ * an acknowledgment in the product documentation would be appreciated but is
+ * not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ ************************************************************************************/
+
+#include "d3_kernels.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) ||            \
+    defined(_M_IX86)
+#define D3_KERNELS_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+/* MSVC allows all intrinsics without enabling the instruction set*/
+#define D3_TARGET(isa)
+#else
+#define D3_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
+/* The maximum number of chunks of the SIMD versions of the run kernels*/
+#define D3_KERNELS_MAX_CHUNKS 64
+/* The largest stride for which 16 gather indices still fit into an int*/
+#define D3_KERNELS_MAX_GATHER_STRIDE (0x7FFFFFFF / 16)
+
+/* -1 means that the instruction set has not been detected yet*/
+static int _d3_kernels_isa = -1;
+static int _d3_kernels_supported_isa = -1;
+
+/***** Scalar *****/
+
+static void _d3_widen_f32_scalar(double *dst, const float *src,
+                                 size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+static void _d3_widen_u32_scalar(uint64_t *dst, const uint32_t *src,
+                                 size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+static void _d3_narrow_f64_scalar(float *dst, const double *src,
+                                  size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    dst[i] = (float)src[i];
+    i++;
+  }
+}
+
+static void _d3_widen_f32_runs_scalar(double *dst, size_t dst_stride,
+                                      const float *src, size_t src_stride,
+                                      size_t num_elements, const size_t *runs,
+                                      size_t num_runs) {
+  size_t i = 0;
+  while (i < num_elements) {
+    size_t r = 0;
+    while (r < num_runs) {
+      const size_t *run = &runs[r * 3];
+      if (run[1] == D3_KERNELS_ZERO_RUN) {
+        memset(&dst[run[0]], 0, run[2] * sizeof(double));
+      } else {
+        _d3_widen_f32_scalar(&dst[run[0]], &src[run[1]], run[2]);
+      }
+      r++;
+    }
+
+    dst += dst_stride;
+    src += src_stride;
+    i++;
+  }
+}
+
+static void _d3_widen_f32_gather_scalar(double *dst, const float *src,
+                                        size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    dst[i] = src[i * src_stride];
+    i++;
+  }
+}
+
+static void _d3_copy_f64_gather_scalar(double *dst, const double *src,
+                                       size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    dst[i] = src[i * src_stride];
+    i++;
+  }
+}
+
+/* The von Mises stress and the pressure of a stress tensor*/
+#define D3_VON_MISES(x, y, z, xy, yz, zx)                                      \
+  sqrt(0.5 * (((x) - (y)) * ((x) - (y)) + ((y) - (z)) * ((y) - (z)) +          \
+              ((z) - (x)) * ((z) - (x))) +                                     \
+       3.0 * ((xy) * (xy) + (yz) * (yz) + (zx) * (zx)))
+#define D3_PRESSURE(x, y, z) (-((x) + (y) + (z)) / 3.0)
+
+static void _d3_von_mises_f32_scalar(double *dst, const float *src,
+                                     size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    const float *t = &src[i * src_stride];
+    const double x = t[0], y = t[1], z = t[2], xy = t[3], yz = t[4],
+                 zx = t[5];
+    dst[i] = D3_VON_MISES(x, y, z, xy, yz, zx);
+    i++;
+  }
+}
+
+static void _d3_von_mises_f64_scalar(double *dst, const double *src,
+                                     size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    const double *t = &src[i * src_stride];
+    dst[i] = D3_VON_MISES(t[0], t[1], t[2], t[3], t[4], t[5]);
+    i++;
+  }
+}
+
+static void _d3_pressure_f32_scalar(double *dst, const float *src,
+                                    size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    const float *t = &src[i * src_stride];
+    const double x = t[0], y = t[1], z = t[2];
+    dst[i] = D3_PRESSURE(x, y, z);
+    i++;
+  }
+}
+
+static void _d3_pressure_f64_scalar(double *dst, const double *src,
+                                    size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    const double *t = &src[i * src_stride];
+    dst[i] = D3_PRESSURE(t[0], t[1], t[2]);
+    i++;
+  }
+}
+
+/* Computes the eigenvalues of a symmetric 3x3 matrix analytically (Smith,
+ * 1961) and stores them in descending order*/
+static void _d3_principal(double *dst, double x, double y, double z,
+                          double xy, double yz, double zx) {
+  const double off = xy * xy + yz * yz + zx * zx;
+  const double q = (x + y + z) / 3.0;
+  const double dx = x - q, dy = y - q, dz = z - q;
+  const double p = sqrt((dx * dx + dy * dy + dz * dz + 2.0 * off) / 6.0);
+  if (off == 0.0 || p == 0.0) {
+    /* The tensor is already diagonal*/
+    double a = x > y ? x : y;
+    double c = x > y ? y : x;
+    double b;
+    if (z > a) {
+      b = a;
+      a = z;
+    } else if (z < c) {
+      b = c;
+      c = z;
+    } else {
+      b = z;
+    }
+    dst[0] = a;
+    dst[1] = b;
+    dst[2] = c;
+    return;
+  }
+
+  /* r = det((A - qI) / p) / 2*/
+  double r = (dx * (dy * dz - yz * yz) - xy * (xy * dz - yz * zx) +
+              zx * (xy * yz - dy * zx)) /
+             (2.0 * p * p * p);
+  if (r < -1.0) {
+    r = -1.0;
+  } else if (r > 1.0) {
+    r = 1.0;
+  }
+
+  const double phi = acos(r) / 3.0;
+  dst[0] = q + 2.0 * p * cos(phi);
+  dst[2] = q + 2.0 * p * cos(phi + 2.0943951023931954923);
+  dst[1] = 3.0 * q - dst[0] - dst[2];
+}
+
+static void _d3_principal_f32_scalar(double *dst, const float *src,
+                                     size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    const float *t = &src[i * src_stride];
+    _d3_principal(&dst[i * 3], t[0], t[1], t[2], t[3], t[4], t[5]);
+    i++;
+  }
+}
+
+static void _d3_principal_f64_scalar(double *dst, const double *src,
+                                     size_t src_stride, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    const double *t = &src[i * src_stride];
+    _d3_principal(&dst[i * 3], t[0], t[1], t[2], t[3], t[4], t[5]);
+    i++;
+  }
+}
+
+/* Subtracts ref from the nodes and computes the length of the result. All
+ * values of a node are read before they are written, so that this also works
+ * in place*/
+#define D3_DISPLACEMENT(dst, magnitudes, src, ref, i)                          \
+  {                                                                            \
+    const double x = (double)(src)[(i)*3] - (ref)[(i)*3],                      \
+                 y = (double)(src)[(i)*3 + 1] - (ref)[(i)*3 + 1],              \
+                 z = (double)(src)[(i)*3 + 2] - (ref)[(i)*3 + 2];              \
+    (dst)[(i)*3] = x;                                                          \
+    (dst)[(i)*3 + 1] = y;                                                      \
+    (dst)[(i)*3 + 2] = z;                                                      \
+    if (magnitudes) {                                                          \
+      (magnitudes)[i] = sqrt(x * x + y * y + z * z);                           \
+    }                                                                          \
+  }
+
+static void _d3_displacement_f32_scalar(double *dst, double *magnitudes,
+                                        const float *src, const double *ref,
+                                        size_t num_nodes) {
+  size_t i = 0;
+  while (i < num_nodes) {
+    D3_DISPLACEMENT(dst, magnitudes, src, ref, i);
+    i++;
+  }
+}
+
+static void _d3_displacement_f64_scalar(double *dst, double *magnitudes,
+                                        const double *src, const double *ref,
+                                        size_t num_nodes) {
+  size_t i = 0;
+  while (i < num_nodes) {
+    D3_DISPLACEMENT(dst, magnitudes, src, ref, i);
+    i++;
+  }
+}
+
+static void _d3_envelope_scalar(double *max, double *min, size_t *max_state,
+                                size_t *min_state, const double *values,
+                                size_t state, size_t num_values) {
+  size_t i = 0;
+  while (i < num_values) {
+    if (values[i] > max[i]) {
+      max[i] = values[i];
+      max_state[i] = state;
+    }
+    if (values[i] < min[i]) {
+      min[i] = values[i];
+      min_state[i] = state;
+    }
+    i++;
+  }
+}
+
+#ifdef D3_KERNELS_X86
+
+/***** SSE2 *****/
+
+D3_TARGET("sse2")
+static void _d3_widen_f32_sse2(double *dst, const float *src,
+                               size_t num_values) {
+  size_t i = 0;
+  while (i + 4 <= num_values) {
+    const __m128 v = _mm_loadu_ps(&src[i]);
+    _mm_storeu_pd(&dst[i], _mm_cvtps_pd(v));
+    _mm_storeu_pd(&dst[i + 2], _mm_cvtps_pd(_mm_movehl_ps(v, v)));
+    i += 4;
+  }
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+D3_TARGET("sse2")
+static void _d3_widen_u32_sse2(uint64_t *dst, const uint32_t *src,
+                               size_t num_values) {
+  const __m128i zero = _mm_setzero_si128();
+  size_t i = 0;
+  while (i + 4 <= num_values) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)&src[i]);
+    _mm_storeu_si128((__m128i *)&dst[i], _mm_unpacklo_epi32(v, zero));
+    _mm_storeu_si128((__m128i *)&dst[i + 2], _mm_unpackhi_epi32(v, zero));
+    i += 4;
+  }
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+D3_TARGET("sse2")
+static void _d3_narrow_f64_sse2(float *dst, const double *src,
+                                size_t num_values) {
+  size_t i = 0;
+  while (i + 4 <= num_values) {
+    const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(&src[i]));
+    const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(&src[i + 2]));
+    _mm_storeu_ps(&dst[i], _mm_movelh_ps(lo, hi));
+    i += 4;
+  }
+  while (i < num_values) {
+    dst[i] = (float)src[i];
+    i++;
+  }
+}
+
+D3_TARGET("sse2")
+static void _d3_widen_f32_runs_sse2(double *dst, size_t dst_stride,
+                                    const float *src, size_t src_stride,
+                                    size_t num_elements, const size_t *runs,
+                                    size_t num_runs) {
+  size_t i = 0;
+  while (i < num_elements) {
+    size_t r = 0;
+    while (r < num_runs) {
+      const size_t *run = &runs[r * 3];
+      if (run[1] == D3_KERNELS_ZERO_RUN) {
+        memset(&dst[run[0]], 0, run[2] * sizeof(double));
+      } else {
+        _d3_widen_f32_sse2(&dst[run[0]], &src[run[1]], run[2]);
+      }
+      r++;
+    }
+
+    dst += dst_stride;
+    src += src_stride;
+    i++;
+  }
+}
+
+/***** AVX2 *****/
+
+D3_TARGET("avx2")
+static void _d3_widen_f32_avx2(double *dst, const float *src,
+                               size_t num_values) {
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    const __m128 lo = _mm_loadu_ps(&src[i]);
+    const __m128 hi = _mm_loadu_ps(&src[i + 4]);
+    _mm256_storeu_pd(&dst[i], _mm256_cvtps_pd(lo));
+    _mm256_storeu_pd(&dst[i + 4], _mm256_cvtps_pd(hi));
+    i += 8;
+  }
+  if (i + 4 <= num_values) {
+    _mm256_storeu_pd(&dst[i], _mm256_cvtps_pd(_mm_loadu_ps(&src[i])));
+    i += 4;
+  }
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+D3_TARGET("avx2")
+static void _d3_widen_u32_avx2(uint64_t *dst, const uint32_t *src,
+                               size_t num_values) {
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    const __m128i lo = _mm_loadu_si128((const __m128i *)&src[i]);
+    const __m128i hi = _mm_loadu_si128((const __m128i *)&src[i + 4]);
+    _mm256_storeu_si256((__m256i *)&dst[i], _mm256_cvtepu32_epi64(lo));
+    _mm256_storeu_si256((__m256i *)&dst[i + 4], _mm256_cvtepu32_epi64(hi));
+    i += 8;
+  }
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+D3_TARGET("avx2")
+static void _d3_narrow_f64_avx2(float *dst, const double *src,
+                                size_t num_values) {
+  size_t i = 0;
+  while (i + 4 <= num_values) {
+    _mm_storeu_ps(&dst[i], _mm256_cvtpd_ps(_mm256_loadu_pd(&src[i])));
+    i += 4;
+  }
+  while (i < num_values) {
+    dst[i] = (float)src[i];
+    i++;
+  }
+}
+
+/* Elements are usually only a few values wide. So the runs are split into
+ * chunks of at most 8 values which are converted with one masked load and two
+ * masked stores*/
+D3_TARGET("avx2")
+static void _d3_widen_f32_runs_avx2(double *dst, size_t dst_stride,
+                                    const float *src, size_t src_stride,
+                                    size_t num_elements, const size_t *runs,
+                                    size_t num_runs) {
+  size_t chunk_dst[D3_KERNELS_MAX_CHUNKS];
+  size_t chunk_src[D3_KERNELS_MAX_CHUNKS];
+  __m256i load_masks[D3_KERNELS_MAX_CHUNKS];
+  __m256i store_masks[D3_KERNELS_MAX_CHUNKS * 2];
+  const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  size_t num_chunks = 0;
+
+  size_t r = 0;
+  while (r < num_runs) {
+    size_t j = 0;
+    while (j < runs[r * 3 + 2]) {
+      if (num_chunks == D3_KERNELS_MAX_CHUNKS) {
+        _d3_widen_f32_runs_scalar(dst, dst_stride, src, src_stride,
+                                  num_elements, runs, num_runs);
+        return;
+      }
+
+      const size_t len = runs[r * 3 + 2] - j < 8 ? runs[r * 3 + 2] - j : 8;
+      const __m256i mask =
+          _mm256_cmpgt_epi32(_mm256_set1_epi32((int)len), lanes);
+      chunk_dst[num_chunks] = runs[r * 3 + 0] + j;
+      chunk_src[num_chunks] = runs[r * 3 + 1] == D3_KERNELS_ZERO_RUN
+                                  ? D3_KERNELS_ZERO_RUN
+                                  : runs[r * 3 + 1] + j;
+      load_masks[num_chunks] = mask;
+      store_masks[num_chunks * 2 + 0] =
+          _mm256_cvtepi32_epi64(_mm256_castsi256_si128(mask));
+      store_masks[num_chunks * 2 + 1] =
+          _mm256_cvtepi32_epi64(_mm256_extracti128_si256(mask, 1));
+      num_chunks++;
+      j += len;
+    }
+    r++;
+  }
+
+  const __m256 zero = _mm256_setzero_ps();
+  size_t i = 0;
+  while (i < num_elements) {
+    size_t c = 0;
+    while (c < num_chunks) {
+      const __m256 v =
+          chunk_src[c] == D3_KERNELS_ZERO_RUN
+              ? zero
+              : _mm256_maskload_ps(&src[chunk_src[c]], load_masks[c]);
+      _mm256_maskstore_pd(&dst[chunk_dst[c]], store_masks[c * 2 + 0],
+                          _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+      _mm256_maskstore_pd(&dst[chunk_dst[c] + 4], store_masks[c * 2 + 1],
+                          _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+      c++;
+    }
+
+    dst += dst_stride;
+    src += src_stride;
+    i++;
+  }
+}
+
+D3_TARGET("avx2")
+static void _d3_widen_f32_gather_avx2(double *dst, const float *src,
+                                      size_t src_stride, size_t num_values) {
+  const int stride = (int)src_stride;
+  const __m256i indices = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    const __m256 v = _mm256_i32gather_ps(&src[i * src_stride], indices, 4);
+    _mm256_storeu_pd(&dst[i], _mm256_cvtps_pd(_mm256_castps256_ps128(v)));
+    _mm256_storeu_pd(&dst[i + 4], _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)));
+    i += 8;
+  }
+  _d3_widen_f32_gather_scalar(&dst[i], &src[i * src_stride], src_stride,
+                              num_values - i);
+}
+
+D3_TARGET("avx2")
+static void _d3_copy_f64_gather_avx2(double *dst, const double *src,
+                                     size_t src_stride, size_t num_values) {
+  const int stride = (int)src_stride;
+  const __m128i indices = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3),
+                                          _mm_set1_epi32(stride));
+  size_t i = 0;
+  while (i + 4 <= num_values) {
+    _mm256_storeu_pd(&dst[i],
+                     _mm256_i32gather_pd(&src[i * src_stride], indices, 8));
+    i += 4;
+  }
+  _d3_copy_f64_gather_scalar(&dst[i], &src[i * src_stride], src_stride,
+                             num_values - i);
+}
+
+/* Computes the von Mises stress (or the pressure) of four tensors*/
+D3_TARGET("avx2")
+static __m256d _d3_stress_avx2(__m256d x, __m256d y, __m256d z, __m256d xy,
+                               __m256d yz, __m256d zx, int pressure) {
+  if (pressure) {
+    return _mm256_mul_pd(_mm256_add_pd(_mm256_add_pd(x, y), z),
+                         _mm256_set1_pd(-1.0 / 3.0));
+  }
+
+  const __m256d dxy = _mm256_sub_pd(x, y);
+  const __m256d dyz = _mm256_sub_pd(y, z);
+  const __m256d dzx = _mm256_sub_pd(z, x);
+  const __m256d normal = _mm256_add_pd(
+      _mm256_add_pd(_mm256_mul_pd(dxy, dxy), _mm256_mul_pd(dyz, dyz)),
+      _mm256_mul_pd(dzx, dzx));
+  const __m256d shear = _mm256_add_pd(
+      _mm256_add_pd(_mm256_mul_pd(xy, xy), _mm256_mul_pd(yz, yz)),
+      _mm256_mul_pd(zx, zx));
+  return _mm256_sqrt_pd(
+      _mm256_add_pd(_mm256_mul_pd(_mm256_set1_pd(0.5), normal),
+                    _mm256_mul_pd(_mm256_set1_pd(3.0), shear)));
+}
+
+D3_TARGET("avx2")
+static void _d3_stress_f32_avx2(double *dst, const float *src,
+                                size_t src_stride, size_t num_values,
+                                int pressure) {
+  const int stride = (int)src_stride;
+  const __m256i indices = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+  /* Pressure only needs the normal components*/
+  const int num_components = pressure ? 3 : 6;
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    __m256d lo[6], hi[6];
+    int c = 0;
+    while (c < num_components) {
+      const __m256 v =
+          _mm256_i32gather_ps(&src[i * src_stride + c], indices, 4);
+      lo[c] = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+      hi[c] = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+      c++;
+    }
+    while (c < 6) {
+      lo[c] = hi[c] = _mm256_setzero_pd();
+      c++;
+    }
+
+    _mm256_storeu_pd(&dst[i], _d3_stress_avx2(lo[0], lo[1], lo[2], lo[3],
+                                              lo[4], lo[5], pressure));
+    _mm256_storeu_pd(&dst[i + 4], _d3_stress_avx2(hi[0], hi[1], hi[2], hi[3],
+                                                  hi[4], hi[5], pressure));
+    i += 8;
+  }
+
+  if (pressure) {
+    _d3_pressure_f32_scalar(&dst[i], &src[i * src_stride], src_stride,
+                            num_values - i);
+  } else {
+    _d3_von_mises_f32_scalar(&dst[i], &src[i * src_stride], src_stride,
+                             num_values - i);
+  }
+}
+
+D3_TARGET("avx2")
+static void _d3_stress_f64_avx2(double *dst, const double *src,
+                                size_t src_stride, size_t num_values,
+                                int pressure) {
+  const int stride = (int)src_stride;
+  const __m128i indices = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3),
+                                          _mm_set1_epi32(stride));
+  const int num_components = pressure ? 3 : 6;
+  size_t i = 0;
+  while (i + 4 <= num_values) {
+    __m256d v[6];
+    int c = 0;
+    while (c < num_components) {
+      v[c] = _mm256_i32gather_pd(&src[i * src_stride + c], indices, 8);
+      c++;
+    }
+    while (c < 6) {
+      v[c] = _mm256_setzero_pd();
+      c++;
+    }
+
+    _mm256_storeu_pd(&dst[i], _d3_stress_avx2(v[0], v[1], v[2], v[3], v[4],
+                                              v[5], pressure));
+    i += 4;
+  }
+
+  if (pressure) {
+    _d3_pressure_f64_scalar(&dst[i], &src[i * src_stride], src_stride,
+                            num_values - i);
+  } else {
+    _d3_von_mises_f64_scalar(&dst[i], &src[i * src_stride], src_stride,
+                             num_values - i);
+  }
+}
+
+/* Computes the lengths of eight consecutive vectors of dst*/
+D3_TARGET("avx2")
+static void _d3_magnitudes_avx2(double *magnitudes, const double *dst) {
+  const __m128i indices = _mm_setr_epi32(0, 3, 6, 9);
+  int h = 0;
+  while (h < 2) {
+    const double *v = &dst[h * 12];
+    const __m256d x = _mm256_i32gather_pd(v, indices, 8);
+    const __m256d y = _mm256_i32gather_pd(v + 1, indices, 8);
+    const __m256d z = _mm256_i32gather_pd(v + 2, indices, 8);
+    _mm256_storeu_pd(
+        &magnitudes[h * 4],
+        _mm256_sqrt_pd(_mm256_add_pd(
+            _mm256_add_pd(_mm256_mul_pd(x, x), _mm256_mul_pd(y, y)),
+            _mm256_mul_pd(z, z))));
+    h++;
+  }
+}
+
+/* Processes eight nodes (24 values) at once. All of them are loaded before
+ * storing anything, so that this also works in place*/
+D3_TARGET("avx2")
+static void _d3_displacement_f32_avx2(double *dst, double *magnitudes,
+                                      const float *src, const double *ref,
+                                      size_t num_nodes) {
+  size_t i = 0;
+  while (i + 8 <= num_nodes) {
+    __m128 v[6];
+    int c = 0;
+    while (c < 6) {
+      v[c] = _mm_loadu_ps(&src[i * 3 + c * 4]);
+      c++;
+    }
+    c = 0;
+    while (c < 6) {
+      _mm256_storeu_pd(&dst[i * 3 + c * 4],
+                       _mm256_sub_pd(_mm256_cvtps_pd(v[c]),
+                                     _mm256_loadu_pd(&ref[i * 3 + c * 4])));
+      c++;
+    }
+    if (magnitudes) {
+      _d3_magnitudes_avx2(&magnitudes[i], &dst[i * 3]);
+    }
+    i += 8;
+  }
+
+  _d3_displacement_f32_scalar(&dst[i * 3], magnitudes ? &magnitudes[i] : NULL,
+                              &src[i * 3], &ref[i * 3], num_nodes - i);
+}
+
+D3_TARGET("avx2")
+static void _d3_displacement_f64_avx2(double *dst, double *magnitudes,
+                                      const double *src, const double *ref,
+                                      size_t num_nodes) {
+  size_t i = 0;
+  while (i + 8 <= num_nodes) {
+    int c = 0;
+    while (c < 6) {
+      _mm256_storeu_pd(&dst[i * 3 + c * 4],
+                       _mm256_sub_pd(_mm256_loadu_pd(&src[i * 3 + c * 4]),
+                                     _mm256_loadu_pd(&ref[i * 3 + c * 4])));
+      c++;
+    }
+    if (magnitudes) {
+      _d3_magnitudes_avx2(&magnitudes[i], &dst[i * 3]);
+    }
+    i += 8;
+  }
+
+  _d3_displacement_f64_scalar(&dst[i * 3], magnitudes ? &magnitudes[i] : NULL,
+                              &src[i * 3], &ref[i * 3], num_nodes - i);
+}
+
+/* The states are blended as doubles, since both have 64 bits*/
+D3_TARGET("avx2")
+static void _d3_envelope_avx2(double *max, double *min, size_t *max_state,
+                              size_t *min_state, const double *values,
+                              size_t state, size_t num_values) {
+  const __m256d s = _mm256_castsi256_pd(_mm256_set1_epi64x((int64_t)state));
+  size_t i = 0;
+  while (i + 4 <= num_values) {
+    const __m256d v = _mm256_loadu_pd(&values[i]);
+    const __m256d old_max = _mm256_loadu_pd(&max[i]);
+    const __m256d old_min = _mm256_loadu_pd(&min[i]);
+    const __m256d greater = _mm256_cmp_pd(v, old_max, _CMP_GT_OQ);
+    const __m256d less = _mm256_cmp_pd(v, old_min, _CMP_LT_OQ);
+    _mm256_storeu_pd(&max[i], _mm256_blendv_pd(old_max, v, greater));
+    _mm256_storeu_pd(&min[i], _mm256_blendv_pd(old_min, v, less));
+    _mm256_storeu_pd(
+        (double *)&max_state[i],
+        _mm256_blendv_pd(_mm256_loadu_pd((const double *)&max_state[i]), s,
+                         greater));
+    _mm256_storeu_pd(
+        (double *)&min_state[i],
+        _mm256_blendv_pd(_mm256_loadu_pd((const double *)&min_state[i]), s,
+                         less));
+    i += 4;
+  }
+
+  _d3_envelope_scalar(&max[i], &min[i], &max_state[i], &min_state[i],
+                      &values[i], state, num_values - i);
+}
+
+/***** AVX-512 *****/
+
+D3_TARGET("avx512f")
+static void _d3_widen_f32_avx512(double *dst, const float *src,
+                                 size_t num_values) {
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    _mm512_storeu_pd(&dst[i], _mm512_cvtps_pd(_mm256_loadu_ps(&src[i])));
+    i += 8;
+  }
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+D3_TARGET("avx512f")
+static void _d3_widen_u32_avx512(uint64_t *dst, const uint32_t *src,
+                                 size_t num_values) {
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    _mm512_storeu_si512(
+        &dst[i],
+        _mm512_cvtepu32_epi64(_mm256_loadu_si256((const __m256i *)&src[i])));
+    i += 8;
+  }
+  while (i < num_values) {
+    dst[i] = src[i];
+    i++;
+  }
+}
+
+D3_TARGET("avx512f")
+static void _d3_narrow_f64_avx512(float *dst, const double *src,
+                                  size_t num_values) {
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    _mm256_storeu_ps(&dst[i], _mm512_cvtpd_ps(_mm512_loadu_pd(&src[i])));
+    i += 8;
+  }
+  while (i < num_values) {
+    dst[i] = (float)src[i];
+    i++;
+  }
+}
+
+/* The same as the AVX2 version, but with chunks of up to 16 values*/
+D3_TARGET("avx512f")
+static void _d3_widen_f32_runs_avx512(double *dst, size_t dst_stride,
+                                      const float *src, size_t src_stride,
+                                      size_t num_elements, const size_t *runs,
+                                      size_t num_runs) {
+  size_t chunk_dst[D3_KERNELS_MAX_CHUNKS];
+  size_t chunk_src[D3_KERNELS_MAX_CHUNKS];
+  __mmask16 load_masks[D3_KERNELS_MAX_CHUNKS];
+  size_t num_chunks = 0;
+
+  size_t r = 0;
+  while (r < num_runs) {
+    size_t j = 0;
+    while (j < runs[r * 3 + 2]) {
+      if (num_chunks == D3_KERNELS_MAX_CHUNKS) {
+        _d3_widen_f32_runs_scalar(dst, dst_stride, src, src_stride,
+                                  num_elements, runs, num_runs);
+        return;
+      }
+
+      const size_t len = runs[r * 3 + 2] - j < 16 ? runs[r * 3 + 2] - j : 16;
+      chunk_dst[num_chunks] = runs[r * 3 + 0] + j;
+      chunk_src[num_chunks] = runs[r * 3 + 1] == D3_KERNELS_ZERO_RUN
+                                  ? D3_KERNELS_ZERO_RUN
+                                  : runs[r * 3 + 1] + j;
+      load_masks[num_chunks] = (__mmask16)((1u << len) - 1u);
+      num_chunks++;
+      j += len;
+    }
+    r++;
+  }
+
+  size_t i = 0;
+  while (i < num_elements) {
+    size_t c = 0;
+    while (c < num_chunks) {
+      const __m512 v =
+          chunk_src[c] == D3_KERNELS_ZERO_RUN
+              ? _mm512_setzero_ps()
+              : _mm512_maskz_loadu_ps(load_masks[c], &src[chunk_src[c]]);
+      _mm512_mask_storeu_pd(&dst[chunk_dst[c]], (__mmask8)load_masks[c],
+                            _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+      if (load_masks[c] >> 8) {
+        _mm512_mask_storeu_pd(
+            &dst[chunk_dst[c] + 8], (__mmask8)(load_masks[c] >> 8),
+            _mm512_cvtps_pd(_mm256_castpd_ps(
+                _mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))));
+      }
+      c++;
+    }
+
+    dst += dst_stride;
+    src += src_stride;
+    i++;
+  }
+}
+
+D3_TARGET("avx512f")
+static void _d3_widen_f32_gather_avx512(double *dst, const float *src,
+                                        size_t src_stride,
+                                        size_t num_values) {
+  const int stride = (int)src_stride;
+  const __m512i indices = _mm512_mullo_epi32(
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+      _mm512_set1_epi32(stride));
+  size_t i = 0;
+  while (i + 16 <= num_values) {
+    const __m512 v = _mm512_i32gather_ps(indices, &src[i * src_stride], 4);
+    _mm512_storeu_pd(&dst[i], _mm512_cvtps_pd(_mm512_castps512_ps256(v)));
+    _mm512_storeu_pd(&dst[i + 8],
+                     _mm512_cvtps_pd(_mm256_castpd_ps(
+                         _mm512_extractf64x4_pd(_mm512_castps_pd(v), 1))));
+    i += 16;
+  }
+  _d3_widen_f32_gather_scalar(&dst[i], &src[i * src_stride], src_stride,
+                              num_values - i);
+}
+
+D3_TARGET("avx512f")
+static void _d3_copy_f64_gather_avx512(double *dst, const double *src,
+                                       size_t src_stride, size_t num_values) {
+  const int stride = (int)src_stride;
+  const __m256i indices = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    _mm512_storeu_pd(&dst[i],
+                     _mm512_i32gather_pd(indices, &src[i * src_stride], 8));
+    i += 8;
+  }
+  _d3_copy_f64_gather_scalar(&dst[i], &src[i * src_stride], src_stride,
+                             num_values - i);
+}
+
+/* Computes the von Mises stress (or the pressure) of eight tensors*/
+D3_TARGET("avx512f")
+static __m512d _d3_stress_avx512(__m512d x, __m512d y, __m512d z, __m512d xy,
+                                 __m512d yz, __m512d zx, int pressure) {
+  if (pressure) {
+    return _mm512_mul_pd(_mm512_add_pd(_mm512_add_pd(x, y), z),
+                         _mm512_set1_pd(-1.0 / 3.0));
+  }
+
+  const __m512d dxy = _mm512_sub_pd(x, y);
+  const __m512d dyz = _mm512_sub_pd(y, z);
+  const __m512d dzx = _mm512_sub_pd(z, x);
+  const __m512d normal = _mm512_fmadd_pd(
+      dzx, dzx, _mm512_fmadd_pd(dyz, dyz, _mm512_mul_pd(dxy, dxy)));
+  const __m512d shear = _mm512_fmadd_pd(
+      zx, zx, _mm512_fmadd_pd(yz, yz, _mm512_mul_pd(xy, xy)));
+  return _mm512_sqrt_pd(
+      _mm512_fmadd_pd(_mm512_set1_pd(0.5), normal,
+                      _mm512_mul_pd(_mm512_set1_pd(3.0), shear)));
+}
+
+D3_TARGET("avx512f")
+static void _d3_stress_f32_avx512(double *dst, const float *src,
+                                  size_t src_stride, size_t num_values,
+                                  int pressure) {
+  const int stride = (int)src_stride;
+  const __m512i indices = _mm512_mullo_epi32(
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+      _mm512_set1_epi32(stride));
+  const int num_components = pressure ? 3 : 6;
+  size_t i = 0;
+  while (i + 16 <= num_values) {
+    __m512d lo[6], hi[6];
+    int c = 0;
+    while (c < num_components) {
+      const __m512 v =
+          _mm512_i32gather_ps(indices, &src[i * src_stride + c], 4);
+      lo[c] = _mm512_cvtps_pd(_mm512_castps512_ps256(v));
+      hi[c] = _mm512_cvtps_pd(_mm256_castpd_ps(
+          _mm512_extractf64x4_pd(_mm512_castps_pd(v), 1)));
+      c++;
+    }
+    while (c < 6) {
+      lo[c] = hi[c] = _mm512_setzero_pd();
+      c++;
+    }
+
+    _mm512_storeu_pd(&dst[i], _d3_stress_avx512(lo[0], lo[1], lo[2], lo[3],
+                                                lo[4], lo[5], pressure));
+    _mm512_storeu_pd(&dst[i + 8],
+                     _d3_stress_avx512(hi[0], hi[1], hi[2], hi[3], hi[4],
+                                       hi[5], pressure));
+    i += 16;
+  }
+
+  if (pressure) {
+    _d3_pressure_f32_scalar(&dst[i], &src[i * src_stride], src_stride,
+                            num_values - i);
+  } else {
+    _d3_von_mises_f32_scalar(&dst[i], &src[i * src_stride], src_stride,
+                             num_values - i);
+  }
+}
+
+D3_TARGET("avx512f")
+static void _d3_stress_f64_avx512(double *dst, const double *src,
+                                  size_t src_stride, size_t num_values,
+                                  int pressure) {
+  const int stride = (int)src_stride;
+  const __m256i indices = _mm256_mullo_epi32(
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+  const int num_components = pressure ? 3 : 6;
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    __m512d v[6];
+    int c = 0;
+    while (c < num_components) {
+      v[c] = _mm512_i32gather_pd(indices, &src[i * src_stride + c], 8);
+      c++;
+    }
+    while (c < 6) {
+      v[c] = _mm512_setzero_pd();
+      c++;
+    }
+
+    _mm512_storeu_pd(&dst[i], _d3_stress_avx512(v[0], v[1], v[2], v[3], v[4],
+                                                v[5], pressure));
+    i += 8;
+  }
+
+  if (pressure) {
+    _d3_pressure_f64_scalar(&dst[i], &src[i * src_stride], src_stride,
+                            num_values - i);
+  } else {
+    _d3_von_mises_f64_scalar(&dst[i], &src[i * src_stride], src_stride,
+                             num_values - i);
+  }
+}
+
+/* Computes the lengths of eight consecutive vectors of dst*/
+D3_TARGET("avx512f")
+static void _d3_magnitudes_avx512(double *magnitudes, const double *dst) {
+  const __m256i indices = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+  const __m512d x = _mm512_i32gather_pd(indices, dst, 8);
+  const __m512d y = _mm512_i32gather_pd(indices, dst + 1, 8);
+  const __m512d z = _mm512_i32gather_pd(indices, dst + 2, 8);
+  _mm512_storeu_pd(magnitudes,
+                   _mm512_sqrt_pd(_mm512_add_pd(
+                       _mm512_add_pd(_mm512_mul_pd(x, x), _mm512_mul_pd(y, y)),
+                       _mm512_mul_pd(z, z))));
+}
+
+D3_TARGET("avx512f")
+static void _d3_displacement_f32_avx512(double *dst, double *magnitudes,
+                                        const float *src, const double *ref,
+                                        size_t num_nodes) {
+  size_t i = 0;
+  while (i + 8 <= num_nodes) {
+    __m256 v[3];
+    int c = 0;
+    while (c < 3) {
+      v[c] = _mm256_loadu_ps(&src[i * 3 + c * 8]);
+      c++;
+    }
+    c = 0;
+    while (c < 3) {
+      _mm512_storeu_pd(&dst[i * 3 + c * 8],
+                       _mm512_sub_pd(_mm512_cvtps_pd(v[c]),
+                                     _mm512_loadu_pd(&ref[i * 3 + c * 8])));
+      c++;
+    }
+    if (magnitudes) {
+      _d3_magnitudes_avx512(&magnitudes[i], &dst[i * 3]);
+    }
+    i += 8;
+  }
+
+  _d3_displacement_f32_scalar(&dst[i * 3], magnitudes ? &magnitudes[i] : NULL,
+                              &src[i * 3], &ref[i * 3], num_nodes - i);
+}
+
+D3_TARGET("avx512f")
+static void _d3_displacement_f64_avx512(double *dst, double *magnitudes,
+                                        const double *src, const double *ref,
+                                        size_t num_nodes) {
+  size_t i = 0;
+  while (i + 8 <= num_nodes) {
+    int c = 0;
+    while (c < 3) {
+      _mm512_storeu_pd(&dst[i * 3 + c * 8],
+                       _mm512_sub_pd(_mm512_loadu_pd(&src[i * 3 + c * 8]),
+                                     _mm512_loadu_pd(&ref[i * 3 + c * 8])));
+      c++;
+    }
+    if (magnitudes) {
+      _d3_magnitudes_avx512(&magnitudes[i], &dst[i * 3]);
+    }
+    i += 8;
+  }
+
+  _d3_displacement_f64_scalar(&dst[i * 3], magnitudes ? &magnitudes[i] : NULL,
+                              &src[i * 3], &ref[i * 3], num_nodes - i);
+}
+
+D3_TARGET("avx512f")
+static void _d3_envelope_avx512(double *max, double *min, size_t *max_state,
+                                size_t *min_state, const double *values,
+                                size_t state, size_t num_values) {
+  const __m512i s = _mm512_set1_epi64((int64_t)state);
+  size_t i = 0;
+  while (i + 8 <= num_values) {
+    const __m512d v = _mm512_loadu_pd(&values[i]);
+    const __mmask8 greater =
+        _mm512_cmp_pd_mask(v, _mm512_loadu_pd(&max[i]), _CMP_GT_OQ);
+    const __mmask8 less =
+        _mm512_cmp_pd_mask(v, _mm512_loadu_pd(&min[i]), _CMP_LT_OQ);
+    _mm512_mask_storeu_pd(&max[i], greater, v);
+    _mm512_mask_storeu_pd(&min[i], less, v);
+    _mm512_mask_storeu_epi64(&max_state[i], greater, s);
+    _mm512_mask_storeu_epi64(&min_state[i], less, s);
+    i += 8;
+  }
+
+  _d3_envelope_scalar(&max[i], &min[i], &max_state[i], &min_state[i],
+                      &values[i], state, num_values - i);
+}
+
+/***** Detection *****/
+
+static int _d3_kernels_detect_isa(void) {
+#ifdef _MSC_VER
+  int info[4];
+  __cpuid(info, 0);
+  const int max_leaf = info[0];
+
+  __cpuid(info, 1);
+  if (!(info[3] & (1 << 26))) {
+    return D3_KERNELS_SCALAR;
+  }
+  /* AVX needs to be enabled by the OS (OSXSAVE + XMM and YMM state)*/
+  const int os_avx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) &&
+                     (_xgetbv(0) & 0x6) == 0x6;
+  if (!os_avx || max_leaf < 7) {
+    return D3_KERNELS_SSE2;
+  }
+
+  __cpuidex(info, 7, 0);
+  /* AVX-512 additionally needs the opmask and ZMM state*/
+  if ((info[1] & (1 << 16)) && (_xgetbv(0) & 0xE6) == 0xE6) {
+    return D3_KERNELS_AVX512;
+  }
+  if (info[1] & (1 << 5)) {
+    return D3_KERNELS_AVX2;
+  }
+  return D3_KERNELS_SSE2;
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f")) {
+    return D3_KERNELS_AVX512;
+  }
+  if (__builtin_cpu_supports("avx2")) {
+    return D3_KERNELS_AVX2;
+  }
+  if (__builtin_cpu_supports("sse2")) {
+    return D3_KERNELS_SSE2;
+  }
+  return D3_KERNELS_SCALAR;
+#endif
+}
+
+#else
+
+static int _d3_kernels_detect_isa(void) { return D3_KERNELS_SCALAR; }
+
+#endif
+
+/***** Dispatch *****/
+
+int d3_kernels_get_isa(void) {
+  if (_d3_kernels_isa == -1) {
+    _d3_kernels_supported_isa = _d3_kernels_detect_isa();
+    _d3_kernels_isa = _d3_kernels_supported_isa;
+  }
+
+  return _d3_kernels_isa;
+}
+
+int d3_kernels_set_isa(int isa) {
+  d3_kernels_get_isa();
+  if (isa < D3_KERNELS_SCALAR) {
+    isa = D3_KERNELS_SCALAR;
+  }
+  if (isa > _d3_kernels_supported_isa) {
+    isa = _d3_kernels_supported_isa;
+  }
+
+  _d3_kernels_isa = isa;
+  return isa;
+}
+
+void d3_kernel_widen_f32(double *dst, const float *src, size_t num_values) {
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_widen_f32_avx512(dst, src, num_values);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_widen_f32_avx2(dst, src, num_values);
+    break;
+  case D3_KERNELS_SSE2:
+    _d3_widen_f32_sse2(dst, src, num_values);
+    break;
+#endif
+  default:
+    _d3_widen_f32_scalar(dst, src, num_values);
+    break;
+  }
+}
+
+void d3_kernel_widen_u32(uint64_t *dst, const uint32_t *src,
+                         size_t num_values) {
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_widen_u32_avx512(dst, src, num_values);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_widen_u32_avx2(dst, src, num_values);
+    break;
+  case D3_KERNELS_SSE2:
+    _d3_widen_u32_sse2(dst, src, num_values);
+    break;
+#endif
+  default:
+    _d3_widen_u32_scalar(dst, src, num_values);
+    break;
+  }
+}
+
+void d3_kernel_narrow_f64(float *dst, const double *src, size_t num_values) {
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_narrow_f64_avx512(dst, src, num_values);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_narrow_f64_avx2(dst, src, num_values);
+    break;
+  case D3_KERNELS_SSE2:
+    _d3_narrow_f64_sse2(dst, src, num_values);
+    break;
+#endif
+  default:
+    _d3_narrow_f64_scalar(dst, src, num_values);
+    break;
+  }
+}
+
+void d3_kernel_widen_f32_runs(double *dst, size_t dst_stride,
+                              const float *src, size_t src_stride,
+                              size_t num_elements, const size_t *runs,
+                              size_t num_runs) {
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_widen_f32_runs_avx512(dst, dst_stride, src, src_stride, num_elements,
+                              runs, num_runs);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_widen_f32_runs_avx2(dst, dst_stride, src, src_stride, num_elements,
+                            runs, num_runs);
+    break;
+  case D3_KERNELS_SSE2:
+    _d3_widen_f32_runs_sse2(dst, dst_stride, src, src_stride, num_elements,
+                            runs, num_runs);
+    break;
+#endif
+  default:
+    _d3_widen_f32_runs_scalar(dst, dst_stride, src, src_stride, num_elements,
+                              runs, num_runs);
+    break;
+  }
+}
+
+void d3_kernel_copy_f64_runs(double *dst, size_t dst_stride,
+                             const double *src, size_t src_stride,
+                             size_t num_elements, const size_t *runs,
+                             size_t num_runs) {
+  /* memcpy is already as fast as it gets*/
+  size_t i = 0;
+  while (i < num_elements) {
+    size_t r = 0;
+    while (r < num_runs) {
+      const size_t *run = &runs[r * 3];
+      if (run[1] == D3_KERNELS_ZERO_RUN) {
+        memset(&dst[run[0]], 0, run[2] * sizeof(double));
+      } else {
+        memcpy(&dst[run[0]], &src[run[1]], run[2] * sizeof(double));
+      }
+      r++;
+    }
+
+    dst += dst_stride;
+    src += src_stride;
+    i++;
+  }
+}
+
+void d3_kernel_widen_f32_gather(double *dst, const float *src,
+                                size_t src_stride, size_t num_values) {
+  /* The indices of the gather instructions are 32 bit integers*/
+  if (src_stride > D3_KERNELS_MAX_GATHER_STRIDE) {
+    _d3_widen_f32_gather_scalar(dst, src, src_stride, num_values);
+    return;
+  }
+
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_widen_f32_gather_avx512(dst, src, src_stride, num_values);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_widen_f32_gather_avx2(dst, src, src_stride, num_values);
+    break;
+#endif
+  default:
+    /* SSE2 has no gather instructions*/
+    _d3_widen_f32_gather_scalar(dst, src, src_stride, num_values);
+    break;
+  }
+}
+
+void d3_kernel_copy_f64_gather(double *dst, const double *src,
+                               size_t src_stride, size_t num_values) {
+  if (src_stride > D3_KERNELS_MAX_GATHER_STRIDE) {
+    _d3_copy_f64_gather_scalar(dst, src, src_stride, num_values);
+    return;
+  }
+
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_copy_f64_gather_avx512(dst, src, src_stride, num_values);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_copy_f64_gather_avx2(dst, src, src_stride, num_values);
+    break;
+#endif
+  default:
+    _d3_copy_f64_gather_scalar(dst, src, src_stride, num_values);
+    break;
+  }
+}
+
+/* Dispatches the von Mises and pressure kernels. SSE2 has no gather
+ * instructions, so that it uses the scalar versions*/
+#ifdef D3_KERNELS_X86
+#define D3_STRESS_DISPATCH(type, dst, src, src_stride, num_values, pressure,  \
+                           scalar)                                             \
+  if (src_stride > D3_KERNELS_MAX_GATHER_STRIDE) {                             \
+    scalar(dst, src, src_stride, num_values);                                  \
+    return;                                                                    \
+  }                                                                            \
+  switch (d3_kernels_get_isa()) {                                              \
+  case D3_KERNELS_AVX512:                                                      \
+    _d3_stress_##type##_avx512(dst, src, src_stride, num_values, pressure);    \
+    break;                                                                     \
+  case D3_KERNELS_AVX2:                                                        \
+    _d3_stress_##type##_avx2(dst, src, src_stride, num_values, pressure);      \
+    break;                                                                     \
+  default:                                                                     \
+    scalar(dst, src, src_stride, num_values);                                  \
+    break;                                                                     \
+  }
+#else
+#define D3_STRESS_DISPATCH(type, dst, src, src_stride, num_values, pressure,  \
+                           scalar)                                             \
+  scalar(dst, src, src_stride, num_values);
+#endif
+
+void d3_kernel_von_mises_f32(double *dst, const float *src, size_t src_stride,
+                             size_t num_values) {
+  D3_STRESS_DISPATCH(f32, dst, src, src_stride, num_values, 0,
+                     _d3_von_mises_f32_scalar);
+}
+
+void d3_kernel_von_mises_f64(double *dst, const double *src,
+                             size_t src_stride, size_t num_values) {
+  D3_STRESS_DISPATCH(f64, dst, src, src_stride, num_values, 0,
+                     _d3_von_mises_f64_scalar);
+}
+
+void d3_kernel_pressure_f32(double *dst, const float *src, size_t src_stride,
+                            size_t num_values) {
+  D3_STRESS_DISPATCH(f32, dst, src, src_stride, num_values, 1,
+                     _d3_pressure_f32_scalar);
+}
+
+void d3_kernel_pressure_f64(double *dst, const double *src, size_t src_stride,
+                            size_t num_values) {
+  D3_STRESS_DISPATCH(f64, dst, src, src_stride, num_values, 1,
+                     _d3_pressure_f64_scalar);
+}
+
+void d3_kernel_principal_f32(double *dst, const float *src, size_t src_stride,
+                             size_t num_values) {
+  /* acos and cos have no SIMD instructions*/
+  _d3_principal_f32_scalar(dst, src, src_stride, num_values);
+}
+
+void d3_kernel_principal_f64(double *dst, const double *src,
+                             size_t src_stride, size_t num_values) {
+  _d3_principal_f64_scalar(dst, src, src_stride, num_values);
+}
+
+/* SSE2 has no gather instructions, so that it uses the scalar versions*/
+void d3_kernel_displacement_f32(double *dst, double *magnitudes,
+                                const float *src, const double *ref,
+                                size_t num_nodes) {
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_displacement_f32_avx512(dst, magnitudes, src, ref, num_nodes);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_displacement_f32_avx2(dst, magnitudes, src, ref, num_nodes);
+    break;
+#endif
+  default:
+    _d3_displacement_f32_scalar(dst, magnitudes, src, ref, num_nodes);
+    break;
+  }
+}
+
+void d3_kernel_displacement_f64(double *dst, double *magnitudes,
+                                const double *src, const double *ref,
+                                size_t num_nodes) {
+  switch (d3_kernels_get_isa()) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_displacement_f64_avx512(dst, magnitudes, src, ref, num_nodes);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_displacement_f64_avx2(dst, magnitudes, src, ref, num_nodes);
+    break;
+#endif
+  default:
+    _d3_displacement_f64_scalar(dst, magnitudes, src, ref, num_nodes);
+    break;
+  }
+}
+
+void d3_kernel_envelope(double *max, double *min, size_t *max_state,
+                        size_t *min_state, const double *values, size_t state,
+                        size_t num_values) {
+  /* The SIMD versions need 64 bit states*/
+  switch (sizeof(size_t) == 8 ? d3_kernels_get_isa() : D3_KERNELS_SCALAR) {
+#ifdef D3_KERNELS_X86
+  case D3_KERNELS_AVX512:
+    _d3_envelope_avx512(max, min, max_state, min_state, values, state,
+                        num_values);
+    break;
+  case D3_KERNELS_AVX2:
+    _d3_envelope_avx2(max, min, max_state, min_state, values, state,
+                      num_values);
+    break;
+#endif
+  default:
+    _d3_envelope_scalar(max, min, max_state, min_state, values, state,
+                        num_values);
+    break;
+  }
+}
@@ -0,0 +1,114 @@
+/***********************************************************************************
+ *                         This file is part of dynareadout
+ *                    https://github.com/PucklaMotzer09/dynareadout
+ ***********************************************************************************
+ * Copyright (c) 2022 PucklaMotzer09
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ * that you wrote the original software. If you use this software in a product,
+ * an acknowledgment in the product documentation would be appreciated but is
+ * not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ ************************************************************************************/
+
+#ifndef D3_KERNELS_H
+#define D3_KERNELS_H
+#include <stddef.h>
+#include <stdint.h>
+
+/* The instruction sets that the kernels can use. The best one supported by the
+ * CPU is detected at runtime*/
+#define D3_KERNELS_SCALAR 0
+#define D3_KERNELS_SSE2 1
+#define D3_KERNELS_AVX2 2
+#define D3_KERNELS_AVX512 3
+
+/* Marks a run that is filled with zeros*/
+#define D3_KERNELS_ZERO_RUN ((size_t)-1)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Returns the instruction set that is currently used by the kernels. The
+ * first call detects it and is not thread safe, so that it needs to be called
+ * before starting threads that use the kernels*/
+int d3_kernels_get_isa(void);
+/* Use a different instruction set. If the CPU does not support isa the best
+ * supported one below it is used. Returns the instruction set that is used*/
+int d3_kernels_set_isa(int isa);
+
+/* dst[i] = src[i]. The widening kernels also work in place if src lies in the
+ * second half of dst (src == (float *)dst + num_values) and narrowing if
+ * dst == (float *)src*/
+void d3_kernel_widen_f32(double *dst, const float *src, size_t num_values);
+void d3_kernel_widen_u32(uint64_t *dst, const uint32_t *src, size_t num_values);
+void d3_kernel_narrow_f64(float *dst, const double *src, size_t num_values);
+/* Copies the runs of num_elements elements. Every run consists of three
+ * values (dst, src, length) and copies length consecutive values from src to
+ * dst inside an element. Runs whose src is D3_KERNELS_ZERO_RUN are filled with
+ * zeros. The strides are the distances between two elements in values*/
+void d3_kernel_widen_f32_runs(double *dst, size_t dst_stride,
+                              const float *src, size_t src_stride,
+                              size_t num_elements, const size_t *runs,
+                              size_t num_runs);
+void d3_kernel_copy_f64_runs(double *dst, size_t dst_stride,
+                             const double *src, size_t src_stride,
+                             size_t num_elements, const size_t *runs,
+                             size_t num_runs);
+/* dst[i] = src[i * src_stride]. Splits interleaved values into a separate
+ * array*/
+void d3_kernel_widen_f32_gather(double *dst, const float *src,
+                                size_t src_stride, size_t num_values);
+void d3_kernel_copy_f64_gather(double *dst, const double *src,
+                               size_t src_stride, size_t num_values);
+/* Derived quantities of num_values stress tensors. Every tensor consists of
+ * six consecutive values (x, y, z, xy, yz, zx) starting at src[i *
+ * src_stride]. von_mises and pressure write one value per tensor and principal
+ * the three principal stresses in descending order*/
+void d3_kernel_von_mises_f32(double *dst, const float *src, size_t src_stride,
+                             size_t num_values);
+void d3_kernel_von_mises_f64(double *dst, const double *src,
+                             size_t src_stride, size_t num_values);
+void d3_kernel_pressure_f32(double *dst, const float *src, size_t src_stride,
+                            size_t num_values);
+void d3_kernel_pressure_f64(double *dst, const double *src, size_t src_stride,
+                            size_t num_values);
+void d3_kernel_principal_f32(double *dst, const float *src, size_t src_stride,
+                             size_t num_values);
+void d3_kernel_principal_f64(double *dst, const double *src,
+                             size_t src_stride, size_t num_values);
+/* dst = src - ref for num_nodes nodes of three values each. If magnitudes is
+ * not NULL the length of every result is written into it. Works in place if
+ * src == dst or, for f32, if src lies in the second half of dst (src ==
+ * (float *)dst + num_nodes * 3)*/
+void d3_kernel_displacement_f32(double *dst, double *magnitudes,
+                                const float *src, const double *ref,
+                                size_t num_nodes);
+void d3_kernel_displacement_f64(double *dst, double *magnitudes,
+                                const double *src, const double *ref,
+                                size_t num_nodes);
+/* Running maximum and minimum: if values[i] > max[i] it becomes the new
+ * max[i] and max_state[i] is set to state. The same for min with <. NaN values
+ * are ignored*/
+void d3_kernel_envelope(double *max, double *min, size_t *max_state,
+                        size_t *min_state, const double *values, size_t state,
+                        size_t num_values);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
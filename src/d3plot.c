@@ -24,6 +24,7 @@
  ************************************************************************************/
 
 #include "d3plot.h"
+#include "d3_kernels.h"
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -43,12 +44,60 @@
   d3_word value = 0;                                                           \
   d3_buffer_read_words(&plot_file.buffer, &value, 1)
 #define CDA plot_file.control_data
+/* The maximum number of values of an element state struct (d3plot_shell)*/
+#define D3PLT_MAX_ELEMENT_VALUES (sizeof(d3plot_shell) / sizeof(double))
+/* The fields of every value of the element state structs*/
+#define D3PLT_TENSOR_FIELDS(field) field, field, field, field, field, field
+#define D3PLT_SURFACE_FIELDS                                                   \
+  D3PLT_TENSOR_FIELDS(D3PLT_FIELD_STRESS),                                     \
+      D3PLT_FIELD_EFFECTIVE_PLASTIC_STRAIN
+
+static const unsigned int
+    _d3plot_solid_fields[sizeof(d3plot_solid) / sizeof(double)] = {
+        D3PLT_SURFACE_FIELDS, D3PLT_FIELD_EXTRA, D3PLT_FIELD_EXTRA,
+        D3PLT_TENSOR_FIELDS(D3PLT_FIELD_STRAIN)};
+static const unsigned int
+    _d3plot_thick_shell_fields[sizeof(d3plot_thick_shell) / sizeof(double)] = {
+        D3PLT_SURFACE_FIELDS, D3PLT_SURFACE_FIELDS, D3PLT_SURFACE_FIELDS,
+        D3PLT_TENSOR_FIELDS(D3PLT_FIELD_STRAIN),
+        D3PLT_TENSOR_FIELDS(D3PLT_FIELD_STRAIN)};
+static const unsigned int
+    _d3plot_shell_fields[sizeof(d3plot_shell) / sizeof(double)] = {
+        D3PLT_SURFACE_FIELDS, D3PLT_SURFACE_FIELDS, D3PLT_SURFACE_FIELDS,
+        D3PLT_TENSOR_FIELDS(D3PLT_FIELD_STRAIN),
+        D3PLT_TENSOR_FIELDS(D3PLT_FIELD_STRAIN),
+        D3PLT_FIELD_INTERNAL_ENERGY};
+
+/* The number of elements of which the components are gathered at once*/
+#define D3PLT_SOA_PIECE_SIZE 256
+/* Requested nodes or elements whose words lie at most this many words apart
+ * are read together by the history functions*/
+#define D3PLT_HISTORY_MAX_GAP 1024
+/* The maximum number of states of which the GLOBAL blocks are read at once*/
+#define D3PLT_GLOBAL_MAX_STATES 256
+
+void _d3plot_init_file(d3plot_file *plot_file) {
+  plot_file->error_string = NULL;
+  plot_file->data_pointers = NULL;
+  plot_file->num_states = 0;
+  plot_file->state_size = 0;
+  plot_file->state_times = NULL;
+  memset(plot_file->part_offsets, 0, sizeof(plot_file->part_offsets));
+  memset(plot_file->part_elements, 0, sizeof(plot_file->part_elements));
+  memset(plot_file->sorted_ids, 0, sizeof(plot_file->sorted_ids));
+  memset(plot_file->sorted_id_indices, 0, sizeof(plot_file->sorted_id_indices));
+  plot_file->cache_first = NULL;
+  plot_file->cache_last = NULL;
+  plot_file->cache_size = 0;
+  plot_file->max_cache_size = 0;
+  plot_file->scratch = NULL;
+  plot_file->scratch_size = 0;
+  plot_file->initial_coordinates = NULL;
+}
 
 d3plot_file d3plot_open(const char *root_file_name) {
   d3plot_file plot_file;
-  plot_file.error_string = NULL;
-  plot_file.data_pointers = NULL;
-  plot_file.num_states = 0;
+  _d3plot_init_file(&plot_file);
 
   plot_file.buffer = d3_buffer_open(root_file_name);
   if (plot_file.buffer.error_string) {
@@ -347,22 +396,18 @@ d3plot_file d3plot_open(const char *root_file_name) {
     return plot_file;
   }
 
-  if (!d3_buffer_next_file(&plot_file.buffer)) {
-    plot_file.error_string = malloc(14);
-    sprintf(plot_file.error_string, "Too few files");
-    return plot_file;
-  }
+  /* If there is no next file the solver has not written any states yet. They
+   * can be found later by d3plot_refresh*/
+  d3_buffer_next_file(&plot_file.buffer);
 
   /* Here comes the STATE DATA*/
 
-  int result = 1;
-  while (result) {
-    result = _d3plot_read_state_data(&plot_file);
-    if (result == 2) {
-      if (!d3_buffer_next_file(&plot_file.buffer)) {
-        break;
-      }
-    }
+  if (!_d3plot_read_state_data(&plot_file)) {
+    return plot_file;
+  }
+
+  if (!_d3plot_index_states(&plot_file, plot_file.buffer.cur_word)) {
+    return plot_file;
   }
 
   return plot_file;
@@ -372,9 +417,59 @@ void d3plot_close(d3plot_file *plot_file) {
   d3_buffer_close(&plot_file->buffer);
 
   free(plot_file->data_pointers);
+  free(plot_file->state_times);
   free(plot_file->error_string);
 
+  int i = 0;
+  while (i < D3PLT_ELEMENT_TYPE_COUNT) {
+    free(plot_file->part_offsets[i]);
+    free(plot_file->part_elements[i]);
+    plot_file->part_offsets[i] = NULL;
+    plot_file->part_elements[i] = NULL;
+    i++;
+  }
+  i = 0;
+  while (i < D3PLT_ID_TYPE_COUNT) {
+    free(plot_file->sorted_ids[i]);
+    free(plot_file->sorted_id_indices[i]);
+    plot_file->sorted_ids[i] = NULL;
+    plot_file->sorted_id_indices[i] = NULL;
+    i++;
+  }
+
+  d3plot_set_cache_size(plot_file, 0);
+  free(plot_file->scratch);
+  plot_file->scratch = NULL;
+  plot_file->scratch_size = 0;
+  free(plot_file->initial_coordinates);
+  plot_file->initial_coordinates = NULL;
+
+  plot_file->data_pointers = NULL;
+  plot_file->state_times = NULL;
   plot_file->num_states = 0;
+  plot_file->state_size = 0;
+}
+
+int d3plot_refresh(d3plot_file *plot_file) {
+  if (!d3_buffer_refresh(&plot_file->buffer)) {
+    plot_file->error_string = plot_file->buffer.error_string;
+    plot_file->buffer.error_string = NULL;
+    return 0;
+  }
+
+  /* Continue right after the last state that has already been found. All
+   * states before it are not touched again*/
+  size_t word_pos;
+  if (plot_file->num_states == 0) {
+    /* The states start with the second file*/
+    word_pos = plot_file->buffer.file_sizes[0] / plot_file->buffer.word_size;
+  } else {
+    word_pos =
+        plot_file->data_pointers[D3PLT_PTR_STATES + plot_file->num_states - 1] +
+        plot_file->state_size;
+  }
+
+  return _d3plot_index_states(plot_file, word_pos);
 }
 
 d3_word *d3plot_read_node_ids(d3plot_file *plot_file, size_t *num_ids) {
@@ -406,40 +501,25 @@ d3_word *d3plot_read_thick_shell_element_ids(d3plot_file *plot_file,
 }
 
 d3_word *d3plot_read_all_element_ids(d3plot_file *plot_file, size_t *num_ids) {
-  d3_word *all_ids = NULL;
-  *num_ids = 0;
-
-  size_t num_ids_buffer;
-  d3_word *ids_buffer =
-      d3plot_read_solid_element_ids(plot_file, &num_ids_buffer);
-  if (num_ids_buffer > 0) {
-    all_ids = _insert_sorted(all_ids, *num_ids, ids_buffer, num_ids_buffer);
-    *num_ids += num_ids_buffer;
-    free(ids_buffer);
-  }
-
-  ids_buffer = d3plot_read_beam_element_ids(plot_file, &num_ids_buffer);
-  if (num_ids_buffer > 0) {
-    all_ids = _insert_sorted(all_ids, *num_ids, ids_buffer, num_ids_buffer);
-    *num_ids += num_ids_buffer;
-    free(ids_buffer);
-  }
-
-  ids_buffer = d3plot_read_shell_element_ids(plot_file, &num_ids_buffer);
-  if (num_ids_buffer > 0) {
-    all_ids = _insert_sorted(all_ids, *num_ids, ids_buffer, num_ids_buffer);
-    *num_ids += num_ids_buffer;
-    free(ids_buffer);
-  }
-
-  ids_buffer = d3plot_read_thick_shell_element_ids(plot_file, &num_ids_buffer);
-  if (num_ids_buffer > 0) {
-    all_ids = _insert_sorted(all_ids, *num_ids, ids_buffer, num_ids_buffer);
-    *num_ids += num_ids_buffer;
-    free(ids_buffer);
-  }
+  return _d3plot_merge_element_ids(plot_file, num_ids, NULL, NULL);
+}
 
-  return all_ids;
+d3_word *d3plot_read_all_element_ids_origin(d3plot_file *plot_file,
+                                            size_t *num_ids,
+                                            uint8_t **element_types,
+                                            size_t **element_indices) {
+  const size_t num_all_ids =
+      plot_file->control_data.nel8 + plot_file->control_data.nelt +
+      plot_file->control_data.nel2 + plot_file->control_data.nel4;
+  *element_types = NULL;
+  *element_indices = NULL;
+  if (num_all_ids != 0) {
+    *element_types = malloc(num_all_ids * sizeof(uint8_t));
+    *element_indices = malloc(num_all_ids * sizeof(size_t));
+  }
+
+  return _d3plot_merge_element_ids(plot_file, num_ids, *element_types,
+                                   *element_indices);
 }
 
 d3_word *d3plot_read_part_ids(d3plot_file *plot_file, size_t *num_parts) {
@@ -471,6 +551,48 @@ char **d3plot_read_part_titles(d3plot_file *plot_file, size_t *num_parts) {
   return part_titles;
 }
 
+size_t d3plot_node_indices(d3plot_file *plot_file, const d3_word *ids,
+                           size_t num_ids, size_t *indices) {
+  return _d3plot_id_indices(plot_file, D3PLT_ID_NODE, D3PLT_PTR_NODE_IDS,
+                            plot_file->control_data.numnp, ids, num_ids,
+                            indices);
+}
+
+size_t d3plot_solid_indices(d3plot_file *plot_file, const d3_word *ids,
+                            size_t num_ids, size_t *indices) {
+  return _d3plot_id_indices(plot_file, D3PLT_ELEMENT_SOLID, D3PLT_PTR_EL8_IDS,
+                            plot_file->control_data.nel8, ids, num_ids,
+                            indices);
+}
+
+size_t d3plot_thick_shell_indices(d3plot_file *plot_file, const d3_word *ids,
+                                  size_t num_ids, size_t *indices) {
+  return _d3plot_id_indices(plot_file, D3PLT_ELEMENT_THICK_SHELL,
+                            D3PLT_PTR_ELT_IDS, plot_file->control_data.nelt,
+                            ids, num_ids, indices);
+}
+
+size_t d3plot_beam_indices(d3plot_file *plot_file, const d3_word *ids,
+                           size_t num_ids, size_t *indices) {
+  return _d3plot_id_indices(plot_file, D3PLT_ELEMENT_BEAM, D3PLT_PTR_EL2_IDS,
+                            plot_file->control_data.nel2, ids, num_ids,
+                            indices);
+}
+
+size_t d3plot_shell_indices(d3plot_file *plot_file, const d3_word *ids,
+                            size_t num_ids, size_t *indices) {
+  return _d3plot_id_indices(plot_file, D3PLT_ELEMENT_SHELL, D3PLT_PTR_EL4_IDS,
+                            plot_file->control_data.nel4, ids, num_ids,
+                            indices);
+}
+
+size_t d3plot_part_indices(d3plot_file *plot_file, const d3_word *ids,
+                           size_t num_ids, size_t *indices) {
+  return _d3plot_id_indices(plot_file, D3PLT_ID_PART, D3PLT_PTR_PART_IDS,
+                            plot_file->control_data.nmmat, ids, num_ids,
+                            indices);
+}
+
 double *d3plot_read_node_coordinates(d3plot_file *plot_file, size_t state,
                                      size_t *num_nodes) {
   return _d3plot_read_node_data(plot_file, state, num_nodes,
@@ -489,146 +611,237 @@ double *d3plot_read_node_acceleration(d3plot_file *plot_file, size_t state,
                                 D3PLT_PTR_STATE_NODE_ACC);
 }
 
-double d3plot_read_time(d3plot_file *plot_file, size_t state) {
+int d3plot_read_node_coordinates_into(d3plot_file *plot_file, size_t state,
+                                      double *coords) {
+  return _d3plot_read_node_data_into(plot_file, state,
+                                     D3PLT_PTR_STATE_NODE_COORDS, coords);
+}
+
+int d3plot_read_node_velocity_into(d3plot_file *plot_file, size_t state,
+                                   double *velocity) {
+  return _d3plot_read_node_data_into(plot_file, state, D3PLT_PTR_STATE_NODE_VEL,
+                                     velocity);
+}
+
+int d3plot_read_node_acceleration_into(d3plot_file *plot_file, size_t state,
+                                       double *acceleration) {
+  return _d3plot_read_node_data_into(plot_file, state, D3PLT_PTR_STATE_NODE_ACC,
+                                     acceleration);
+}
+
+double *d3plot_read_node_initial_coordinates(d3plot_file *plot_file,
+                                             size_t *num_nodes) {
+  *num_nodes = plot_file->control_data.numnp;
+  double *coords = malloc(*num_nodes * 3 * sizeof(double));
+  memcpy(coords, _d3plot_initial_coordinates(plot_file),
+         *num_nodes * 3 * sizeof(double));
+  return coords;
+}
+
+double *d3plot_read_node_displacement(d3plot_file *plot_file, size_t state,
+                                      size_t *num_nodes) {
+  *num_nodes = plot_file->control_data.numnp;
+  double *displacement = malloc(*num_nodes * 3 * sizeof(double));
+  if (!d3plot_read_node_displacement_into(plot_file, state, displacement,
+                                          NULL)) {
+    free(displacement);
+    *num_nodes = 0;
+    return NULL;
+  }
+
+  return displacement;
+}
+
+double *d3plot_read_node_displacement_magnitude(d3plot_file *plot_file,
+                                                size_t state,
+                                                size_t *num_nodes) {
+  *num_nodes = plot_file->control_data.numnp;
+  double *magnitudes = malloc(*num_nodes * sizeof(double));
+  if (!d3plot_read_node_displacement_into(plot_file, state, NULL,
+                                          magnitudes)) {
+    free(magnitudes);
+    *num_nodes = 0;
+    return NULL;
+  }
+
+  return magnitudes;
+}
+
+int d3plot_read_node_displacement_into(d3plot_file *plot_file, size_t state,
+                                       double *displacement,
+                                       double *magnitudes) {
   if (state >= plot_file->num_states) {
     plot_file->error_string = malloc(70);
-    sprintf(plot_file->error_string, "%d is out of bounds for the states");
-    return -1.0;
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return 0;
+  }
+
+  const size_t num_nodes = plot_file->control_data.numnp;
+  const double *initial_coords = _d3plot_initial_coordinates(plot_file);
+  if (!displacement) {
+    displacement = _d3plot_scratch(plot_file, num_nodes * 3 * sizeof(double));
   }
 
-  double time;
+  /* Read the coordinates directly into displacement and subtract the initial
+   * coordinates in place. Single precision coordinates are read into the
+   * second half and widened by the same pass*/
+  const size_t word_pos = plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                          plot_file->data_pointers[D3PLT_PTR_STATE_NODE_COORDS];
   if (plot_file->buffer.word_size == 4) {
-    float time32;
-    d3_buffer_read_words_at(&plot_file->buffer, &time32, 1,
-                            plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-                                plot_file->data_pointers[D3PLT_PTR_STATE_TIME]);
-    time = time32;
+    float *coords = (float *)displacement + num_nodes * 3;
+    d3_buffer_read_words_at(&plot_file->buffer, coords, num_nodes * 3,
+                            word_pos);
+    d3_kernel_displacement_f32(displacement, magnitudes, coords,
+                               initial_coords, num_nodes);
   } else {
-    d3_buffer_read_words_at(&plot_file->buffer, &time, 1,
-                            plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-                                plot_file->data_pointers[D3PLT_PTR_STATE_TIME]);
+    d3_buffer_read_words_at(&plot_file->buffer, displacement, num_nodes * 3,
+                            word_pos);
+    d3_kernel_displacement_f64(displacement, magnitudes, displacement,
+                               initial_coords, num_nodes);
   }
 
-  return time;
+  return 1;
 }
 
-d3plot_solid *d3plot_read_solids_state(d3plot_file *plot_file, size_t state,
-                                       size_t *num_solids) {
-  *num_solids = plot_file->control_data.nel8;
-  if (*num_solids == 0) {
-    return NULL;
-  }
-
+double d3plot_read_time(d3plot_file *plot_file, size_t state) {
   if (state >= plot_file->num_states) {
-    plot_file->error_string = malloc(50);
+    plot_file->error_string = malloc(70);
     sprintf(plot_file->error_string, "%d is out of bounds for the states",
-            state);
-    *num_solids = 0;
+            (int)state);
+    return -1.0;
+  }
+
+  return plot_file->state_times[state];
+}
+
+double *d3plot_read_times(d3plot_file *plot_file, size_t *num_states) {
+  *num_states = plot_file->num_states;
+  if (*num_states == 0) {
     return NULL;
   }
 
-  d3plot_solid *solids = malloc(*num_solids * sizeof(d3plot_solid));
-  if (plot_file->buffer.word_size == 4) {
-    float *data =
-        malloc((plot_file->control_data.nel8 * plot_file->control_data.nv3d) *
-               sizeof(float));
+  double *times = malloc(*num_states * sizeof(double));
+  memcpy(times, plot_file->state_times, *num_states * sizeof(double));
+  return times;
+}
 
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nel8 * plot_file->control_data.nv3d,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_SOLID]);
+double *d3plot_read_global_history(d3plot_file *plot_file, size_t *num_states,
+                                   size_t *num_globals) {
+  *num_states = plot_file->num_states;
+  *num_globals = plot_file->control_data.nglbv;
+  if (*num_states == 0 || *num_globals == 0) {
+    return NULL;
+  }
 
-    size_t i = 0;
-    size_t o = 0;
-    while (i < *num_solids) {
-      /* Docs: page 33*/
-      const size_t start = o;
-      solids[i].sigma.x = data[o++];
-      solids[i].sigma.y = data[o++];
-      solids[i].sigma.z = data[o++];
-      solids[i].sigma.xy = data[o++];
-      solids[i].sigma.yz = data[o++];
-      solids[i].sigma.zx = data[o++];
-      solids[i].effective_plastic_strain = data[o++];
-      if (plot_file->control_data.neiph > 0) {
-        solids[i].extra1 = data[o++];
-        if (plot_file->control_data.neiph > 1) {
-          solids[i].extra2 = data[o++];
-          if (plot_file->control_data.neiph >= 6) {
-            /* We need -1 since we start by 0 and in the docs they start with
-             * 1*/
-            solids[i].epsilon.x =
-                data[start + 7 + plot_file->control_data.neiph - 5 - 1];
-            solids[i].epsilon.y =
-                data[start + 7 + plot_file->control_data.neiph - 4 - 1];
-            solids[i].epsilon.z =
-                data[start + 7 + plot_file->control_data.neiph - 3 - 1];
-            solids[i].epsilon.xy =
-                data[start + 7 + plot_file->control_data.neiph - 2 - 1];
-            solids[i].epsilon.yz =
-                data[start + 7 + plot_file->control_data.neiph - 1 - 1];
-            solids[i].epsilon.zx =
-                data[start + 7 + plot_file->control_data.neiph - 0 - 1];
-            o = start + 7 + plot_file->control_data.neiph;
-          } else {
-            memset(&solids[i].epsilon, 0, 6 * sizeof(double));
-          }
-        } else {
-          memset(&solids[i].extra2, 0, 7 * sizeof(double));
-        }
-      } else {
-        memset(&solids[i].extra1, 0, 8 * sizeof(double));
-      }
+  double *history = malloc(*num_states * *num_globals * sizeof(double));
+  _d3plot_read_globals(plot_file, 0, *num_states, history);
+  return history;
+}
 
-      i++;
+int d3plot_read_part_global_history(d3plot_file *plot_file,
+                                    unsigned int quantities,
+                                    double **histories, size_t *num_states,
+                                    size_t *num_parts) {
+  *num_states = plot_file->num_states;
+  *num_parts = plot_file->control_data.nummat8 +
+               plot_file->control_data.nummat2 +
+               plot_file->control_data.nummat4 +
+               plot_file->control_data.nummatt + plot_file->control_data.numrbs;
+  const size_t num_globals = plot_file->control_data.nglbv;
+  /* The values of the parts follow the first six global values*/
+  const size_t parts_offset = D3PLT_GLOBAL_VELOCITY_Z + 1;
+
+  int q = 0;
+  while (q < D3PLT_PART_QUANTITY_COUNT) {
+    histories[q] = NULL;
+    q++;
+  }
+
+  if (*num_states == 0 || *num_parts == 0) {
+    return 1;
+  }
+  if (parts_offset + D3PLT_PART_QUANTITY_COUNT * *num_parts > num_globals) {
+    plot_file->error_string = malloc(70);
+    sprintf(plot_file->error_string,
+            "GLOBAL does not hold the values of %d parts", (int)*num_parts);
+    return 0;
+  }
+
+  q = 0;
+  while (q < D3PLT_PART_QUANTITY_COUNT) {
+    if (quantities & (1 << q)) {
+      histories[q] = malloc(*num_states * *num_parts * sizeof(double));
     }
+    q++;
+  }
 
-    free(data);
-  } else {
-    double *data =
-        malloc((plot_file->control_data.nel8 * plot_file->control_data.nv3d) *
-               sizeof(double));
+  /* Go through the states in chunks, so that all quantities are taken out of
+   * a single read of the GLOBAL blocks without holding all of them at once*/
+  double *globals =
+      malloc(D3PLT_GLOBAL_MAX_STATES * num_globals * sizeof(double));
 
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nel8 * plot_file->control_data.nv3d,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_SOLID]);
+  size_t state = 0;
+  while (state < *num_states) {
+    const size_t num_chunk_states =
+        *num_states - state < D3PLT_GLOBAL_MAX_STATES
+            ? *num_states - state
+            : D3PLT_GLOBAL_MAX_STATES;
+    _d3plot_read_globals(plot_file, state, state + num_chunk_states, globals);
 
     size_t i = 0;
-    size_t o = 0;
-    while (i < *num_solids) {
-      /* Docs: page 33*/
-      const size_t start = o;
-      /* We can just copy the first 7 values*/
-      memcpy(&solids[i], &data[o], 7 * sizeof(double));
-      o += 7;
-      if (plot_file->control_data.neiph > 0) {
-        solids[i].extra1 = data[o++];
-        if (plot_file->control_data.neiph > 1) {
-          solids[i].extra2 = data[o++];
-          if (plot_file->control_data.neiph >= 6) {
-            /* We need -1 since we start by 0 and in the docs they start with
-             * 1*/
-            memcpy(&solids[i].epsilon,
-                   &data[start + 7 + plot_file->control_data.neiph - 5 - 1],
-                   6 * sizeof(double));
-            o = start + 7 + plot_file->control_data.neiph;
-          } else {
-            memset(&solids[i].epsilon, 0, 6 * sizeof(double));
-          }
-        } else {
-          memset(&solids[i].extra2, 0, 7 * sizeof(double));
+    while (i < num_chunk_states) {
+      q = 0;
+      while (q < D3PLT_PART_QUANTITY_COUNT) {
+        if (histories[q]) {
+          memcpy(&histories[q][(state + i) * *num_parts],
+                 &globals[i * num_globals + parts_offset + q * *num_parts],
+                 *num_parts * sizeof(double));
         }
-      } else {
-        memset(&solids[i].extra1, 0, 8 * sizeof(double));
+        q++;
       }
-
       i++;
     }
 
-    free(data);
+    state += num_chunk_states;
+  }
+
+  free(globals);
+  return 1;
+}
+
+size_t d3plot_find_state(d3plot_file *plot_file, double time) {
+  /* Binary search for the last state whose time is less than or equal to
+   * time. The times of the states are always ascending*/
+  size_t low = 0;
+  size_t high = plot_file->num_states;
+  while (high - low > 1) {
+    const size_t mid = low + (high - low) / 2;
+    if (plot_file->state_times[mid] <= time) {
+      low = mid;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+d3plot_solid *d3plot_read_solids_state(d3plot_file *plot_file, size_t state,
+                                       size_t *num_solids) {
+  *num_solids = plot_file->control_data.nel8;
+  if (*num_solids == 0) {
+    return NULL;
+  }
+
+  size_t value_map[sizeof(d3plot_solid) / sizeof(double)];
+  const size_t num_values = _d3plot_solid_value_map(plot_file, value_map);
+
+  d3plot_solid *solids = (d3plot_solid *)_d3plot_read_element_data(
+      plot_file, state, *num_solids, plot_file->control_data.nv3d,
+      D3PLT_PTR_STATE_ELEMENT_SOLID, value_map, num_values);
+  if (!solids) {
+    *num_solids = 0;
   }
 
   return solids;
@@ -642,134 +855,16 @@ d3plot_thick_shell *d3plot_read_thick_shells_state(d3plot_file *plot_file,
     return NULL;
   }
 
-  if (state >= plot_file->num_states) {
-    plot_file->error_string = malloc(50);
-    sprintf(plot_file->error_string, "%d is out of bounds for the states",
-            state);
-    *num_thick_shells = 0;
-    return NULL;
-  }
+  size_t value_map[sizeof(d3plot_thick_shell) / sizeof(double)];
+  const size_t num_values =
+      _d3plot_thick_shell_value_map(plot_file, value_map);
 
   d3plot_thick_shell *thick_shells =
-      malloc(*num_thick_shells * sizeof(d3plot_thick_shell));
-  if (plot_file->buffer.word_size == 4) {
-    float *data = malloc(plot_file->control_data.nelt *
-                         plot_file->control_data.nv3dt * sizeof(float));
-
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nelt * plot_file->control_data.nv3dt,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_THICK_SHELL]);
-
-    size_t i = 0;
-    size_t o = 0;
-    while (i < *num_thick_shells) {
-      thick_shells[i].mid.sigma.x = data[o++];
-      thick_shells[i].mid.sigma.y = data[o++];
-      thick_shells[i].mid.sigma.z = data[o++];
-      thick_shells[i].mid.sigma.xy = data[o++];
-      thick_shells[i].mid.sigma.yz = data[o++];
-      thick_shells[i].mid.sigma.zx = data[o++];
-      thick_shells[i].mid.effective_plastic_strain = data[o++];
-      /* TODO: Define NEIPS additional history values here for mid surface*/
-      o += plot_file->control_data.neips;
-      thick_shells[i].inner.sigma.x = data[o++];
-      thick_shells[i].inner.sigma.y = data[o++];
-      thick_shells[i].inner.sigma.z = data[o++];
-      thick_shells[i].inner.sigma.xy = data[o++];
-      thick_shells[i].inner.sigma.yz = data[o++];
-      thick_shells[i].inner.sigma.zx = data[o++];
-      thick_shells[i].inner.effective_plastic_strain = data[o++];
-      /* TODO: Define NEIPS additional history values here for inner surface*/
-      o += plot_file->control_data.neips;
-      thick_shells[i].outer.sigma.x = data[o++];
-      thick_shells[i].outer.sigma.y = data[o++];
-      thick_shells[i].outer.sigma.z = data[o++];
-      thick_shells[i].outer.sigma.xy = data[o++];
-      thick_shells[i].outer.sigma.yz = data[o++];
-      thick_shells[i].outer.sigma.zx = data[o++];
-      thick_shells[i].outer.effective_plastic_strain = data[o++];
-      /* TODO: Define NEIPS additional history values here for outer surface*/
-      o += plot_file->control_data.neips;
-      if (plot_file->control_data.istrn == 1) {
-        thick_shells[i].inner_epsilon.x = data[o++];
-        thick_shells[i].inner_epsilon.y = data[o++];
-        thick_shells[i].inner_epsilon.z = data[o++];
-        thick_shells[i].inner_epsilon.xy = data[o++];
-        thick_shells[i].inner_epsilon.yz = data[o++];
-        thick_shells[i].inner_epsilon.zx = data[o++];
-
-        thick_shells[i].outer_epsilon.x = data[o++];
-        thick_shells[i].outer_epsilon.y = data[o++];
-        thick_shells[i].outer_epsilon.z = data[o++];
-        thick_shells[i].outer_epsilon.xy = data[o++];
-        thick_shells[i].outer_epsilon.yz = data[o++];
-        thick_shells[i].outer_epsilon.zx = data[o++];
-      } else {
-        memset(&thick_shells[i].inner_epsilon, 0, 12 * sizeof(double));
-      }
-
-      if (plot_file->control_data.maxint > 3) {
-        /* TODO: If MAXINT > 3 then define an additional (MAXINT-3 )* (6 *
-         * IOSHL(1) +1*IOSHL(2)+NEIPS) quantities here.*/
-        o += (plot_file->control_data.maxint - 3) *
-             (6 * plot_file->control_data.ioshl[0] +
-              1 * plot_file->control_data.ioshl[1] +
-              plot_file->control_data.neips);
-      }
-
-      i++;
-    }
-
-    free(data);
-  } else {
-    double *data = malloc(plot_file->control_data.nelt *
-                          plot_file->control_data.nv3dt * sizeof(double));
-
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nelt * plot_file->control_data.nv3dt,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_THICK_SHELL]);
-
-    size_t i = 0;
-    size_t o = 0;
-    while (i < *num_thick_shells) {
-      memcpy(&thick_shells[i].mid, &data[o], 7 * sizeof(double));
-      o += 7;
-      /* TODO: Define NEIPS additional history values here for mid surface*/
-      o += plot_file->control_data.neips;
-      memcpy(&thick_shells[i].inner, &data[o], 7 * sizeof(double));
-      o += 7;
-      /* TODO: Define NEIPS additional history values here for inner surface*/
-      o += plot_file->control_data.neips;
-      memcpy(&thick_shells[i].outer, &data[o], 7 * sizeof(double));
-      o += 7;
-      /* TODO: Define NEIPS additional history values here for outer surface*/
-      o += plot_file->control_data.neips;
-      if (plot_file->control_data.istrn == 1) {
-        memcpy(&thick_shells[i].inner_epsilon, &data[o], 6 * sizeof(double));
-        o += 6;
-        memcpy(&thick_shells[i].outer_epsilon, &data[o], 6 * sizeof(double));
-        o += 6;
-      } else {
-        memset(&thick_shells[i].inner_epsilon, 0, 12 * sizeof(double));
-      }
-
-      if (plot_file->control_data.maxint > 3) {
-        /* TODO: If MAXINT > 3 then define an additional (MAXINT-3 )* (6 *
-         * IOSHL(1) +1*IOSHL(2)+NEIPS) quantities here.*/
-        o += (plot_file->control_data.maxint - 3) *
-             (6 * plot_file->control_data.ioshl[0] +
-              1 * plot_file->control_data.ioshl[1] +
-              plot_file->control_data.neips);
-      }
-
-      i++;
-    }
-
-    free(data);
+      (d3plot_thick_shell *)_d3plot_read_element_data(
+          plot_file, state, *num_thick_shells, plot_file->control_data.nv3dt,
+          D3PLT_PTR_STATE_ELEMENT_THICK_SHELL, value_map, num_values);
+  if (!thick_shells) {
+    *num_thick_shells = 0;
   }
 
   return thick_shells;
@@ -782,69 +877,14 @@ d3plot_beam *d3plot_read_beams_state(d3plot_file *plot_file, size_t state,
     return NULL;
   }
 
-  if (state >= plot_file->num_states) {
-    plot_file->error_string = malloc(50);
-    sprintf(plot_file->error_string, "%d is out of bounds for the states",
-            state);
-    *num_beams = 0;
-    return NULL;
-  }
-
-  d3plot_beam *beams = malloc(*num_beams * sizeof(d3plot_beam));
-  if (plot_file->buffer.word_size == 4) {
-    float *data = malloc(plot_file->control_data.nel2 *
-                         plot_file->control_data.nv1d * sizeof(float));
-
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nel2 * plot_file->control_data.nv1d,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_BEAM]);
-
-    size_t i = 0;
-    size_t o = 0;
-    while (i < *num_beams) {
-      beams[i].axial_force = data[o++];
-      beams[i].s_shear_resultant = data[o++];
-      beams[i].t_shear_resultant = data[o++];
-      beams[i].s_bending_moment = data[o++];
-      beams[i].t_bending_moment = data[o++];
-      beams[i].torsional_resultant = data[o++];
-      if (plot_file->control_data.nv1d > 6) {
-        /* TODO: If there are values output at beam integration points, then
-         * NV1D = 6 + 5 * BEAMIP*/
-        o += plot_file->control_data.nv1d - 6;
-      }
-
-      i++;
-    }
-
-    free(data);
-  } else {
-    double *data = malloc(plot_file->control_data.nel2 *
-                          plot_file->control_data.nv1d * sizeof(double));
-
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nel2 * plot_file->control_data.nv1d,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_BEAM]);
-
-    size_t i = 0;
-    size_t o = 0;
-    while (i < *num_beams) {
-      memcpy(&beams[i], &data[o], sizeof(d3plot_beam));
-      o += sizeof(d3plot_beam) / sizeof(double);
-      if (plot_file->control_data.nv1d > 6) {
-        /* TODO: If there are values output at beam integration points, then
-         * NV1D = 6 + 5 * BEAMIP*/
-        o += plot_file->control_data.nv1d - 6;
-      }
-
-      i++;
-    }
+  size_t value_map[sizeof(d3plot_beam) / sizeof(double)];
+  const size_t num_values = _d3plot_beam_value_map(plot_file, value_map);
 
-    free(data);
+  d3plot_beam *beams = (d3plot_beam *)_d3plot_read_element_data(
+      plot_file, state, *num_beams, plot_file->control_data.nv1d,
+      D3PLT_PTR_STATE_ELEMENT_BEAM, value_map, num_values);
+  if (!beams) {
+    *num_beams = 0;
   }
 
   return beams;
@@ -857,215 +897,591 @@ d3plot_shell *d3plot_read_shells_state(d3plot_file *plot_file, size_t state,
     return NULL;
   }
 
-  if (state >= plot_file->num_states) {
-    plot_file->error_string = malloc(50);
-    sprintf(plot_file->error_string, "%d is out of bounds for the states",
-            state);
+  size_t value_map[sizeof(d3plot_shell) / sizeof(double)];
+  const size_t num_values = _d3plot_shell_value_map(plot_file, value_map);
+
+  d3plot_shell *shells = (d3plot_shell *)_d3plot_read_element_data(
+      plot_file, state, *num_shells, plot_file->control_data.nv2d,
+      D3PLT_PTR_STATE_ELEMENT_SHELL, value_map, num_values);
+  if (!shells) {
     *num_shells = 0;
-    return NULL;
   }
 
-  d3plot_shell *shells = malloc(*num_shells * sizeof(d3plot_shell));
-  if (plot_file->buffer.word_size == 4) {
-    float *data = malloc(plot_file->control_data.nel4 *
-                         plot_file->control_data.nv2d * sizeof(float));
+  return shells;
+}
 
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nel4 * plot_file->control_data.nv2d,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_SHELL]);
+int d3plot_read_solids_state_into(d3plot_file *plot_file, size_t state,
+                                  d3plot_solid *solids) {
+  size_t value_map[sizeof(d3plot_solid) / sizeof(double)];
+  const size_t num_values = _d3plot_solid_value_map(plot_file, value_map);
 
-    size_t i = 0;
-    size_t o = 0;
-    while (i < *num_shells) {
-      shells[i].mid.sigma.x = data[o++];
-      shells[i].mid.sigma.y = data[o++];
-      shells[i].mid.sigma.z = data[o++];
-      shells[i].mid.sigma.xy = data[o++];
-      shells[i].mid.sigma.yz = data[o++];
-      shells[i].mid.sigma.zx = data[o++];
-      shells[i].mid.effective_plastic_strain = data[o++];
-      /* TODO: Define NEIPS additional history values here for mid surface*/
-      o += plot_file->control_data.neips;
-      shells[i].inner.sigma.x = data[o++];
-      shells[i].inner.sigma.y = data[o++];
-      shells[i].inner.sigma.z = data[o++];
-      shells[i].inner.sigma.xy = data[o++];
-      shells[i].inner.sigma.yz = data[o++];
-      shells[i].inner.sigma.zx = data[o++];
-      shells[i].inner.effective_plastic_strain = data[o++];
-      /* TODO: Define NEIPS additional history values here for inner surface*/
-      o += plot_file->control_data.neips;
-      shells[i].outer.sigma.x = data[o++];
-      shells[i].outer.sigma.y = data[o++];
-      shells[i].outer.sigma.z = data[o++];
-      shells[i].outer.sigma.xy = data[o++];
-      shells[i].outer.sigma.yz = data[o++];
-      shells[i].outer.sigma.zx = data[o++];
-      shells[i].outer.effective_plastic_strain = data[o++];
-      /* TODO: Define NEIPS additional history values here for outer surface*/
-      o += plot_file->control_data.neips;
-      if (plot_file->control_data.maxint > 3) {
-        /* TODO: If MAXINT >3 then define an additional (MAXINT-3 )* (6*IOSHL(1)
-         * + 1*IOSHL(2) + 8*IOSHL(3) + 4*IOSHL(4) + NEIPS) quantities here*/
-        o += (plot_file->control_data.maxint - 3) *
-             (6 * plot_file->control_data.ioshl[0] +
-              1 * plot_file->control_data.ioshl[1] +
-              8 * plot_file->control_data.ioshl[2] +
-              4 * plot_file->control_data.ioshl[3] +
-              plot_file->control_data.neips);
-      }
-      /* TODO:
-       * Bending moment-Mx (local shell coordinate system)
-       * Bending moment-My
-       * Bending moment-Mxy
-       * Shear resultant-Qx
-       * Shear resultant-Qy
-       * Normal resultant-Nx
-       * Normal resultant-Ny
-       * Normal resultant-Nxy
-       * Thickness
-       * Element dependent variable
-       * Element dependent variable*/
-      o += 11;
-      if (plot_file->control_data.istrn == 0) {
-        shells[i].internal_energy = data[o++];
-        memset(&shells[i].inner_epsilon, 0, 2 * sizeof(d3plot_tensor));
-      } else if (plot_file->control_data.istrn == 1) {
-        shells[i].inner_epsilon.x = data[o++];
-        shells[i].inner_epsilon.y = data[o++];
-        shells[i].inner_epsilon.z = data[o++];
-        shells[i].inner_epsilon.xy = data[o++];
-        shells[i].inner_epsilon.yz = data[o++];
-        shells[i].inner_epsilon.zx = data[o++];
-
-        shells[i].outer_epsilon.x = data[o++];
-        shells[i].outer_epsilon.y = data[o++];
-        shells[i].outer_epsilon.z = data[o++];
-        shells[i].outer_epsilon.xy = data[o++];
-        shells[i].outer_epsilon.yz = data[o++];
-        shells[i].outer_epsilon.zx = data[o++];
-
-        if (plot_file->control_data.nv2d >= 45) {
-          shells[i].internal_energy = data[o++];
-        } else {
-          shells[i].internal_energy = 0.0;
-        }
-      }
+  return _d3plot_read_element_data_into(
+      plot_file, state, plot_file->control_data.nel8,
+      plot_file->control_data.nv3d, D3PLT_PTR_STATE_ELEMENT_SOLID, value_map,
+      num_values, (double *)solids);
+}
 
-      i++;
-    }
+int d3plot_read_thick_shells_state_into(d3plot_file *plot_file, size_t state,
+                                        d3plot_thick_shell *thick_shells) {
+  size_t value_map[sizeof(d3plot_thick_shell) / sizeof(double)];
+  const size_t num_values =
+      _d3plot_thick_shell_value_map(plot_file, value_map);
 
-    free(data);
-  } else {
-    double *data = malloc(plot_file->control_data.nel4 *
-                          plot_file->control_data.nv2d * sizeof(double));
+  return _d3plot_read_element_data_into(
+      plot_file, state, plot_file->control_data.nelt,
+      plot_file->control_data.nv3dt, D3PLT_PTR_STATE_ELEMENT_THICK_SHELL,
+      value_map, num_values, (double *)thick_shells);
+}
 
-    d3_buffer_read_words_at(
-        &plot_file->buffer, data,
-        plot_file->control_data.nel4 * plot_file->control_data.nv2d,
-        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-            plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_SHELL]);
+int d3plot_read_beams_state_into(d3plot_file *plot_file, size_t state,
+                                 d3plot_beam *beams) {
+  size_t value_map[sizeof(d3plot_beam) / sizeof(double)];
+  const size_t num_values = _d3plot_beam_value_map(plot_file, value_map);
 
-    size_t i = 0;
-    size_t o = 0;
-    while (i < *num_shells) {
-      memcpy(&shells[i].mid, &data[o], sizeof(d3plot_surface));
-      o += sizeof(d3plot_surface) / sizeof(double);
-      /* TODO: Define NEIPS additional history values here for mid surface*/
-      o += plot_file->control_data.neips;
-      memcpy(&shells[i].inner, &data[o], sizeof(d3plot_surface));
-      o += sizeof(d3plot_surface) / sizeof(double);
-      /* TODO: Define NEIPS additional history values here for inner surface*/
-      o += plot_file->control_data.neips;
-      memcpy(&shells[i].outer, &data[o], sizeof(d3plot_surface));
-      o += sizeof(d3plot_surface) / sizeof(double);
-      /* TODO: Define NEIPS additional history values here for outer surface*/
-      o += plot_file->control_data.neips;
-      if (plot_file->control_data.maxint > 3) {
-        /* TODO: If MAXINT >3 then define an additional (MAXINT-3 )* (6*IOSHL(1)
-         * + 1*IOSHL(2) + 8*IOSHL(3) + 4*IOSHL(4) + NEIPS) quantities here*/
-        o += (plot_file->control_data.maxint - 3) *
-             (6 * plot_file->control_data.ioshl[0] +
-              1 * plot_file->control_data.ioshl[1] +
-              8 * plot_file->control_data.ioshl[2] +
-              4 * plot_file->control_data.ioshl[3] +
-              plot_file->control_data.neips);
-      }
-      /* TODO:
-       * Bending moment-Mx (local shell coordinate system)
-       * Bending moment-My
-       * Bending moment-Mxy
-       * Shear resultant-Qx
-       * Shear resultant-Qy
-       * Normal resultant-Nx
-       * Normal resultant-Ny
-       * Normal resultant-Nxy
-       * Thickness
-       * Element dependent variable
-       * Element dependent variable*/
-      o += 11;
-      if (plot_file->control_data.istrn == 0) {
-        shells[i].internal_energy = data[o++];
-        memset(&shells[i].inner_epsilon, 0, 2 * sizeof(d3plot_tensor));
-      } else if (plot_file->control_data.istrn == 1) {
-        memcpy(&shells[i].inner_epsilon, &data[o], 2 * sizeof(d3plot_tensor));
-        o += 2 * sizeof(d3plot_tensor) / sizeof(double);
-
-        if (plot_file->control_data.nv2d >= 45) {
-          shells[i].internal_energy = data[o++];
-        } else {
-          shells[i].internal_energy = 0.0;
-        }
-      }
+  return _d3plot_read_element_data_into(
+      plot_file, state, plot_file->control_data.nel2,
+      plot_file->control_data.nv1d, D3PLT_PTR_STATE_ELEMENT_BEAM, value_map,
+      num_values, (double *)beams);
+}
 
-      i++;
-    }
+int d3plot_read_shells_state_into(d3plot_file *plot_file, size_t state,
+                                  d3plot_shell *shells) {
+  size_t value_map[sizeof(d3plot_shell) / sizeof(double)];
+  const size_t num_values = _d3plot_shell_value_map(plot_file, value_map);
 
-    free(data);
-  }
+  return _d3plot_read_element_data_into(
+      plot_file, state, plot_file->control_data.nel4,
+      plot_file->control_data.nv2d, D3PLT_PTR_STATE_ELEMENT_SHELL, value_map,
+      num_values, (double *)shells);
+}
 
-  return shells;
+double *d3plot_read_solids_von_mises(d3plot_file *plot_file, size_t state,
+                                     size_t *num_solids) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_SOLID,
+                             D3PLT_SURFACE_MID, D3PLT_STRESS_VON_MISES,
+                             num_solids);
 }
 
-d3plot_solid_con *d3plot_read_solid_elements(d3plot_file *plot_file,
-                                             size_t *num_solids) {
-  if (plot_file->control_data.nel8 <= 0) {
-    /* nel8 represents the number of extra nodes for ten node solids*/
-    *num_solids = 0;
-    return NULL;
-  }
+double *d3plot_read_solids_pressure(d3plot_file *plot_file, size_t state,
+                                    size_t *num_solids) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_SOLID,
+                             D3PLT_SURFACE_MID, D3PLT_STRESS_PRESSURE,
+                             num_solids);
+}
 
-  *num_solids = plot_file->control_data.nel8;
-  d3plot_solid_con *solids = malloc(*num_solids * sizeof(d3plot_solid_con));
-  if (plot_file->buffer.word_size == 4) {
-    uint32_t *solids32 = malloc(*num_solids * 9 * sizeof(uint32_t));
-    d3_buffer_read_words_at(&plot_file->buffer, solids32, 9 * *num_solids,
-                            plot_file->data_pointers[D3PLT_PTR_EL8_CONNECT]);
+double *d3plot_read_solids_principal_stresses(d3plot_file *plot_file,
+                                              size_t state,
+                                              size_t *num_solids) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_SOLID,
+                             D3PLT_SURFACE_MID, D3PLT_STRESS_PRINCIPAL,
+                             num_solids);
+}
 
-    size_t i = 0;
-    while (i < *num_solids) {
-      size_t j = 0;
-      while (j < 8) {
-        solids[i].node_ids[j + 0] = solids32[i * 9 + j + 0];
-        solids[i].node_ids[j + 1] = solids32[i * 9 + j + 1];
-        solids[i].node_ids[j + 2] = solids32[i * 9 + j + 2];
-        solids[i].node_ids[j + 3] = solids32[i * 9 + j + 3];
+double *d3plot_read_thick_shells_von_mises(d3plot_file *plot_file,
+                                           size_t state, int surface,
+                                           size_t *num_thick_shells) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_THICK_SHELL,
+                             surface, D3PLT_STRESS_VON_MISES,
+                             num_thick_shells);
+}
 
-        j += 4;
-      }
-      solids[i].material_id = solids32[i * 9 + 8];
+double *d3plot_read_thick_shells_pressure(d3plot_file *plot_file, size_t state,
+                                          int surface,
+                                          size_t *num_thick_shells) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_THICK_SHELL,
+                             surface, D3PLT_STRESS_PRESSURE, num_thick_shells);
+}
 
-      i++;
-    }
+double *d3plot_read_thick_shells_principal_stresses(d3plot_file *plot_file,
+                                                    size_t state, int surface,
+                                                    size_t *num_thick_shells) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_THICK_SHELL,
+                             surface, D3PLT_STRESS_PRINCIPAL,
+                             num_thick_shells);
+}
 
-    free(solids32);
-  } else {
-    d3_buffer_read_words_at(&plot_file->buffer, solids, 9 * *num_solids,
-                            plot_file->data_pointers[D3PLT_PTR_EL8_CONNECT]);
+double *d3plot_read_shells_von_mises(d3plot_file *plot_file, size_t state,
+                                     int surface, size_t *num_shells) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_SHELL, surface,
+                             D3PLT_STRESS_VON_MISES, num_shells);
+}
+
+double *d3plot_read_shells_pressure(d3plot_file *plot_file, size_t state,
+                                    int surface, size_t *num_shells) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_SHELL, surface,
+                             D3PLT_STRESS_PRESSURE, num_shells);
+}
+
+double *d3plot_read_shells_principal_stresses(d3plot_file *plot_file,
+                                              size_t state, int surface,
+                                              size_t *num_shells) {
+  return _d3plot_read_stress(plot_file, state, D3PLT_ELEMENT_SHELL, surface,
+                             D3PLT_STRESS_PRINCIPAL, num_shells);
+}
+
+uint8_t *d3plot_read_node_deletion(d3plot_file *plot_file, size_t state,
+                                   size_t *num_nodes) {
+  *num_nodes = plot_file->control_data.numnp;
+  uint8_t *flags = _d3plot_read_deletion(plot_file, state, 1, 0, *num_nodes);
+  if (!flags) {
+    *num_nodes = 0;
+  }
+
+  return flags;
+}
+
+/* The element deletion data consists of the solids, thick shells, shells and
+ * beams in that order*/
+#define SOLID_DELETION_OFFSET 0
+#define THICK_SHELL_DELETION_OFFSET (plot_file->control_data.nel8)
+#define SHELL_DELETION_OFFSET                                                  \
+  (plot_file->control_data.nel8 + plot_file->control_data.nelt)
+#define BEAM_DELETION_OFFSET                                                   \
+  (plot_file->control_data.nel8 + plot_file->control_data.nelt +               \
+   plot_file->control_data.nel4)
+
+uint8_t *d3plot_read_solids_deletion(d3plot_file *plot_file, size_t state,
+                                     size_t *num_solids) {
+  *num_solids = plot_file->control_data.nel8;
+  uint8_t *flags = _d3plot_read_deletion(plot_file, state, 2,
+                                         SOLID_DELETION_OFFSET, *num_solids);
+  if (!flags) {
+    *num_solids = 0;
+  }
+
+  return flags;
+}
+
+uint8_t *d3plot_read_thick_shells_deletion(d3plot_file *plot_file,
+                                           size_t state,
+                                           size_t *num_thick_shells) {
+  *num_thick_shells = plot_file->control_data.nelt;
+  uint8_t *flags =
+      _d3plot_read_deletion(plot_file, state, 2, THICK_SHELL_DELETION_OFFSET,
+                            *num_thick_shells);
+  if (!flags) {
+    *num_thick_shells = 0;
+  }
+
+  return flags;
+}
+
+uint8_t *d3plot_read_beams_deletion(d3plot_file *plot_file, size_t state,
+                                    size_t *num_beams) {
+  *num_beams = plot_file->control_data.nel2;
+  uint8_t *flags = _d3plot_read_deletion(plot_file, state, 2,
+                                         BEAM_DELETION_OFFSET, *num_beams);
+  if (!flags) {
+    *num_beams = 0;
+  }
+
+  return flags;
+}
+
+uint8_t *d3plot_read_shells_deletion(d3plot_file *plot_file, size_t state,
+                                     size_t *num_shells) {
+  *num_shells = plot_file->control_data.nel4;
+  uint8_t *flags = _d3plot_read_deletion(plot_file, state, 2,
+                                         SHELL_DELETION_OFFSET, *num_shells);
+  if (!flags) {
+    *num_shells = 0;
+  }
+
+  return flags;
+}
+
+d3plot_solid *d3plot_read_solids_state_alive(d3plot_file *plot_file,
+                                             size_t state, size_t *num_solids,
+                                             size_t **element_indices) {
+  size_t value_map[sizeof(d3plot_solid) / sizeof(double)];
+  const size_t num_values = _d3plot_solid_value_map(plot_file, value_map);
+
+  return (d3plot_solid *)_d3plot_read_element_alive(
+      plot_file, state, SOLID_DELETION_OFFSET, plot_file->control_data.nel8,
+      plot_file->control_data.nv3d, D3PLT_PTR_STATE_ELEMENT_SOLID, value_map,
+      num_values, num_solids, element_indices);
+}
+
+d3plot_thick_shell *
+d3plot_read_thick_shells_state_alive(d3plot_file *plot_file, size_t state,
+                                     size_t *num_thick_shells,
+                                     size_t **element_indices) {
+  size_t value_map[sizeof(d3plot_thick_shell) / sizeof(double)];
+  const size_t num_values =
+      _d3plot_thick_shell_value_map(plot_file, value_map);
+
+  return (d3plot_thick_shell *)_d3plot_read_element_alive(
+      plot_file, state, THICK_SHELL_DELETION_OFFSET,
+      plot_file->control_data.nelt, plot_file->control_data.nv3dt,
+      D3PLT_PTR_STATE_ELEMENT_THICK_SHELL, value_map, num_values,
+      num_thick_shells, element_indices);
+}
+
+d3plot_beam *d3plot_read_beams_state_alive(d3plot_file *plot_file,
+                                           size_t state, size_t *num_beams,
+                                           size_t **element_indices) {
+  size_t value_map[sizeof(d3plot_beam) / sizeof(double)];
+  const size_t num_values = _d3plot_beam_value_map(plot_file, value_map);
+
+  return (d3plot_beam *)_d3plot_read_element_alive(
+      plot_file, state, BEAM_DELETION_OFFSET, plot_file->control_data.nel2,
+      plot_file->control_data.nv1d, D3PLT_PTR_STATE_ELEMENT_BEAM, value_map,
+      num_values, num_beams, element_indices);
+}
+
+d3plot_shell *d3plot_read_shells_state_alive(d3plot_file *plot_file,
+                                             size_t state, size_t *num_shells,
+                                             size_t **element_indices) {
+  size_t value_map[sizeof(d3plot_shell) / sizeof(double)];
+  const size_t num_values = _d3plot_shell_value_map(plot_file, value_map);
+
+  return (d3plot_shell *)_d3plot_read_element_alive(
+      plot_file, state, SHELL_DELETION_OFFSET, plot_file->control_data.nel4,
+      plot_file->control_data.nv2d, D3PLT_PTR_STATE_ELEMENT_SHELL, value_map,
+      num_values, num_shells, element_indices);
+}
+
+float *d3plot_read_node_coordinates_f32(d3plot_file *plot_file, size_t state,
+                                        size_t *num_nodes) {
+  return _d3plot_read_node_data_f32(plot_file, state, num_nodes,
+                                    D3PLT_PTR_STATE_NODE_COORDS);
+}
+
+float *d3plot_read_node_velocity_f32(d3plot_file *plot_file, size_t state,
+                                     size_t *num_nodes) {
+  return _d3plot_read_node_data_f32(plot_file, state, num_nodes,
+                                    D3PLT_PTR_STATE_NODE_VEL);
+}
+
+float *d3plot_read_node_acceleration_f32(d3plot_file *plot_file, size_t state,
+                                         size_t *num_nodes) {
+  return _d3plot_read_node_data_f32(plot_file, state, num_nodes,
+                                    D3PLT_PTR_STATE_NODE_ACC);
+}
+
+d3plot_solid_f32 *d3plot_read_solids_state_f32(d3plot_file *plot_file,
+                                               size_t state,
+                                               size_t *num_solids) {
+  *num_solids = plot_file->control_data.nel8;
+  if (*num_solids == 0) {
+    return NULL;
+  }
+
+  size_t value_map[sizeof(d3plot_solid_f32) / sizeof(float)];
+  const size_t num_values = _d3plot_solid_value_map(plot_file, value_map);
+
+  d3plot_solid_f32 *solids =
+      (d3plot_solid_f32 *)_d3plot_read_element_data_f32(
+          plot_file, state, *num_solids, plot_file->control_data.nv3d,
+          D3PLT_PTR_STATE_ELEMENT_SOLID, value_map, num_values);
+  if (!solids) {
+    *num_solids = 0;
+  }
+
+  return solids;
+}
+
+d3plot_shell_f32 *d3plot_read_shells_state_f32(d3plot_file *plot_file,
+                                               size_t state,
+                                               size_t *num_shells) {
+  *num_shells = plot_file->control_data.nel4;
+  if (*num_shells == 0) {
+    return NULL;
+  }
+
+  size_t value_map[sizeof(d3plot_shell_f32) / sizeof(float)];
+  const size_t num_values = _d3plot_shell_value_map(plot_file, value_map);
+
+  d3plot_shell_f32 *shells =
+      (d3plot_shell_f32 *)_d3plot_read_element_data_f32(
+          plot_file, state, *num_shells, plot_file->control_data.nv2d,
+          D3PLT_PTR_STATE_ELEMENT_SHELL, value_map, num_values);
+  if (!shells) {
+    *num_shells = 0;
+  }
+
+  return shells;
+}
+
+double *d3plot_read_solids_state_fields(d3plot_file *plot_file, size_t state,
+                                        unsigned int fields,
+                                        size_t *num_solids,
+                                        size_t *num_values) {
+  *num_solids = plot_file->control_data.nel8;
+  size_t value_map[sizeof(d3plot_solid) / sizeof(double)];
+  const size_t num_all_values = _d3plot_solid_value_map(plot_file, value_map);
+
+  double *values = _d3plot_read_element_data_fields(
+      plot_file, state, *num_solids, plot_file->control_data.nv3d,
+      D3PLT_PTR_STATE_ELEMENT_SOLID, value_map, num_all_values,
+      _d3plot_solid_fields, fields, num_values);
+  if (!values) {
+    *num_solids = 0;
+  }
+
+  return values;
+}
+
+double *d3plot_read_thick_shells_state_fields(d3plot_file *plot_file,
+                                              size_t state,
+                                              unsigned int fields,
+                                              size_t *num_thick_shells,
+                                              size_t *num_values) {
+  *num_thick_shells = plot_file->control_data.nelt;
+  size_t value_map[sizeof(d3plot_thick_shell) / sizeof(double)];
+  const size_t num_all_values =
+      _d3plot_thick_shell_value_map(plot_file, value_map);
+
+  double *values = _d3plot_read_element_data_fields(
+      plot_file, state, *num_thick_shells, plot_file->control_data.nv3dt,
+      D3PLT_PTR_STATE_ELEMENT_THICK_SHELL, value_map, num_all_values,
+      _d3plot_thick_shell_fields, fields, num_values);
+  if (!values) {
+    *num_thick_shells = 0;
+  }
+
+  return values;
+}
+
+double *d3plot_read_shells_state_fields(d3plot_file *plot_file, size_t state,
+                                        unsigned int fields,
+                                        size_t *num_shells,
+                                        size_t *num_values) {
+  *num_shells = plot_file->control_data.nel4;
+  size_t value_map[sizeof(d3plot_shell) / sizeof(double)];
+  const size_t num_all_values = _d3plot_shell_value_map(plot_file, value_map);
+
+  double *values = _d3plot_read_element_data_fields(
+      plot_file, state, *num_shells, plot_file->control_data.nv2d,
+      D3PLT_PTR_STATE_ELEMENT_SHELL, value_map, num_all_values,
+      _d3plot_shell_fields, fields, num_values);
+  if (!values) {
+    *num_shells = 0;
+  }
+
+  return values;
+}
+
+int d3plot_read_node_coordinates_soa(d3plot_file *plot_file, size_t state,
+                                     double *x, double *y, double *z) {
+  double *components[3];
+  components[0] = x;
+  components[1] = y;
+  components[2] = z;
+  const size_t value_map[3] = {0, 1, 2};
+
+  return _d3plot_read_element_data_soa(
+      plot_file, state, plot_file->control_data.numnp, 3,
+      D3PLT_PTR_STATE_NODE_COORDS, value_map, 3, components);
+}
+
+int d3plot_read_node_velocity_soa(d3plot_file *plot_file, size_t state,
+                                  double *x, double *y, double *z) {
+  double *components[3];
+  components[0] = x;
+  components[1] = y;
+  components[2] = z;
+  const size_t value_map[3] = {0, 1, 2};
+
+  return _d3plot_read_element_data_soa(
+      plot_file, state, plot_file->control_data.numnp, 3,
+      D3PLT_PTR_STATE_NODE_VEL, value_map, 3, components);
+}
+
+int d3plot_read_node_acceleration_soa(d3plot_file *plot_file, size_t state,
+                                      double *x, double *y, double *z) {
+  double *components[3];
+  components[0] = x;
+  components[1] = y;
+  components[2] = z;
+  const size_t value_map[3] = {0, 1, 2};
+
+  return _d3plot_read_element_data_soa(
+      plot_file, state, plot_file->control_data.numnp, 3,
+      D3PLT_PTR_STATE_NODE_ACC, value_map, 3, components);
+}
+
+int d3plot_read_solids_state_soa(d3plot_file *plot_file, size_t state,
+                                 double **components) {
+  size_t value_map[sizeof(d3plot_solid) / sizeof(double)];
+  const size_t num_values = _d3plot_solid_value_map(plot_file, value_map);
+
+  return _d3plot_read_element_data_soa(
+      plot_file, state, plot_file->control_data.nel8,
+      plot_file->control_data.nv3d, D3PLT_PTR_STATE_ELEMENT_SOLID, value_map,
+      num_values, components);
+}
+
+int d3plot_read_thick_shells_state_soa(d3plot_file *plot_file, size_t state,
+                                       double **components) {
+  size_t value_map[sizeof(d3plot_thick_shell) / sizeof(double)];
+  const size_t num_values =
+      _d3plot_thick_shell_value_map(plot_file, value_map);
+
+  return _d3plot_read_element_data_soa(
+      plot_file, state, plot_file->control_data.nelt,
+      plot_file->control_data.nv3dt, D3PLT_PTR_STATE_ELEMENT_THICK_SHELL,
+      value_map, num_values, components);
+}
+
+int d3plot_read_beams_state_soa(d3plot_file *plot_file, size_t state,
+                                double **components) {
+  size_t value_map[sizeof(d3plot_beam) / sizeof(double)];
+  const size_t num_values = _d3plot_beam_value_map(plot_file, value_map);
+
+  return _d3plot_read_element_data_soa(
+      plot_file, state, plot_file->control_data.nel2,
+      plot_file->control_data.nv1d, D3PLT_PTR_STATE_ELEMENT_BEAM, value_map,
+      num_values, components);
+}
+
+int d3plot_read_shells_state_soa(d3plot_file *plot_file, size_t state,
+                                 double **components) {
+  size_t value_map[sizeof(d3plot_shell) / sizeof(double)];
+  const size_t num_values = _d3plot_shell_value_map(plot_file, value_map);
+
+  return _d3plot_read_element_data_soa(
+      plot_file, state, plot_file->control_data.nel4,
+      plot_file->control_data.nv2d, D3PLT_PTR_STATE_ELEMENT_SHELL, value_map,
+      num_values, components);
+}
+
+double *d3plot_read_node_coordinates_history(d3plot_file *plot_file,
+                                             const size_t *node_indices,
+                                             size_t num_indices,
+                                             size_t *num_states) {
+  return _d3plot_read_node_history(plot_file, node_indices, num_indices,
+                                   num_states, D3PLT_PTR_STATE_NODE_COORDS);
+}
+
+double *d3plot_read_node_velocity_history(d3plot_file *plot_file,
+                                          const size_t *node_indices,
+                                          size_t num_indices,
+                                          size_t *num_states) {
+  return _d3plot_read_node_history(plot_file, node_indices, num_indices,
+                                   num_states, D3PLT_PTR_STATE_NODE_VEL);
+}
+
+double *d3plot_read_node_acceleration_history(d3plot_file *plot_file,
+                                              const size_t *node_indices,
+                                              size_t num_indices,
+                                              size_t *num_states) {
+  return _d3plot_read_node_history(plot_file, node_indices, num_indices,
+                                   num_states, D3PLT_PTR_STATE_NODE_ACC);
+}
+
+double *d3plot_read_solids_history(d3plot_file *plot_file,
+                                   const size_t *element_indices,
+                                   size_t num_indices, unsigned int fields,
+                                   size_t *num_states, size_t *num_values) {
+  size_t value_map[sizeof(d3plot_solid) / sizeof(double)];
+  const size_t num_struct_values =
+      _d3plot_solid_value_map(plot_file, value_map);
+
+  return _d3plot_read_element_history(
+      plot_file, element_indices, num_indices, plot_file->control_data.nel8,
+      plot_file->control_data.nv3d, D3PLT_PTR_STATE_ELEMENT_SOLID, value_map,
+      num_struct_values, _d3plot_solid_fields, fields, num_states, num_values);
+}
+
+double *d3plot_read_thick_shells_history(d3plot_file *plot_file,
+                                         const size_t *element_indices,
+                                         size_t num_indices,
+                                         unsigned int fields,
+                                         size_t *num_states,
+                                         size_t *num_values) {
+  size_t value_map[sizeof(d3plot_thick_shell) / sizeof(double)];
+  const size_t num_struct_values =
+      _d3plot_thick_shell_value_map(plot_file, value_map);
+
+  return _d3plot_read_element_history(
+      plot_file, element_indices, num_indices, plot_file->control_data.nelt,
+      plot_file->control_data.nv3dt, D3PLT_PTR_STATE_ELEMENT_THICK_SHELL,
+      value_map, num_struct_values, _d3plot_thick_shell_fields, fields,
+      num_states, num_values);
+}
+
+double *d3plot_read_beams_history(d3plot_file *plot_file,
+                                  const size_t *element_indices,
+                                  size_t num_indices, size_t *num_states) {
+  size_t value_map[sizeof(d3plot_beam) / sizeof(double)];
+  const size_t num_values = _d3plot_beam_value_map(plot_file, value_map);
+  size_t num_selected_values;
+
+  return _d3plot_read_element_history(
+      plot_file, element_indices, num_indices, plot_file->control_data.nel2,
+      plot_file->control_data.nv1d, D3PLT_PTR_STATE_ELEMENT_BEAM, value_map,
+      num_values, NULL, D3PLT_FIELD_ALL, num_states, &num_selected_values);
+}
+
+double *d3plot_read_shells_history(d3plot_file *plot_file,
+                                   const size_t *element_indices,
+                                   size_t num_indices, unsigned int fields,
+                                   size_t *num_states, size_t *num_values) {
+  size_t value_map[sizeof(d3plot_shell) / sizeof(double)];
+  const size_t num_struct_values =
+      _d3plot_shell_value_map(plot_file, value_map);
+
+  return _d3plot_read_element_history(
+      plot_file, element_indices, num_indices, plot_file->control_data.nel4,
+      plot_file->control_data.nv2d, D3PLT_PTR_STATE_ELEMENT_SHELL, value_map,
+      num_struct_values, _d3plot_shell_fields, fields, num_states, num_values);
+}
+
+#define DEFINE_D3PLOT_READ_AT_TIME(func_name, type, read_func,                 \
+                                   doubles_per_value)                          \
+  type *func_name(d3plot_file *plot_file, double time, size_t *num_values) {   \
+    double alpha;                                                              \
+    const size_t state = _d3plot_find_states_at_time(plot_file, time, &alpha); \
+    type *lhs = read_func(plot_file, state, num_values);                       \
+    if (lhs && alpha != 0.0) {                                                 \
+      size_t num_rhs_values;                                                   \
+      type *rhs = read_func(plot_file, state + 1, &num_rhs_values);            \
+      if (!rhs) {                                                              \
+        /* error_string has been set by read_func*/                            \
+        free(lhs);                                                             \
+        *num_values = 0;                                                       \
+        return NULL;                                                           \
+      }                                                                        \
+      _d3plot_interpolate((double *)lhs, (const double *)rhs, alpha,           \
+                          *num_values * (doubles_per_value));                  \
+      free(rhs);                                                               \
+    }                                                                          \
+    return lhs;                                                                \
+  }
+
+DEFINE_D3PLOT_READ_AT_TIME(d3plot_read_node_coordinates_at_time, double,
+                           d3plot_read_node_coordinates, 3)
+DEFINE_D3PLOT_READ_AT_TIME(d3plot_read_node_velocity_at_time, double,
+                           d3plot_read_node_velocity, 3)
+DEFINE_D3PLOT_READ_AT_TIME(d3plot_read_node_acceleration_at_time, double,
+                           d3plot_read_node_acceleration, 3)
+DEFINE_D3PLOT_READ_AT_TIME(d3plot_read_solids_state_at_time, d3plot_solid,
+                           d3plot_read_solids_state,
+                           sizeof(d3plot_solid) / sizeof(double))
+DEFINE_D3PLOT_READ_AT_TIME(d3plot_read_thick_shells_state_at_time,
+                           d3plot_thick_shell, d3plot_read_thick_shells_state,
+                           sizeof(d3plot_thick_shell) / sizeof(double))
+DEFINE_D3PLOT_READ_AT_TIME(d3plot_read_beams_state_at_time, d3plot_beam,
+                           d3plot_read_beams_state,
+                           sizeof(d3plot_beam) / sizeof(double))
+DEFINE_D3PLOT_READ_AT_TIME(d3plot_read_shells_state_at_time, d3plot_shell,
+                           d3plot_read_shells_state,
+                           sizeof(d3plot_shell) / sizeof(double))
+
+d3plot_solid_con *d3plot_read_solid_elements(d3plot_file *plot_file,
+                                             size_t *num_solids) {
+  if (plot_file->control_data.nel8 <= 0) {
+    /* nel8 represents the number of extra nodes for ten node solids*/
+    *num_solids = 0;
+    return NULL;
   }
 
+  *num_solids = plot_file->control_data.nel8;
+  d3plot_solid_con *solids = malloc(*num_solids * sizeof(d3plot_solid_con));
+  _d3plot_read_u64(plot_file, (d3_word *)solids, 9 * *num_solids,
+                   plot_file->data_pointers[D3PLT_PTR_EL8_CONNECT]);
+
   return solids;
 }
 
@@ -1080,34 +1496,8 @@ d3plot_read_thick_shell_elements(d3plot_file *plot_file,
   *num_thick_shells = plot_file->control_data.nelt;
   d3plot_thick_shell_con *thick_shells =
       malloc(*num_thick_shells * sizeof(d3plot_thick_shell_con));
-  if (plot_file->buffer.word_size == 4) {
-    uint32_t *thick_shells32 = malloc(*num_thick_shells * 9 * sizeof(uint32_t));
-    d3_buffer_read_words_at(&plot_file->buffer, thick_shells32,
-                            9 * *num_thick_shells,
-                            plot_file->data_pointers[D3PLT_PTR_ELT_CONNECT]);
-
-    size_t i = 0;
-    while (i < *num_thick_shells) {
-      size_t j = 0;
-      while (j < 8) {
-        thick_shells[i].node_ids[j + 0] = thick_shells32[i * 9 + j + 0];
-        thick_shells[i].node_ids[j + 1] = thick_shells32[i * 9 + j + 1];
-        thick_shells[i].node_ids[j + 2] = thick_shells32[i * 9 + j + 2];
-        thick_shells[i].node_ids[j + 3] = thick_shells32[i * 9 + j + 3];
-
-        j += 4;
-      }
-      thick_shells[i].material_id = thick_shells32[i * 9 + 8];
-
-      i++;
-    }
-
-    free(thick_shells32);
-  } else {
-    d3_buffer_read_words_at(&plot_file->buffer, thick_shells,
-                            9 * *num_thick_shells,
-                            plot_file->data_pointers[D3PLT_PTR_ELT_CONNECT]);
-  }
+  _d3plot_read_u64(plot_file, (d3_word *)thick_shells, 9 * *num_thick_shells,
+                   plot_file->data_pointers[D3PLT_PTR_ELT_CONNECT]);
 
   return thick_shells;
 }
@@ -1121,28 +1511,8 @@ d3plot_beam_con *d3plot_read_beam_elements(d3plot_file *plot_file,
 
   *num_beams = plot_file->control_data.nel2;
   d3plot_beam_con *beams = malloc(*num_beams * sizeof(d3plot_beam_con));
-  if (plot_file->buffer.word_size == 4) {
-    uint32_t *beams32 = malloc(*num_beams * 6 * sizeof(uint32_t));
-    d3_buffer_read_words_at(&plot_file->buffer, beams32, 6 * *num_beams,
-                            plot_file->data_pointers[D3PLT_PTR_EL2_CONNECT]);
-
-    size_t i = 0;
-    while (i < *num_beams) {
-      beams[i].node_ids[0] = beams32[i * 6 + 0];
-      beams[i].node_ids[1] = beams32[i * 6 + 1];
-      beams[i].orientation_node_id = beams32[i * 6 + 2];
-      beams[i]._null[0] = beams32[i * 6 + 3];
-      beams[i]._null[1] = beams32[i * 6 + 4];
-      beams[i].material_id = beams32[i * 6 + 5];
-
-      i++;
-    }
-
-    free(beams32);
-  } else {
-    d3_buffer_read_words_at(&plot_file->buffer, beams, 6 * *num_beams,
-                            plot_file->data_pointers[D3PLT_PTR_EL2_CONNECT]);
-  }
+  _d3plot_read_u64(plot_file, (d3_word *)beams, 6 * *num_beams,
+                   plot_file->data_pointers[D3PLT_PTR_EL2_CONNECT]);
 
   return beams;
 }
@@ -1156,27 +1526,8 @@ d3plot_shell_con *d3plot_read_shell_elements(d3plot_file *plot_file,
 
   *num_shells = plot_file->control_data.nel4;
   d3plot_shell_con *shells = malloc(*num_shells * sizeof(d3plot_shell_con));
-  if (plot_file->buffer.word_size == 4) {
-    uint32_t *shells32 = malloc(*num_shells * 5 * sizeof(uint32_t));
-    d3_buffer_read_words_at(&plot_file->buffer, shells32, 5 * *num_shells,
-                            plot_file->data_pointers[D3PLT_PTR_EL4_CONNECT]);
-
-    size_t i = 0;
-    while (i < *num_shells) {
-      shells[i].node_ids[0] = shells32[i * 5 + 0];
-      shells[i].node_ids[1] = shells32[i * 5 + 1];
-      shells[i].node_ids[2] = shells32[i * 5 + 2];
-      shells[i].node_ids[3] = shells32[i * 5 + 3];
-      shells[i].material_id = shells32[i * 5 + 4];
-
-      i++;
-    }
-
-    free(shells32);
-  } else {
-    d3_buffer_read_words_at(&plot_file->buffer, shells, 5 * *num_shells,
-                            plot_file->data_pointers[D3PLT_PTR_EL4_CONNECT]);
-  }
+  _d3plot_read_u64(plot_file, (d3_word *)shells, 5 * *num_shells,
+                   plot_file->data_pointers[D3PLT_PTR_EL4_CONNECT]);
 
   return shells;
 }
@@ -1200,31 +1551,15 @@ struct tm *d3plot_read_run_time(d3plot_file *plot_file) {
   return localtime(&epoch_time);
 }
 
-#define ADD_ELEMENTS_TO_PART(id_func, el_func, el_type, part_num, part_ids)    \
-  ids = id_func(plot_file, &num_elements);                                     \
-  if (num_elements > 0) {                                                      \
-    el_type *els = el_func(plot_file, &num_elements);                          \
-                                                                               \
-    size_t i = 0;                                                              \
-    while (i < num_elements) {                                                 \
-      /* For some reason materials in d3plot are parts -_('_')_-*/             \
-      if (els[i].material_id == part_index) {                                  \
-        part.part_num++;                                                       \
-        part.part_ids =                                                        \
-            realloc(part.part_ids, part.part_num * sizeof(d3_word));           \
-        part.part_ids[part.part_num - 1] = ids[i];                             \
-      }                                                                        \
-                                                                               \
-      i++;                                                                     \
-    }                                                                          \
-                                                                               \
-    free(ids);                                                                 \
-    free(els);                                                                 \
+#define ADD_ELEMENTS_TO_PART(type, id_type, num_ids, part_num, part_ids)      \
+  indices = _d3plot_part_elements(plot_file, type, part_index, &num_indices);  \
+  part.part_ids = _d3plot_read_id_subset(plot_file, id_type, num_ids, indices, \
+                                         num_indices);                         \
+  if (part.part_ids) {                                                         \
+    part.part_num = num_indices;                                               \
   }
 
 d3plot_part d3plot_read_part(d3plot_file *plot_file, size_t part_index) {
-  /* Use LS-Dyna's internal index system (Fortran starts by 1)*/
-  part_index++;
   d3plot_part part;
   part.solid_ids = NULL;
   part.thick_shell_ids = NULL;
@@ -1235,24 +1570,81 @@ d3plot_part d3plot_read_part(d3plot_file *plot_file, size_t part_index) {
   part.num_beams = 0;
   part.num_shells = 0;
 
-  size_t num_elements;
-  d3_word *ids;
-
-  ADD_ELEMENTS_TO_PART(d3plot_read_solid_element_ids,
-                       d3plot_read_solid_elements, d3plot_solid_con, num_solids,
-                       solid_ids);
-  ADD_ELEMENTS_TO_PART(d3plot_read_thick_shell_element_ids,
-                       d3plot_read_thick_shell_elements, d3plot_thick_shell_con,
-                       num_thick_shells, thick_shell_ids);
-  ADD_ELEMENTS_TO_PART(d3plot_read_beam_element_ids, d3plot_read_beam_elements,
-                       d3plot_beam_con, num_beams, beam_ids);
-  ADD_ELEMENTS_TO_PART(d3plot_read_shell_element_ids,
-                       d3plot_read_shell_elements, d3plot_shell_con, num_shells,
-                       shell_ids);
+  size_t num_indices;
+  const size_t *indices;
+
+  ADD_ELEMENTS_TO_PART(D3PLT_ELEMENT_SOLID, D3PLT_PTR_EL8_IDS,
+                       plot_file->control_data.nel8, num_solids, solid_ids);
+  ADD_ELEMENTS_TO_PART(D3PLT_ELEMENT_THICK_SHELL, D3PLT_PTR_ELT_IDS,
+                       plot_file->control_data.nelt, num_thick_shells,
+                       thick_shell_ids);
+  ADD_ELEMENTS_TO_PART(D3PLT_ELEMENT_BEAM, D3PLT_PTR_EL2_IDS,
+                       plot_file->control_data.nel2, num_beams, beam_ids);
+  ADD_ELEMENTS_TO_PART(D3PLT_ELEMENT_SHELL, D3PLT_PTR_EL4_IDS,
+                       plot_file->control_data.nel4, num_shells, shell_ids);
 
   return part;
 }
 
+#define READ_PART_STATE_ELEMENTS(type, element_type, num_elements, num_words, \
+                                 data_type, value_map_func)                    \
+  {                                                                            \
+    size_t num_indices;                                                        \
+    const size_t *indices = _d3plot_part_elements(plot_file, element_type,     \
+                                                  part_index, &num_indices);   \
+    size_t value_map[sizeof(*part_state.type) / sizeof(double)];               \
+    const size_t num_values = value_map_func(plot_file, value_map);            \
+    part_state.type = (void *)_d3plot_read_element_subset(                     \
+        plot_file, state, indices, num_indices, num_elements, num_words,       \
+        data_type, value_map, num_values);                                     \
+    if (part_state.type) {                                                     \
+      part_state.num_##type = num_indices;                                     \
+    }                                                                          \
+  }
+
+d3plot_part_state d3plot_read_part_state(d3plot_file *plot_file,
+                                         size_t part_index, size_t state) {
+  d3plot_part_state part_state;
+  part_state.solids = NULL;
+  part_state.thick_shells = NULL;
+  part_state.beams = NULL;
+  part_state.shells = NULL;
+  part_state.num_solids = 0;
+  part_state.num_thick_shells = 0;
+  part_state.num_beams = 0;
+  part_state.num_shells = 0;
+
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return part_state;
+  }
+
+  READ_PART_STATE_ELEMENTS(solids, D3PLT_ELEMENT_SOLID,
+                           plot_file->control_data.nel8,
+                           plot_file->control_data.nv3d,
+                           D3PLT_PTR_STATE_ELEMENT_SOLID,
+                           _d3plot_solid_value_map);
+  READ_PART_STATE_ELEMENTS(thick_shells, D3PLT_ELEMENT_THICK_SHELL,
+                           plot_file->control_data.nelt,
+                           plot_file->control_data.nv3dt,
+                           D3PLT_PTR_STATE_ELEMENT_THICK_SHELL,
+                           _d3plot_thick_shell_value_map);
+  READ_PART_STATE_ELEMENTS(beams, D3PLT_ELEMENT_BEAM,
+                           plot_file->control_data.nel2,
+                           plot_file->control_data.nv1d,
+                           D3PLT_PTR_STATE_ELEMENT_BEAM,
+                           _d3plot_beam_value_map);
+  READ_PART_STATE_ELEMENTS(shells, D3PLT_ELEMENT_SHELL,
+                           plot_file->control_data.nel4,
+                           plot_file->control_data.nv2d,
+                           D3PLT_PTR_STATE_ELEMENT_SHELL,
+                           _d3plot_shell_value_map);
+
+  return part_state;
+}
+
 const char *_d3plot_get_file_type_name(d3_word file_type) {
   switch (file_type) {
   case D3_FILE_TYPE_D3PLOT:
@@ -1310,117 +1702,1405 @@ int _get_nth_digit(d3_word value, int n) {
 
 double *_d3plot_read_node_data(d3plot_file *plot_file, size_t state,
                                size_t *num_nodes, size_t data_type) {
+  *num_nodes = plot_file->control_data.numnp;
+  double *coords = malloc(*num_nodes * 3 * sizeof(double));
+  if (!_d3plot_read_node_data_into(plot_file, state, data_type, coords)) {
+    free(coords);
+    *num_nodes = 0;
+    return NULL;
+  }
+
+  return coords;
+}
+
+int _d3plot_read_node_data_into(d3plot_file *plot_file, size_t state,
+                                size_t data_type, double *dst) {
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(70);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return 0;
+  }
+
+  _d3plot_read_f64(plot_file, dst, plot_file->control_data.numnp * 3,
+                   plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                       plot_file->data_pointers[data_type]);
+
+  return 1;
+}
+
+float *_d3plot_read_node_data_f32(d3plot_file *plot_file, size_t state,
+                                  size_t *num_nodes, size_t data_type) {
   if (state >= plot_file->num_states) {
     plot_file->error_string = malloc(70);
-    sprintf(plot_file->error_string, "%d is out of bounds for the states");
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    *num_nodes = 0;
     return NULL;
   }
 
   *num_nodes = plot_file->control_data.numnp;
-  double *coords = malloc(*num_nodes * 3 * sizeof(double));
+  const size_t word_pos = plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                          plot_file->data_pointers[data_type];
 
   if (plot_file->buffer.word_size == 4) {
-    float *coords32 = malloc(*num_nodes * 3 * sizeof(float));
-    d3_buffer_read_words_at(&plot_file->buffer, coords32, *num_nodes * 3,
-                            plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-                                plot_file->data_pointers[data_type]);
-    size_t i = 0;
-    while (i < *num_nodes) {
-      coords[i * 3 + 0] = coords32[i * 3 + 0];
-      coords[i * 3 + 1] = coords32[i * 3 + 1];
-      coords[i * 3 + 2] = coords32[i * 3 + 2];
+    float *coords = malloc(*num_nodes * 3 * sizeof(float));
+    d3_buffer_read_words_at(&plot_file->buffer, coords, *num_nodes * 3,
+                            word_pos);
+    return coords;
+  }
 
-      i++;
-    }
+  /* Read the doubles and narrow them in place*/
+  double *coords64 = malloc(*num_nodes * 3 * sizeof(double));
+  d3_buffer_read_words_at(&plot_file->buffer, coords64, *num_nodes * 3,
+                          word_pos);
+  d3_kernel_narrow_f64((float *)coords64, coords64, *num_nodes * 3);
 
-    free(coords32);
-  } else {
-    d3_buffer_read_words_at(&plot_file->buffer, coords, *num_nodes * 3,
-                            plot_file->data_pointers[D3PLT_PTR_STATES + state] +
-                                plot_file->data_pointers[data_type]);
+  return realloc(coords64, *num_nodes * 3 * sizeof(float));
+}
+
+const double *_d3plot_initial_coordinates(d3plot_file *plot_file) {
+  if (!plot_file->initial_coordinates) {
+    const size_t num_values = plot_file->control_data.numnp * 3;
+    plot_file->initial_coordinates = malloc(num_values * sizeof(double));
+    _d3plot_read_f64(plot_file, plot_file->initial_coordinates, num_values,
+                     plot_file->data_pointers[D3PLT_PTR_NODE_COORDS]);
   }
 
-  return coords;
+  return plot_file->initial_coordinates;
 }
 
-d3_word *_d3plot_read_ids(d3plot_file *plot_file, size_t *num_ids,
-                          size_t data_type, size_t num_ids_value) {
-  *num_ids = num_ids_value;
-  if (num_ids_value == 0) {
+double *_d3plot_read_node_history(d3plot_file *plot_file,
+                                  const size_t *node_indices,
+                                  size_t num_indices, size_t *num_states,
+                                  size_t data_type) {
+  const size_t value_map[3] = {0, 1, 2};
+  return _d3plot_read_history(plot_file, node_indices, num_indices,
+                              plot_file->control_data.numnp, 3, data_type,
+                              value_map, 3, num_states);
+}
+
+double *_d3plot_read_element_history(d3plot_file *plot_file,
+                                     const size_t *element_indices,
+                                     size_t num_indices, size_t num_elements,
+                                     size_t num_words, size_t data_type,
+                                     size_t *value_map, size_t num_values,
+                                     const unsigned int *value_fields,
+                                     unsigned int fields, size_t *num_states,
+                                     size_t *num_selected_values) {
+  if (value_fields) {
+    num_values =
+        _d3plot_select_fields(value_map, num_values, value_fields, fields);
+  }
+  *num_selected_values = num_values;
+
+  double *history = _d3plot_read_history(
+      plot_file, element_indices, num_indices, num_elements, num_words,
+      data_type, value_map, num_values, num_states);
+  if (!history) {
+    *num_selected_values = 0;
+  }
+
+  return history;
+}
+
+double *_d3plot_read_history(d3plot_file *plot_file, const size_t *indices,
+                             size_t num_indices, size_t num_items,
+                             size_t num_words, size_t data_type,
+                             const size_t *value_map, size_t num_values,
+                             size_t *num_states) {
+  *num_states = plot_file->num_states;
+  if (*num_states == 0 || num_indices == 0 || num_values == 0) {
+    *num_states = 0;
     return NULL;
   }
 
-  d3_word *ids = malloc(*num_ids * sizeof(d3_word));
-  if (plot_file->buffer.word_size == 4) {
-    uint32_t *ids32 = malloc(*num_ids * plot_file->buffer.word_size);
-    d3_buffer_read_words_at(&plot_file->buffer, ids32, *num_ids,
-                            plot_file->data_pointers[data_type]);
-    size_t i = 0;
-    while (i < *num_ids) {
-      ids[i + 0] = ids32[i + 0];
-      if (i < *num_ids - 1)
-        ids[i + 1] = ids32[i + 1];
-      if (i < *num_ids - 2)
-        ids[i + 2] = ids32[i + 2];
-      if (i < *num_ids - 3)
-        ids[i + 3] = ids32[i + 3];
-
-      i += 4;
-    }
+  size_t *sorted_items = malloc(num_indices * 2 * sizeof(size_t));
+  size_t *index_runs = malloc(num_indices * 3 * sizeof(size_t));
+  size_t max_run_length;
+  const size_t num_index_runs =
+      _d3plot_index_runs(plot_file, indices, num_indices, num_items, num_words,
+                         sorted_items, index_runs, &max_run_length);
+  if (num_index_runs == 0) {
+    free(index_runs);
+    free(sorted_items);
+    *num_states = 0;
+    return NULL;
+  }
 
-    free(ids32);
-  } else {
-    d3_buffer_read_words_at(&plot_file->buffer, ids, *num_ids,
-                            plot_file->data_pointers[data_type]);
+  size_t value_runs[D3PLT_MAX_ELEMENT_VALUES * 3];
+  const size_t num_value_runs =
+      _d3plot_value_map_runs(value_map, num_values, value_runs);
+
+  double *history =
+      malloc(*num_states * num_indices * num_values * sizeof(double));
+  void *run_data =
+      malloc(max_run_length * num_words * plot_file->buffer.word_size);
+
+  size_t state = 0;
+  while (state < *num_states) {
+    _d3plot_read_index_runs(
+        plot_file,
+        plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+            plot_file->data_pointers[data_type],
+        num_words, sorted_items, num_indices, index_runs, num_index_runs,
+        value_runs, num_value_runs, num_values, run_data,
+        &history[state * num_indices * num_values]);
+    state++;
   }
 
-  return ids;
+  free(run_data);
+  free(index_runs);
+  free(sorted_items);
+
+  return history;
 }
 
-#define SWAP(lhs, rhs)                                                         \
-  d3_word temp = lhs;                                                          \
-  lhs = rhs;                                                                   \
-  rhs = temp
+double *_d3plot_read_element_subset(d3plot_file *plot_file, size_t state,
+                                    const size_t *element_indices,
+                                    size_t num_indices, size_t num_elements,
+                                    size_t num_words, size_t data_type,
+                                    const size_t *value_map,
+                                    size_t num_values) {
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return NULL;
+  }
+
+  if (num_indices == 0) {
+    return NULL;
+  }
 
-d3_word *_insert_sorted(d3_word *dst, size_t dst_size, const d3_word *src,
-                        size_t src_size) {
-  if (!dst) {
-    dst = malloc(src_size * sizeof(d3_word));
-    memcpy(dst, src, src_size * sizeof(d3_word));
-    return dst;
+  size_t *sorted_items = malloc(num_indices * 2 * sizeof(size_t));
+  size_t *index_runs = malloc(num_indices * 3 * sizeof(size_t));
+  size_t max_run_length;
+  const size_t num_index_runs =
+      _d3plot_index_runs(plot_file, element_indices, num_indices, num_elements,
+                         num_words, sorted_items, index_runs, &max_run_length);
+  if (num_index_runs == 0) {
+    free(index_runs);
+    free(sorted_items);
+    return NULL;
   }
 
-  const size_t dst_min = dst[0];
-  const size_t dst_max = dst[dst_size - 1];
-  const size_t src_min = src[0];
-  const size_t src_max = src[src_size - 1];
+  size_t value_runs[D3PLT_MAX_ELEMENT_VALUES * 3];
+  const size_t num_value_runs =
+      _d3plot_value_map_runs(value_map, num_values, value_runs);
 
-  dst = realloc(dst, (dst_size + src_size) * sizeof(d3_word));
+  double *values = malloc(num_indices * num_values * sizeof(double));
+  void *run_data =
+      malloc(max_run_length * num_words * plot_file->buffer.word_size);
 
-  if (src_max <= dst_min) {
-    /* Insert before dst*/
-    memcpy(&dst[src_size], dst, dst_size * sizeof(d3_word));
-    memcpy(dst, src, src_size * sizeof(d3_word));
-  } else if (src_min >= dst_max) {
-    /* Insert after dst*/
-    memcpy(&dst[dst_size], src, src_size * sizeof(d3_word));
-  } else {
-    /* Insert inside dst*/
-    /* Search for index where i-1 is lesser than min and i is greater than min
-     */
-    size_t i = 1;
-    while (i < dst_size && !(dst[i - 1] < src_min && dst[i] > src_min)) {
-      i++;
-    }
+  _d3plot_read_index_runs(plot_file,
+                          plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                              plot_file->data_pointers[data_type],
+                          num_words, sorted_items, num_indices, index_runs,
+                          num_index_runs, value_runs, num_value_runs,
+                          num_values, run_data, values);
 
-    memcpy(&dst[i + src_size], &dst[i], (dst_size - i) * sizeof(d3_word));
-    memcpy(&dst[i], src, src_size * sizeof(d3_word));
-  }
+  free(run_data);
+  free(index_runs);
+  free(sorted_items);
 
-  return dst;
+  return values;
 }
 
-void d3plot_free_part(d3plot_part *part) {
+size_t _d3plot_surface_words(d3plot_file *plot_file, int element_type,
+                             int surface, size_t *num_words, size_t *data_type,
+                             size_t *stress_word, size_t *plastic_strain_word) {
+  /* The stresses of every surface are six consecutive words followed by the
+   * effective plastic strain, which are found using the value maps of the
+   * element types*/
+  size_t value_map[D3PLT_MAX_ELEMENT_VALUES];
+  size_t elements, stress, plastic_strain;
+  const size_t surface_values = sizeof(d3plot_surface) / sizeof(double);
+  switch (element_type) {
+  case D3PLT_ELEMENT_SOLID:
+    elements = plot_file->control_data.nel8;
+    *num_words = plot_file->control_data.nv3d;
+    *data_type = D3PLT_PTR_STATE_ELEMENT_SOLID;
+    _d3plot_solid_value_map(plot_file, value_map);
+    stress = D3PLT_COMPONENT(d3plot_solid, sigma.x);
+    plastic_strain = D3PLT_COMPONENT(d3plot_solid, effective_plastic_strain);
+    break;
+  case D3PLT_ELEMENT_THICK_SHELL:
+    elements = plot_file->control_data.nelt;
+    *num_words = plot_file->control_data.nv3dt;
+    *data_type = D3PLT_PTR_STATE_ELEMENT_THICK_SHELL;
+    _d3plot_thick_shell_value_map(plot_file, value_map);
+    stress = D3PLT_COMPONENT(d3plot_thick_shell, mid.sigma.x) +
+             surface * surface_values;
+    plastic_strain =
+        D3PLT_COMPONENT(d3plot_thick_shell, mid.effective_plastic_strain) +
+        surface * surface_values;
+    break;
+  default:
+    elements = plot_file->control_data.nel4;
+    *num_words = plot_file->control_data.nv2d;
+    *data_type = D3PLT_PTR_STATE_ELEMENT_SHELL;
+    _d3plot_shell_value_map(plot_file, value_map);
+    stress =
+        D3PLT_COMPONENT(d3plot_shell, mid.sigma.x) + surface * surface_values;
+    plastic_strain =
+        D3PLT_COMPONENT(d3plot_shell, mid.effective_plastic_strain) +
+        surface * surface_values;
+    break;
+  }
+
+  *stress_word = value_map[stress];
+  *plastic_strain_word = value_map[plastic_strain];
+  return elements;
+}
+
+double *_d3plot_read_stress(d3plot_file *plot_file, size_t state,
+                            int element_type, int surface, int quantity,
+                            size_t *num_elements) {
+  *num_elements = 0;
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return NULL;
+  }
+
+  if (surface < D3PLT_SURFACE_MID || surface > D3PLT_SURFACE_OUTER) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is not a valid surface", surface);
+    return NULL;
+  }
+
+  size_t num_words, data_type, tensor_word, plastic_strain_word;
+  const size_t elements =
+      _d3plot_surface_words(plot_file, element_type, surface, &num_words,
+                            &data_type, &tensor_word, &plastic_strain_word);
+  if (elements == 0) {
+    return NULL;
+  }
+
+  const size_t values_per_element = quantity == D3PLT_STRESS_PRINCIPAL ? 3 : 1;
+  const size_t word_pos = plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                          plot_file->data_pointers[data_type];
+  double *values = malloc(elements * values_per_element * sizeof(double));
+
+  /* Compute the quantity block by block directly from the words inside the
+   * files, so that the elements are never decoded*/
+  void *data =
+      _d3plot_scratch(plot_file, D3PLT_ELEMENT_BLOCK_SIZE * num_words *
+                                     plot_file->buffer.word_size);
+
+  size_t i = 0;
+  while (i < elements) {
+    const size_t block_size = elements - i < D3PLT_ELEMENT_BLOCK_SIZE
+                                  ? elements - i
+                                  : D3PLT_ELEMENT_BLOCK_SIZE;
+    d3_buffer_read_words_at(&plot_file->buffer, data, block_size * num_words,
+                            word_pos + i * num_words);
+
+    double *dst = &values[i * values_per_element];
+    if (plot_file->buffer.word_size == 4) {
+      const float *src = (const float *)data + tensor_word;
+      if (quantity == D3PLT_STRESS_VON_MISES) {
+        d3_kernel_von_mises_f32(dst, src, num_words, block_size);
+      } else if (quantity == D3PLT_STRESS_PRESSURE) {
+        d3_kernel_pressure_f32(dst, src, num_words, block_size);
+      } else {
+        d3_kernel_principal_f32(dst, src, num_words, block_size);
+      }
+    } else {
+      const double *src = (const double *)data + tensor_word;
+      if (quantity == D3PLT_STRESS_VON_MISES) {
+        d3_kernel_von_mises_f64(dst, src, num_words, block_size);
+      } else if (quantity == D3PLT_STRESS_PRESSURE) {
+        d3_kernel_pressure_f64(dst, src, num_words, block_size);
+      } else {
+        d3_kernel_principal_f64(dst, src, num_words, block_size);
+      }
+    }
+
+    i += block_size;
+  }
+
+  *num_elements = elements;
+  return values;
+}
+
+uint8_t *_d3plot_read_deletion(d3plot_file *plot_file, size_t state,
+                               int mdlopt, size_t offset, size_t num_items) {
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return NULL;
+  }
+
+  if (plot_file->control_data.mdlopt != mdlopt) {
+    plot_file->error_string = malloc(70);
+    sprintf(plot_file->error_string,
+            "The deletion data requires MDLOPT to be %d instead of %d", mdlopt,
+            plot_file->control_data.mdlopt);
+    return NULL;
+  }
+
+  if (num_items == 0) {
+    return NULL;
+  }
+
+  /* The deletion data directly follows the element data of the thick
+   * shells*/
+  const size_t word_pos =
+      plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+      plot_file->data_pointers[D3PLT_PTR_STATE_ELEMENT_THICK_SHELL] +
+      plot_file->control_data.nv3dt * plot_file->control_data.nelt + offset;
+
+  void *data =
+      _d3plot_scratch(plot_file, num_items * plot_file->buffer.word_size);
+  d3_buffer_read_words_at(&plot_file->buffer, data, num_items, word_pos);
+
+  /* The flags are stored as floating point values where 0 means deleted*/
+  uint8_t *flags = malloc(num_items);
+  size_t i = 0;
+  if (plot_file->buffer.word_size == 4) {
+    const float *values = (const float *)data;
+    while (i < num_items) {
+      flags[i] = values[i] != 0.0f;
+      i++;
+    }
+  } else {
+    const double *values = (const double *)data;
+    while (i < num_items) {
+      flags[i] = values[i] != 0.0;
+      i++;
+    }
+  }
+
+  return flags;
+}
+
+double *_d3plot_read_element_alive(d3plot_file *plot_file, size_t state,
+                                   size_t offset, size_t num_elements,
+                                   size_t num_words, size_t data_type,
+                                   const size_t *value_map, size_t num_values,
+                                   size_t *num_alive,
+                                   size_t **element_indices) {
+  *num_alive = 0;
+  *element_indices = NULL;
+  if (num_elements == 0) {
+    return NULL;
+  }
+
+  size_t *indices = malloc(num_elements * sizeof(size_t));
+  size_t i = 0;
+
+  /* Without element deletion data every element is active*/
+  if (plot_file->control_data.mdlopt != 2) {
+    double *values =
+        _d3plot_read_element_data(plot_file, state, num_elements, num_words,
+                                  data_type, value_map, num_values);
+    if (!values) {
+      free(indices);
+      return NULL;
+    }
+
+    while (i < num_elements) {
+      indices[i] = i;
+      i++;
+    }
+
+    *num_alive = num_elements;
+    *element_indices = indices;
+    return values;
+  }
+
+  uint8_t *flags =
+      _d3plot_read_deletion(plot_file, state, 2, offset, num_elements);
+  if (!flags) {
+    free(indices);
+    return NULL;
+  }
+
+  size_t n = 0;
+  while (i < num_elements) {
+    indices[n] = i;
+    n += flags[i];
+    i++;
+  }
+  free(flags);
+
+  if (n == 0) {
+    free(indices);
+    return NULL;
+  }
+
+  /* The indices are already sorted, so that the deleted elements only create
+   * gaps between the runs that are read*/
+  double *values =
+      _d3plot_read_element_subset(plot_file, state, indices, n, num_elements,
+                                  num_words, data_type, value_map, num_values);
+  if (!values) {
+    free(indices);
+    return NULL;
+  }
+
+  *num_alive = n;
+  *element_indices = indices;
+  return values;
+}
+
+size_t _d3plot_index_runs(d3plot_file *plot_file, const size_t *indices,
+                          size_t num_indices, size_t num_items,
+                          size_t num_words, size_t *sorted_items,
+                          size_t *index_runs, size_t *max_run_length) {
+  /* Sort the requested items by their position inside a state, so that items
+   * lying close to each other can be read together. Every entry consists of
+   * the item index and the index inside indices*/
+  int sorted = 1;
+  size_t i = 0;
+  while (i < num_indices) {
+    if (indices[i] >= num_items) {
+      plot_file->error_string = malloc(70);
+      sprintf(plot_file->error_string, "The index %d is out of bounds",
+              (int)indices[i]);
+      return 0;
+    }
+
+    sorted_items[i * 2 + 0] = indices[i];
+    sorted_items[i * 2 + 1] = i;
+    if (i != 0 && indices[i] < indices[i - 1]) {
+      sorted = 0;
+    }
+    i++;
+  }
+  if (!sorted) {
+    qsort(sorted_items, num_indices, 2 * sizeof(size_t),
+          _d3plot_compare_indices);
+  }
+
+  /* Combine the items into runs of (first item, last item + 1, first entry of
+   * sorted_items). The words between two items of a run are read as well,
+   * because seeking costs more than reading a few words. Runs are limited to
+   * D3PLT_ELEMENT_BLOCK_SIZE items so that they stay in the cache*/
+  size_t num_runs = 0;
+  *max_run_length = 0;
+  i = 0;
+  while (i < num_indices) {
+    const size_t item = sorted_items[i * 2];
+    size_t *last_run = NULL;
+    if (num_runs != 0) {
+      last_run = &index_runs[(num_runs - 1) * 3];
+    }
+    if (last_run && item < last_run[1]) {
+      /* The same item has been requested multiple times*/
+    } else if (last_run &&
+               (item - last_run[1]) * num_words <= D3PLT_HISTORY_MAX_GAP &&
+               item - last_run[0] < D3PLT_ELEMENT_BLOCK_SIZE) {
+      last_run[1] = item + 1;
+    } else {
+      index_runs[num_runs * 3 + 0] = item;
+      index_runs[num_runs * 3 + 1] = item + 1;
+      index_runs[num_runs * 3 + 2] = i;
+      num_runs++;
+    }
+
+    last_run = &index_runs[(num_runs - 1) * 3];
+    if (last_run[1] - last_run[0] > *max_run_length) {
+      *max_run_length = last_run[1] - last_run[0];
+    }
+
+    i++;
+  }
+
+  return num_runs;
+}
+
+void _d3plot_read_index_runs(d3plot_file *plot_file, size_t word_pos,
+                             size_t num_words, const size_t *sorted_items,
+                             size_t num_indices, const size_t *index_runs,
+                             size_t num_index_runs, const size_t *value_runs,
+                             size_t num_value_runs, size_t num_values,
+                             void *run_data, double *dst) {
+  size_t r = 0;
+  while (r < num_index_runs) {
+    const size_t first_item = index_runs[r * 3 + 0];
+    const size_t end_item = index_runs[r * 3 + 1];
+    d3_buffer_read_words_at(&plot_file->buffer, run_data,
+                            (end_item - first_item) * num_words,
+                            word_pos + first_item * num_words);
+
+    /* Convert stretches of items which lie equally far apart and are
+     * consecutive inside dst at once. This covers elements of a part that
+     * alternate with the elements of other parts*/
+    size_t i = index_runs[r * 3 + 2];
+    while (i < num_indices && sorted_items[i * 2] < end_item) {
+      const size_t *item = &sorted_items[i * 2];
+      size_t step = 1;
+      size_t n = 1;
+      if (i + 1 < num_indices && item[2] < end_item) {
+        step = item[2] - item[0];
+      }
+      while (i + n < num_indices && item[n * 2] < end_item &&
+             item[n * 2] == item[0] + n * step &&
+             item[n * 2 + 1] == item[1] + n) {
+        n++;
+      }
+
+      const size_t src_index = (item[0] - first_item) * num_words;
+      double *item_dst = &dst[item[1] * num_values];
+      if (plot_file->buffer.word_size == 4) {
+        d3_kernel_widen_f32_runs(item_dst, num_values,
+                                 &((const float *)run_data)[src_index],
+                                 step * num_words, n, value_runs,
+                                 num_value_runs);
+      } else {
+        d3_kernel_copy_f64_runs(item_dst, num_values,
+                                &((const double *)run_data)[src_index],
+                                step * num_words, n, value_runs,
+                                num_value_runs);
+      }
+
+      i += n;
+    }
+
+    r++;
+  }
+}
+
+#define BUILD_PART_INDEX(type, el_func, el_type)                               \
+  {                                                                            \
+    size_t num_elements;                                                       \
+    el_type *els = el_func(plot_file, &num_elements);                          \
+    size_t *offsets = calloc(num_parts + 1, sizeof(size_t));                   \
+    size_t *elements = malloc(num_elements * sizeof(size_t));                  \
+                                                                               \
+    /* Count the elements of every part. Materials of d3plot are parts and   \
+     * start at 1. Elements with an unknown material are not indexed*/         \
+    size_t i = 0;                                                              \
+    while (i < num_elements) {                                                 \
+      if (els[i].material_id >= 1 && els[i].material_id <= num_parts) {        \
+        offsets[els[i].material_id]++;                                         \
+      }                                                                        \
+      i++;                                                                     \
+    }                                                                          \
+    i = 0;                                                                     \
+    while (i < num_parts) {                                                    \
+      offsets[i + 1] += offsets[i];                                            \
+      i++;                                                                     \
+    }                                                                          \
+                                                                               \
+    /* Place the elements, which keeps them in ascending order inside a        \
+     * part. offsets[p] is used as the insert position of part p and ends      \
+     * up at the start of part p + 1, so they are shifted back afterwards*/    \
+    i = 0;                                                                     \
+    while (i < num_elements) {                                                 \
+      if (els[i].material_id >= 1 && els[i].material_id <= num_parts) {        \
+        elements[offsets[els[i].material_id - 1]++] = i;                       \
+      }                                                                        \
+      i++;                                                                     \
+    }                                                                          \
+    i = num_parts;                                                             \
+    while (i > 0) {                                                            \
+      offsets[i] = offsets[i - 1];                                             \
+      i--;                                                                     \
+    }                                                                          \
+    offsets[0] = 0;                                                            \
+                                                                               \
+    free(els);                                                                 \
+    plot_file->part_offsets[type] = offsets;                                   \
+    plot_file->part_elements[type] = elements;                                 \
+  }
+
+void _d3plot_build_part_index(d3plot_file *plot_file) {
+  if (plot_file->part_offsets[0]) {
+    return;
+  }
+
+  const size_t num_parts = plot_file->control_data.nmmat;
+
+  BUILD_PART_INDEX(D3PLT_ELEMENT_SOLID, d3plot_read_solid_elements,
+                   d3plot_solid_con);
+  BUILD_PART_INDEX(D3PLT_ELEMENT_THICK_SHELL, d3plot_read_thick_shell_elements,
+                   d3plot_thick_shell_con);
+  BUILD_PART_INDEX(D3PLT_ELEMENT_BEAM, d3plot_read_beam_elements,
+                   d3plot_beam_con);
+  BUILD_PART_INDEX(D3PLT_ELEMENT_SHELL, d3plot_read_shell_elements,
+                   d3plot_shell_con);
+}
+
+const size_t *_d3plot_part_elements(d3plot_file *plot_file, int type,
+                                    size_t part_index, size_t *num_elements) {
+  _d3plot_build_part_index(plot_file);
+
+  if (part_index >= plot_file->control_data.nmmat) {
+    *num_elements = 0;
+    return NULL;
+  }
+
+  const size_t *offsets = plot_file->part_offsets[type];
+  *num_elements = offsets[part_index + 1] - offsets[part_index];
+  return &plot_file->part_elements[type][offsets[part_index]];
+}
+
+size_t _d3plot_build_id_index(d3plot_file *plot_file, int id_type,
+                              size_t data_type, size_t num_ids) {
+  if (num_ids == 0 || plot_file->sorted_ids[id_type]) {
+    return num_ids;
+  }
+
+  size_t num_read_ids;
+  d3_word *ids = _d3plot_read_ids(plot_file, &num_read_ids, data_type, num_ids);
+
+  /* The ids are usually already sorted, in which case the index of a sorted
+   * id is its position*/
+  size_t i = 1;
+  while (i < num_ids && ids[i - 1] <= ids[i]) {
+    i++;
+  }
+
+  if (i < num_ids) {
+    /* Sort (id, index) pairs and split them up, so that the binary search
+     * only touches the ids*/
+    size_t *pairs = malloc(num_ids * 2 * sizeof(size_t));
+    i = 0;
+    while (i < num_ids) {
+      pairs[i * 2 + 0] = ids[i];
+      pairs[i * 2 + 1] = i;
+      i++;
+    }
+    qsort(pairs, num_ids, 2 * sizeof(size_t), _d3plot_compare_indices);
+
+    size_t *id_indices = malloc(num_ids * sizeof(size_t));
+    i = 0;
+    while (i < num_ids) {
+      ids[i] = pairs[i * 2 + 0];
+      id_indices[i] = pairs[i * 2 + 1];
+      i++;
+    }
+    free(pairs);
+
+    plot_file->sorted_id_indices[id_type] = id_indices;
+  }
+
+  plot_file->sorted_ids[id_type] = ids;
+  return num_ids;
+}
+
+size_t _d3plot_id_indices(d3plot_file *plot_file, int id_type,
+                          size_t data_type, size_t num_type_ids,
+                          const d3_word *ids, size_t num_ids, size_t *indices) {
+  _d3plot_build_id_index(plot_file, id_type, data_type, num_type_ids);
+  const d3_word *sorted_ids = plot_file->sorted_ids[id_type];
+  const size_t *sorted_id_indices = plot_file->sorted_id_indices[id_type];
+
+  size_t num_found = 0;
+  size_t i = 0;
+  while (i < num_ids) {
+    if (num_type_ids == 0) {
+      indices[i] = D3PLT_INVALID_INDEX;
+      i++;
+      continue;
+    }
+
+    /* Branchless binary search for the last id that is not greater than
+     * ids[i]*/
+    const d3_word *base = sorted_ids;
+    size_t n = num_type_ids;
+    while (n > 1) {
+      const size_t half = n / 2;
+      base = base[half] <= ids[i] ? &base[half] : base;
+      n -= half;
+    }
+
+    if (*base == ids[i]) {
+      const size_t index = (size_t)(base - sorted_ids);
+      indices[i] = sorted_id_indices ? sorted_id_indices[index] : index;
+      num_found++;
+    } else {
+      indices[i] = D3PLT_INVALID_INDEX;
+    }
+
+    i++;
+  }
+
+  return num_found;
+}
+
+d3_word *_d3plot_merge_element_ids(d3plot_file *plot_file, size_t *num_ids,
+                                   uint8_t *element_types,
+                                   size_t *element_indices) {
+  /* The id index holds the ids of every element type in sorted order, so the
+   * four types only need to be merged*/
+  const size_t num_type_ids[D3PLT_ELEMENT_TYPE_COUNT] = {
+      _d3plot_build_id_index(plot_file, D3PLT_ELEMENT_SOLID, D3PLT_PTR_EL8_IDS,
+                             plot_file->control_data.nel8),
+      _d3plot_build_id_index(plot_file, D3PLT_ELEMENT_THICK_SHELL,
+                             D3PLT_PTR_ELT_IDS, plot_file->control_data.nelt),
+      _d3plot_build_id_index(plot_file, D3PLT_ELEMENT_BEAM, D3PLT_PTR_EL2_IDS,
+                             plot_file->control_data.nel2),
+      _d3plot_build_id_index(plot_file, D3PLT_ELEMENT_SHELL, D3PLT_PTR_EL4_IDS,
+                             plot_file->control_data.nel4)};
+  size_t positions[D3PLT_ELEMENT_TYPE_COUNT] = {0, 0, 0, 0};
+
+  *num_ids = num_type_ids[0] + num_type_ids[1] + num_type_ids[2] +
+             num_type_ids[3];
+  if (*num_ids == 0) {
+    return NULL;
+  }
+
+  d3_word *all_ids = malloc(*num_ids * sizeof(d3_word));
+
+  size_t i = 0;
+  while (i < *num_ids) {
+    /* Find the type with the smallest next id and the smallest next id of the
+     * other types*/
+    int type = -1;
+    d3_word next_id = 0;
+    int has_next_id = 0;
+    int t = 0;
+    while (t < D3PLT_ELEMENT_TYPE_COUNT) {
+      if (positions[t] < num_type_ids[t]) {
+        const d3_word id = plot_file->sorted_ids[t][positions[t]];
+        if (type == -1) {
+          type = t;
+        } else if (id < plot_file->sorted_ids[type][positions[type]]) {
+          next_id = plot_file->sorted_ids[type][positions[type]];
+          has_next_id = 1;
+          type = t;
+        } else if (!has_next_id || id < next_id) {
+          next_id = id;
+          has_next_id = 1;
+        }
+      }
+      t++;
+    }
+
+    /* Copy all ids of the type that come before the next id of the other
+     * types at once*/
+    const d3_word *ids = plot_file->sorted_ids[type];
+    const size_t start = positions[type];
+    size_t end = start + 1;
+    while (end < num_type_ids[type] && (!has_next_id || ids[end] < next_id)) {
+      end++;
+    }
+
+    const size_t run_length = end - start;
+    memcpy(&all_ids[i], &ids[start], run_length * sizeof(d3_word));
+    if (element_types) {
+      memset(&element_types[i], type, run_length * sizeof(uint8_t));
+    }
+    if (element_indices) {
+      const size_t *id_indices = plot_file->sorted_id_indices[type];
+      size_t j = 0;
+      while (j < run_length) {
+        element_indices[i + j] =
+            id_indices ? id_indices[start + j] : start + j;
+        j++;
+      }
+    }
+
+    positions[type] = end;
+    i += run_length;
+  }
+
+  return all_ids;
+}
+
+int _d3plot_compare_indices(const void *lhs, const void *rhs) {
+  const size_t lhs_index = *(const size_t *)lhs;
+  const size_t rhs_index = *(const size_t *)rhs;
+  return (lhs_index > rhs_index) - (lhs_index < rhs_index);
+}
+
+void _d3plot_read_globals(d3plot_file *plot_file, size_t first_state,
+                          size_t end_state, double *dst) {
+  const size_t num_globals = plot_file->control_data.nglbv;
+  /* GLOBAL directly follows the time of a state*/
+  const size_t global_offset =
+      plot_file->data_pointers[D3PLT_PTR_STATE_TIME] + 1;
+  const size_t word_size = plot_file->buffer.word_size;
+
+  /* The GLOBAL blocks are small. If the states are small as well, the blocks
+   * of consecutive states are read together, like the items of the history
+   * functions*/
+  size_t state = first_state;
+  while (state < end_state) {
+    const size_t first_pos =
+        plot_file->data_pointers[D3PLT_PTR_STATES + state] + global_offset;
+    size_t end_read_state = state + 1;
+    size_t end_pos = first_pos + num_globals;
+    while (end_read_state < end_state &&
+           end_read_state - state < D3PLT_GLOBAL_MAX_STATES) {
+      const size_t pos =
+          plot_file->data_pointers[D3PLT_PTR_STATES + end_read_state] +
+          global_offset;
+      if (pos < end_pos || pos - end_pos > D3PLT_HISTORY_MAX_GAP) {
+        break;
+      }
+
+      end_pos = pos + num_globals;
+      end_read_state++;
+    }
+
+    char *data = _d3plot_scratch(plot_file, (end_pos - first_pos) * word_size);
+    d3_buffer_read_words_at(&plot_file->buffer, data, end_pos - first_pos,
+                            first_pos);
+
+    while (state < end_read_state) {
+      const char *words =
+          &data[(plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                 global_offset - first_pos) *
+                word_size];
+      double *state_dst = &dst[(state - first_state) * num_globals];
+      if (word_size == 4) {
+        d3_kernel_widen_f32(state_dst, (const float *)words, num_globals);
+      } else {
+        memcpy(state_dst, words, num_globals * sizeof(double));
+      }
+
+      state++;
+    }
+  }
+}
+
+void *_d3plot_scratch(d3plot_file *plot_file, size_t size) {
+  if (size > plot_file->scratch_size) {
+    free(plot_file->scratch);
+    plot_file->scratch = malloc(size);
+    plot_file->scratch_size = size;
+  }
+
+  return plot_file->scratch;
+}
+
+void _d3plot_read_f64(d3plot_file *plot_file, double *dst, size_t num_words,
+                      size_t word_pos) {
+  if (plot_file->buffer.word_size == 4) {
+    /* Read the floats into the second half of dst and widen them in place*/
+    float *src = (float *)dst + num_words;
+    d3_buffer_read_words_at(&plot_file->buffer, src, num_words, word_pos);
+    d3_kernel_widen_f32(dst, src, num_words);
+  } else {
+    d3_buffer_read_words_at(&plot_file->buffer, dst, num_words, word_pos);
+  }
+}
+
+void _d3plot_read_u64(d3plot_file *plot_file, d3_word *dst, size_t num_words,
+                      size_t word_pos) {
+  if (plot_file->buffer.word_size == 4) {
+    uint32_t *src = (uint32_t *)dst + num_words;
+    d3_buffer_read_words_at(&plot_file->buffer, src, num_words, word_pos);
+    d3_kernel_widen_u32(dst, src, num_words);
+  } else {
+    d3_buffer_read_words_at(&plot_file->buffer, dst, num_words, word_pos);
+  }
+}
+
+size_t _d3plot_solid_value_map(d3plot_file *plot_file, size_t *value_map) {
+  /* Docs: page 33*/
+  const size_t num_values = sizeof(d3plot_solid) / sizeof(double);
+  size_t i = 0;
+  while (i < 7) {
+    value_map[i] = i;
+    i++;
+  }
+  while (i < num_values) {
+    value_map[i] = D3PLT_NO_VALUE;
+    i++;
+  }
+
+  if (plot_file->control_data.neiph > 0) {
+    value_map[7] = 7;
+    if (plot_file->control_data.neiph > 1) {
+      value_map[8] = 8;
+      if (plot_file->control_data.neiph >= 6) {
+        /* The strains are the last 6 of the NEIPH values*/
+        i = 0;
+        while (i < 6) {
+          value_map[9 + i] = 7 + plot_file->control_data.neiph - 6 + i;
+          i++;
+        }
+      }
+    }
+  }
+
+  return num_values;
+}
+
+size_t _d3plot_thick_shell_value_map(d3plot_file *plot_file,
+                                     size_t *value_map) {
+  const size_t num_values = sizeof(d3plot_thick_shell) / sizeof(double);
+  const size_t surface_values = sizeof(d3plot_surface) / sizeof(double);
+  size_t i = 0;
+  size_t o = 0;
+  while (i < 3 * surface_values) {
+    value_map[i] = o++;
+    i++;
+    if (i % surface_values == 0) {
+      /* TODO: Define NEIPS additional history values here for every surface*/
+      o += plot_file->control_data.neips;
+    }
+  }
+
+  if (plot_file->control_data.istrn == 1) {
+    while (i < num_values) {
+      value_map[i] = o++;
+      i++;
+    }
+  } else {
+    while (i < num_values) {
+      value_map[i] = D3PLT_NO_VALUE;
+      i++;
+    }
+  }
+
+  /* TODO: If MAXINT > 3 then define an additional (MAXINT-3 )* (6 *
+   * IOSHL(1) +1*IOSHL(2)+NEIPS) quantities here.*/
+  return num_values;
+}
+
+size_t _d3plot_beam_value_map(d3plot_file *plot_file, size_t *value_map) {
+  /* All beams have the same layout at the moment*/
+  (void)plot_file;
+
+  const size_t num_values = sizeof(d3plot_beam) / sizeof(double);
+  size_t i = 0;
+  while (i < num_values) {
+    value_map[i] = i;
+    i++;
+  }
+
+  /* TODO: If there are values output at beam integration points, then
+   * NV1D = 6 + 5 * BEAMIP*/
+  return num_values;
+}
+
+size_t _d3plot_shell_value_map(d3plot_file *plot_file, size_t *value_map) {
+  const size_t num_values = sizeof(d3plot_shell) / sizeof(double);
+  const size_t surface_values = sizeof(d3plot_surface) / sizeof(double);
+  size_t i = 0;
+  size_t o = 0;
+  while (i < 3 * surface_values) {
+    value_map[i] = o++;
+    i++;
+    if (i % surface_values == 0) {
+      /* TODO: Define NEIPS additional history values here for every surface*/
+      o += plot_file->control_data.neips;
+    }
+  }
+  while (i < num_values) {
+    value_map[i] = D3PLT_NO_VALUE;
+    i++;
+  }
+
+  if (plot_file->control_data.maxint > 3) {
+    /* TODO: If MAXINT >3 then define an additional (MAXINT-3 )* (6*IOSHL(1)
+     * + 1*IOSHL(2) + 8*IOSHL(3) + 4*IOSHL(4) + NEIPS) quantities here*/
+    o += (plot_file->control_data.maxint - 3) *
+         (6 * plot_file->control_data.ioshl[0] +
+          1 * plot_file->control_data.ioshl[1] +
+          8 * plot_file->control_data.ioshl[2] +
+          4 * plot_file->control_data.ioshl[3] +
+          plot_file->control_data.neips);
+  }
+  /* TODO:
+   * Bending moment-Mx (local shell coordinate system)
+   * Bending moment-My
+   * Bending moment-Mxy
+   * Shear resultant-Qx
+   * Shear resultant-Qy
+   * Normal resultant-Nx
+   * Normal resultant-Ny
+   * Normal resultant-Nxy
+   * Thickness
+   * Element dependent variable
+   * Element dependent variable*/
+  o += 11;
+
+  if (plot_file->control_data.istrn == 0) {
+    value_map[num_values - 1] = o;
+  } else if (plot_file->control_data.istrn == 1) {
+    i = 0;
+    while (i < 12) {
+      value_map[3 * surface_values + i] = o++;
+      i++;
+    }
+
+    if (plot_file->control_data.nv2d >= 45) {
+      value_map[num_values - 1] = o;
+    }
+  }
+
+  return num_values;
+}
+
+size_t _d3plot_select_fields(size_t *value_map, size_t num_values,
+                             const unsigned int *value_fields,
+                             unsigned int fields) {
+  size_t num_selected_values = 0;
+  size_t i = 0;
+  while (i < num_values) {
+    if (value_fields[i] & fields) {
+      value_map[num_selected_values++] = value_map[i];
+    }
+
+    i++;
+  }
+
+  return num_selected_values;
+}
+
+double *_d3plot_read_element_data_fields(
+    d3plot_file *plot_file, size_t state, size_t num_elements,
+    size_t num_words, size_t data_type, size_t *value_map, size_t num_values,
+    const unsigned int *value_fields, unsigned int fields,
+    size_t *num_selected_values) {
+  *num_selected_values =
+      _d3plot_select_fields(value_map, num_values, value_fields, fields);
+  if (num_elements == 0 || *num_selected_values == 0) {
+    *num_selected_values = 0;
+    return NULL;
+  }
+
+  double *values = _d3plot_read_element_data(
+      plot_file, state, num_elements, num_words, data_type, value_map,
+      *num_selected_values);
+  if (!values) {
+    *num_selected_values = 0;
+  }
+
+  return values;
+}
+
+size_t _d3plot_value_map_runs(const size_t *value_map, size_t num_values,
+                              size_t *runs) {
+  size_t num_runs = 0;
+  size_t j = 0;
+  while (j < num_values) {
+    size_t *last_run = NULL;
+    if (num_runs != 0) {
+      last_run = &runs[(num_runs - 1) * 3];
+    }
+    if (last_run &&
+        ((value_map[j] == D3PLT_NO_VALUE && last_run[1] == D3PLT_NO_VALUE) ||
+         (value_map[j] != D3PLT_NO_VALUE && last_run[1] != D3PLT_NO_VALUE &&
+          value_map[j] == last_run[1] + last_run[2]))) {
+      last_run[2]++;
+    } else {
+      runs[num_runs * 3 + 0] = j;
+      runs[num_runs * 3 + 1] = value_map[j];
+      runs[num_runs * 3 + 2] = 1;
+      num_runs++;
+    }
+
+    j++;
+  }
+
+  return num_runs;
+}
+
+double *_d3plot_read_element_data(d3plot_file *plot_file, size_t state,
+                                  size_t num_elements, size_t num_words,
+                                  size_t data_type, const size_t *value_map,
+                                  size_t num_values) {
+  double *values = malloc(num_elements * num_values * sizeof(double));
+  if (!_d3plot_read_element_data_into(plot_file, state, num_elements,
+                                      num_words, data_type, value_map,
+                                      num_values, values)) {
+    free(values);
+    return NULL;
+  }
+
+  return values;
+}
+
+int _d3plot_read_element_data_into(d3plot_file *plot_file, size_t state,
+                                   size_t num_elements, size_t num_words,
+                                   size_t data_type, const size_t *value_map,
+                                   size_t num_values, double *values) {
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return 0;
+  }
+
+  const size_t word_pos = plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                          plot_file->data_pointers[data_type];
+
+  size_t runs[D3PLT_MAX_ELEMENT_VALUES * 3];
+  const size_t num_runs = _d3plot_value_map_runs(value_map, num_values, runs);
+
+  /* Read the elements in blocks so that the words stay in the cache until
+   * they have been deinterleaved*/
+  void *data =
+      _d3plot_scratch(plot_file, D3PLT_ELEMENT_BLOCK_SIZE * num_words *
+                                     plot_file->buffer.word_size);
+
+  size_t i = 0;
+  while (i < num_elements) {
+    const size_t block_size = num_elements - i < D3PLT_ELEMENT_BLOCK_SIZE
+                                  ? num_elements - i
+                                  : D3PLT_ELEMENT_BLOCK_SIZE;
+    d3_buffer_read_words_at(&plot_file->buffer, data, block_size * num_words,
+                            word_pos + i * num_words);
+
+    /* The runs of value_map which are D3PLT_NO_VALUE are filled with zeros*/
+    if (plot_file->buffer.word_size == 4) {
+      d3_kernel_widen_f32_runs(&values[i * num_values], num_values,
+                               (const float *)data, num_words, block_size,
+                               runs, num_runs);
+    } else {
+      d3_kernel_copy_f64_runs(&values[i * num_values], num_values,
+                              (const double *)data, num_words, block_size,
+                              runs, num_runs);
+    }
+
+    i += block_size;
+  }
+
+  return 1;
+}
+
+int _d3plot_read_element_data_soa(d3plot_file *plot_file, size_t state,
+                                  size_t num_elements, size_t num_words,
+                                  size_t data_type, const size_t *value_map,
+                                  size_t num_values, double **components) {
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return 0;
+  }
+
+  const size_t word_pos = plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                          plot_file->data_pointers[data_type];
+  char *data =
+      _d3plot_scratch(plot_file, D3PLT_ELEMENT_BLOCK_SIZE * num_words *
+                                     plot_file->buffer.word_size);
+
+  size_t i = 0;
+  while (i < num_elements) {
+    const size_t block_size = num_elements - i < D3PLT_ELEMENT_BLOCK_SIZE
+                                  ? num_elements - i
+                                  : D3PLT_ELEMENT_BLOCK_SIZE;
+    d3_buffer_read_words_at(&plot_file->buffer, data, block_size * num_words,
+                            word_pos + i * num_words);
+
+    /* Gather the components out of smaller pieces of the block, so that the
+     * words of a piece stay in the L1 cache until all of them are done*/
+    size_t p = 0;
+    while (p < block_size) {
+      const size_t piece_size = block_size - p < D3PLT_SOA_PIECE_SIZE
+                                    ? block_size - p
+                                    : D3PLT_SOA_PIECE_SIZE;
+      const char *piece =
+          &data[p * num_words * plot_file->buffer.word_size];
+
+      size_t j = 0;
+      while (j < num_values) {
+        double *dst = components[j] ? &components[j][i + p] : NULL;
+        if (!dst) {
+          /* The caller is not interested in this component*/
+        } else if (value_map[j] == D3PLT_NO_VALUE) {
+          memset(dst, 0, piece_size * sizeof(double));
+        } else if (plot_file->buffer.word_size == 4) {
+          d3_kernel_widen_f32_gather(dst, &((const float *)piece)[value_map[j]],
+                                     num_words, piece_size);
+        } else {
+          d3_kernel_copy_f64_gather(dst, &((const double *)piece)[value_map[j]],
+                                    num_words, piece_size);
+        }
+
+        j++;
+      }
+
+      p += piece_size;
+    }
+
+    i += block_size;
+  }
+
+  return 1;
+}
+
+float *_d3plot_read_element_data_f32(d3plot_file *plot_file, size_t state,
+                                     size_t num_elements, size_t num_words,
+                                     size_t data_type, const size_t *value_map,
+                                     size_t num_values) {
+  if (state >= plot_file->num_states) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+    return NULL;
+  }
+
+  const size_t word_pos = plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+                          plot_file->data_pointers[data_type];
+
+  /* Read the words directly into the returned memory and then move the values
+   * of every element to their final location. If the elements get smaller we
+   * need to go from the front to the back and otherwise from the back to the
+   * front, so that no element is overwritten before it has been moved*/
+  const size_t buffer_stride = num_words > num_values ? num_words : num_values;
+  size_t buffer_size = num_elements * buffer_stride * sizeof(float);
+  if (plot_file->buffer.word_size == 8 &&
+      buffer_size < num_elements * num_words * sizeof(double)) {
+    buffer_size = num_elements * num_words * sizeof(double);
+  }
+  float *values = malloc(buffer_size);
+  d3_buffer_read_words_at(&plot_file->buffer, values, num_elements * num_words,
+                          word_pos);
+  if (plot_file->buffer.word_size == 8) {
+    /* Narrow the doubles in place, so that it looks like a single precision
+     * file from now on*/
+    d3_kernel_narrow_f64(values, (const double *)values,
+                         num_elements * num_words);
+  }
+
+  const int forward = num_values <= num_words;
+
+  /* Combine consecutive values into runs (dst, src, length), so that every
+   * element can be moved by a few memmoves. As long as no value moves in the
+   * opposite direction of the whole element, the element can be moved in
+   * place*/
+  size_t runs[D3PLT_MAX_ELEMENT_VALUES * 3];
+  const size_t num_runs = _d3plot_value_map_runs(value_map, num_values, runs);
+  int in_place = 1;
+  size_t j = 0;
+  while (j < num_values) {
+    if (value_map[j] != D3PLT_NO_VALUE &&
+        (forward ? value_map[j] < j : value_map[j] > j)) {
+      in_place = 0;
+    }
+
+    j++;
+  }
+
+  /* Holds the words of the current element if it can not be moved in place*/
+  float *element = in_place ? NULL : malloc(num_words * sizeof(float));
+
+  size_t i = 0;
+  while (i < num_elements) {
+    const size_t e = forward ? i : num_elements - 1 - i;
+    const float *src = &values[e * num_words];
+    float *dst = &values[e * num_values];
+    if (!in_place) {
+      memcpy(element, src, num_words * sizeof(float));
+      src = element;
+    }
+
+    size_t r = 0;
+    while (r < num_runs) {
+      const size_t *run = &runs[(forward ? r : num_runs - 1 - r) * 3];
+      if (run[1] == D3PLT_NO_VALUE) {
+        memset(&dst[run[0]], 0, run[2] * sizeof(float));
+      } else {
+        memmove(&dst[run[0]], &src[run[1]], run[2] * sizeof(float));
+      }
+
+      r++;
+    }
+
+    i++;
+  }
+
+  free(element);
+
+  if (buffer_size > num_elements * num_values * sizeof(float)) {
+    values = realloc(values, num_elements * num_values * sizeof(float));
+  }
+
+  return values;
+}
+
+d3_word *_d3plot_read_ids(d3plot_file *plot_file, size_t *num_ids,
+                          size_t data_type, size_t num_ids_value) {
+  *num_ids = num_ids_value;
+  if (num_ids_value == 0) {
+    return NULL;
+  }
+
+  d3_word *ids = malloc(*num_ids * sizeof(d3_word));
+  _d3plot_read_u64(plot_file, ids, *num_ids,
+                   plot_file->data_pointers[data_type]);
+
+  return ids;
+}
+
+d3_word *_d3plot_read_id_subset(d3plot_file *plot_file, size_t data_type,
+                                size_t num_ids, const size_t *indices,
+                                size_t num_indices) {
+  if (num_indices == 0) {
+    return NULL;
+  }
+
+  size_t *sorted_items = malloc(num_indices * 2 * sizeof(size_t));
+  size_t *index_runs = malloc(num_indices * 3 * sizeof(size_t));
+  size_t max_run_length;
+  const size_t num_index_runs =
+      _d3plot_index_runs(plot_file, indices, num_indices, num_ids, 1,
+                         sorted_items, index_runs, &max_run_length);
+  if (num_index_runs == 0) {
+    free(index_runs);
+    free(sorted_items);
+    return NULL;
+  }
+
+  d3_word *ids = malloc(num_indices * sizeof(d3_word));
+  d3_word *run_ids = malloc(max_run_length * sizeof(d3_word));
+
+  size_t r = 0;
+  while (r < num_index_runs) {
+    const size_t first_item = index_runs[r * 3 + 0];
+    const size_t end_item = index_runs[r * 3 + 1];
+    _d3plot_read_u64(plot_file, run_ids, end_item - first_item,
+                     plot_file->data_pointers[data_type] + first_item);
+
+    size_t i = index_runs[r * 3 + 2];
+    while (i < num_indices && sorted_items[i * 2] < end_item) {
+      ids[sorted_items[i * 2 + 1]] = run_ids[sorted_items[i * 2] - first_item];
+      i++;
+    }
+
+    r++;
+  }
+
+  free(run_ids);
+  free(index_runs);
+  free(sorted_items);
+
+  return ids;
+}
+
+size_t _d3plot_find_states_at_time(d3plot_file *plot_file, double time,
+                                   double *alpha) {
+  const size_t state = d3plot_find_state(plot_file, time);
+  *alpha = 0.0;
+
+  /* Only interpolate if time lies between two states. Otherwise the first or
+   * last state is used*/
+  if (state + 1 < plot_file->num_states &&
+      time > plot_file->state_times[state]) {
+    *alpha = (time - plot_file->state_times[state]) /
+             (plot_file->state_times[state + 1] -
+              plot_file->state_times[state]);
+  }
+
+  return state;
+}
+
+void _d3plot_interpolate(double *lhs, const double *rhs, double alpha,
+                         size_t num_values) {
+  /* Simple enough for the compiler to vectorise*/
+  size_t i = 0;
+  while (i < num_values) {
+    lhs[i] += alpha * (rhs[i] - lhs[i]);
+
+    i++;
+  }
+}
+
+void d3plot_free_part(d3plot_part *part) {
   free(part->solid_ids);
   free(part->thick_shell_ids);
   free(part->beam_ids);
@@ -1434,4 +3114,20 @@ void d3plot_free_part(d3plot_part *part) {
   part->num_thick_shells = 0;
   part->num_beams = 0;
   part->num_shells = 0;
+}
+
+void d3plot_free_part_state(d3plot_part_state *part_state) {
+  free(part_state->solids);
+  free(part_state->thick_shells);
+  free(part_state->beams);
+  free(part_state->shells);
+
+  part_state->solids = NULL;
+  part_state->thick_shells = NULL;
+  part_state->beams = NULL;
+  part_state->shells = NULL;
+  part_state->num_solids = 0;
+  part_state->num_thick_shells = 0;
+  part_state->num_beams = 0;
+  part_state->num_shells = 0;
 }
\ No newline at end of file
@@ -27,9 +27,48 @@
 #define D3PLOT_H
 #include "d3_buffer.h"
 #include "d3_defines.h"
+#ifndef _WIN32
+#include <pthread.h>
+#endif
 
 struct tm;
 
+/* The kinds of ids that can be looked up. The element types use
+ * D3PLT_ELEMENT_* */
+#define D3PLT_ID_NODE D3PLT_ELEMENT_TYPE_COUNT
+#define D3PLT_ID_PART (D3PLT_ID_NODE + 1)
+#define D3PLT_ID_TYPE_COUNT (D3PLT_ID_PART + 1)
+
+/* The number of elements that are read and converted at once*/
+#define D3PLT_ELEMENT_BLOCK_SIZE 1024
+
+/* The fields of a state that can be held by the state cache*/
+#define D3PLT_CACHE_NODE_COORDINATES 0
+#define D3PLT_CACHE_NODE_VELOCITY 1
+#define D3PLT_CACHE_NODE_ACCELERATION 2
+#define D3PLT_CACHE_SOLIDS 3
+#define D3PLT_CACHE_THICK_SHELLS 4
+#define D3PLT_CACHE_BEAMS 5
+#define D3PLT_CACHE_SHELLS 6
+#define D3PLT_CACHE_NODE_DISPLACEMENT 7
+#define D3PLT_CACHE_FIELD_COUNT 8
+
+/* A decoded field of a state that is shared by the state cache. data holds
+ * num_items nodes (three values each) or elements and must not be modified*/
+typedef struct d3plot_cached_state {
+  void *data;
+  size_t num_items;
+  size_t state;
+  int field;
+  /* The size of data in bytes*/
+  size_t size;
+  /* The cache itself holds one reference as long as the entry is cached*/
+  size_t ref_count;
+  /* The neighbours inside the cache, which is ordered from the most to the
+   * least recently used entry*/
+  struct d3plot_cached_state *prev, *next;
+} d3plot_cached_state;
+
 /* This holds all data needed to read d3plot files*/
 typedef struct {
   struct {
@@ -55,12 +94,113 @@ typedef struct {
   /* This array holds the word locations of different data*/
   size_t *data_pointers;
   size_t num_states;
+  /* The number of words of one state. All states have the same size*/
+  size_t state_size;
+  /* The time of every state. They are read when the states are indexed*/
+  double *state_times;
+  /* The elements of every part for every element type (D3PLT_ELEMENT_*) in
+   * CSR format. The indices of the elements of part p are stored inside
+   * part_elements[type] from part_offsets[type][p] until
+   * part_offsets[type][p + 1]. Both are built by the first function that needs
+   * them and are NULL until then*/
+  size_t *part_offsets[D3PLT_ELEMENT_TYPE_COUNT];
+  size_t *part_elements[D3PLT_ELEMENT_TYPE_COUNT];
+  /* The ids of the elements (D3PLT_ELEMENT_*), nodes and parts sorted in
+   * ascending order and the index of every sorted id. sorted_id_indices is
+   * NULL if the ids are already sorted inside the files. Both are built by the
+   * first lookup of the ids and are NULL until then*/
+  d3_word *sorted_ids[D3PLT_ID_TYPE_COUNT];
+  size_t *sorted_id_indices[D3PLT_ID_TYPE_COUNT];
+  /* The state cache (see d3plot_cache_get). cache_size is the size of all
+   * cached entries in bytes and never exceeds max_cache_size*/
+  d3plot_cached_state *cache_first, *cache_last;
+  size_t cache_size, max_cache_size;
+  /* Temporary memory of the state functions. It is kept between calls, so
+   * that reading many states does not allocate it again every time*/
+  void *scratch;
+  size_t scratch_size;
+  /* The node coordinates of the GEOMETRY DATA section (numnp * 3 values)
+   * which are subtracted to get the displacement. They are read by the first
+   * function that needs them and are NULL until then*/
+  double *initial_coordinates;
 
   d3_buffer buffer;
   /* This holds an error after calling some functions*/
   char *error_string;
 } d3plot_file;
 
+/* Selects every field of d3plot_state_iter_begin. Single fields are selected
+ * by (1 << D3PLT_CACHE_*)*/
+#define D3PLT_ITER_ALL ((1 << D3PLT_CACHE_FIELD_COUNT) - 1)
+
+/* One state returned by d3plot_state_iter_next*/
+typedef struct {
+  size_t state;
+  double time;
+  /* The fields (D3PLT_CACHE_*) of the state. Fields that have not been
+   * selected or that do not have any items are NULL*/
+  void *data[D3PLT_CACHE_FIELD_COUNT];
+  size_t num_items[D3PLT_CACHE_FIELD_COUNT];
+} d3plot_state_data;
+
+/* Streams every state of a d3plot file. While the caller processes one state
+ * the next one is read into a second buffer by a background thread*/
+typedef struct {
+  d3plot_file *plot_file;
+  /* A copy of plot_file with its own file handles and scratch memory. It is
+   * only used by the background thread*/
+  d3plot_file reader;
+  /* The state that is returned by the next call of d3plot_state_iter_next.
+   * It is read into buffers[next_state % 2]*/
+  size_t next_state;
+  d3plot_state_data buffers[2];
+  /* The background thread is started once by d3plot_state_iter_begin and
+   * reads every state that is requested by _d3plot_state_iter_prefetch. 0 if
+   * it could not be started, then the states are read by the caller*/
+  int has_thread;
+  /* 1 from requesting a state until it has been read*/
+  int busy;
+  /* Tells the background thread to return*/
+  int quit;
+#ifdef _WIN32
+  /* HANDLEs of the thread and two auto reset events. request_event is set by
+   * the caller and done_event by the thread*/
+  void *thread;
+  void *request_event;
+  void *done_event;
+#else
+  pthread_t thread;
+  /* Guards busy and quit. cond is signalled whenever busy changes*/
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+#endif
+  int read_result;
+} d3plot_state_iter;
+
+/* The largest and smallest value of a quantity of every node or element over
+ * all states (see d3plot_read_envelopes)*/
+typedef struct {
+  double *max, *min;
+  /* The first state at which max or min has been reached*/
+  size_t *max_state, *min_state;
+  size_t num_items;
+} d3plot_envelope;
+
+/* The smallest and largest value of quantities (D3PLT_ZONE_*) of every part
+ * at every state (see d3plot_build_zone_map). Quantity q of part p at state s
+ * is stored at (s * num_parts + p) * D3PLT_ZONE_QUANTITY_COUNT + q. Parts
+ * without any value of a quantity have a min of HUGE_VAL and a max of
+ * -HUGE_VAL*/
+typedef struct {
+  double *min, *max;
+  size_t num_states, num_parts;
+  /* The quantities that have been summarized. Queries of other quantities
+   * cannot skip anything*/
+  unsigned int quantities;
+  /* The surface (D3PLT_SURFACE_*) of shells and thick shells*/
+  int surface;
+} d3plot_zone_map;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -68,8 +208,97 @@ extern "C" {
 /* Open a d3plot file family by giving the root file name
  * Example: d3plot of d3plot01, d3plot02, d3plot03, etc.*/
 d3plot_file d3plot_open(const char *root_file_name);
+/* Works the same as d3plot_open, but loads the layout of the files (control
+ * data, data pointers and states) from an index file. If the index file does
+ * not exist or if any file of the family has been changed since the index has
+ * been written, the files are parsed normally and the index is (re)written*/
+d3plot_file d3plot_open_indexed(const char *root_file_name,
+                                const char *index_file_name);
+/* Write the layout of the files into an index file which can be used by
+ * d3plot_open_indexed. Returns 0 on failure and sets error_string*/
+int d3plot_write_index(d3plot_file *plot_file, const char *index_file_name);
 /* Close a d3plot_file and deallocate all the memory*/
 void d3plot_close(d3plot_file *plot_file);
+/* Set the memory budget of the state cache in bytes and evict the least
+ * recently used entries that do not fit into it anymore. A budget of 0 (the
+ * default) disables the cache*/
+void d3plot_set_cache_size(d3plot_file *plot_file, size_t max_cache_size);
+/* Returns a field (D3PLT_CACHE_*) of a state from the state cache or reads it
+ * if it is not cached. The entry stays valid until it has been given to
+ * d3plot_cache_release, even if it gets evicted or plot_file is closed.
+ * Returns NULL on failure*/
+d3plot_cached_state *d3plot_cache_get(d3plot_file *plot_file, size_t state,
+                                      int field);
+/* Add another reference to an entry returned by d3plot_cache_get*/
+void d3plot_cache_retain(d3plot_cached_state *entry);
+/* Give back a reference to an entry. The entry is deallocated once it has
+ * been evicted and all references are given back*/
+void d3plot_cache_release(d3plot_cached_state *entry);
+/* Start streaming every state of plot_file. fields selects which fields
+ * (1 << D3PLT_CACHE_*) are read. Both buffers of iter and its background
+ * thread are created once, so that nothing is allocated per state. iter must
+ * not be moved and plot_file must not be refreshed or closed before
+ * d3plot_state_iter_end has been called. Returns 0 on failure*/
+int d3plot_state_iter_begin(d3plot_file *plot_file, d3plot_state_iter *iter,
+                            unsigned int fields);
+/* Returns the next state and starts reading the one after it in the
+ * background. The returned data stays valid until the next call. Returns NULL
+ * after the last state or on failure (error_string of plot_file is set)*/
+d3plot_state_data *d3plot_state_iter_next(d3plot_state_iter *iter);
+/* Stops the background thread and deallocates everything of iter*/
+void d3plot_state_iter_end(d3plot_state_iter *iter);
+/* Reduce quantities (D3PLT_ENVELOPE_*) to their largest and smallest value
+ * per node or element over all states. surface (D3PLT_SURFACE_*) selects the
+ * integration point of shells and thick shells. envelopes needs to hold
+ * D3PLT_ENVELOPE_QUANTITY_COUNT envelopes, of which the ones whose bit is not
+ * set inside quantities are left empty. Every state is read once. The states
+ * are split into num_threads ranges, which are reduced in parallel with their
+ * own file handles and merged afterwards. Items that are NaN in every state
+ * keep -HUGE_VAL and HUGE_VAL. The envelopes need to be deallocated by
+ * d3plot_free_envelope. Returns 0 on failure*/
+int d3plot_read_envelopes(d3plot_file *plot_file, unsigned int quantities,
+                          int surface, size_t num_threads,
+                          d3plot_envelope *envelopes);
+/* Summarize quantities (D3PLT_ZONE_*) by their smallest and largest value per
+ * part and state in one pass over all states. surface (D3PLT_SURFACE_*)
+ * selects the integration point of shells and thick shells. Quantities that
+ * are not inside the files are not summarized. The zone map needs to be
+ * deallocated by d3plot_free_zone_map. Returns 0 on failure*/
+int d3plot_build_zone_map(d3plot_file *plot_file, unsigned int quantities,
+                          int surface, d3plot_zone_map *zone_map);
+/* Works the same as d3plot_build_zone_map, but loads the zone map from a file.
+ * If the file does not exist, any file of the family has been changed since it
+ * has been written or it does not hold all quantities at surface, the zone map
+ * is built and the file is (re)written*/
+int d3plot_open_zone_map(d3plot_file *plot_file, unsigned int quantities,
+                         int surface, const char *zone_map_file_name,
+                         d3plot_zone_map *zone_map);
+/* Write a zone map into a file which can be used by d3plot_open_zone_map.
+ * Returns 0 on failure and sets error_string*/
+int d3plot_write_zone_map(d3plot_file *plot_file,
+                          const d3plot_zone_map *zone_map,
+                          const char *zone_map_file_name);
+/* Returns the states at which any part of part_indices may hold a value of
+ * quantity (D3PLT_ZONE_*) inside [min_value, max_value]. All parts are
+ * checked if part_indices is NULL. Use HUGE_VAL for open ranges. Only the
+ * returned states need to be read. The return value needs to be deallocated
+ * by free*/
+size_t *d3plot_zone_map_states(const d3plot_zone_map *zone_map, int quantity,
+                               double min_value, double max_value,
+                               const size_t *part_indices,
+                               size_t num_part_indices, size_t *num_states);
+/* Returns the parts which may hold a value of quantity inside
+ * [min_value, max_value] at state (see d3plot_zone_map_states). Only the
+ * returned parts need to be read (see d3plot_read_part_state). The return
+ * value needs to be deallocated by free*/
+size_t *d3plot_zone_map_parts(const d3plot_zone_map *zone_map, size_t state,
+                              int quantity, double min_value, double max_value,
+                              size_t *num_parts);
+/* Look for states that have been written since opening or the last refresh.
+ * New files of the family are opened and only the new states are indexed. A
+ * state that has not been completely written yet is ignored until it is
+ * complete. Returns 0 on failure and sets error_string*/
+int d3plot_refresh(d3plot_file *plot_file);
 /* Read all ids of the nodes. The return value needs to be deallocated by free*/
 d3_word *d3plot_read_node_ids(d3plot_file *plot_file, size_t *num_ids);
 /* Read all ids of the solid elements. The return value needs to be deallocated
@@ -88,12 +317,35 @@ d3_word *d3plot_read_thick_shell_element_ids(d3plot_file *plot_file,
 /* Read all ids of the solid, beam, shell and solid shell elements. The return
  * value needs to be deallocated by free*/
 d3_word *d3plot_read_all_element_ids(d3plot_file *plot_file, size_t *num_ids);
+/* Same as d3plot_read_all_element_ids, but also returns the type
+ * (D3PLT_ELEMENT_*) and the index inside the elements of that type of every
+ * id. element_types and element_indices need to be deallocated by free*/
+d3_word *d3plot_read_all_element_ids_origin(d3plot_file *plot_file,
+                                            size_t *num_ids,
+                                            uint8_t **element_types,
+                                            size_t **element_indices);
 /* Read all ids of the parts. The return value needs to be deallocated by free*/
 d3_word *d3plot_read_part_ids(d3plot_file *plot_file, size_t *num_parts);
 /* Returns an array containing null terminated strings for the part titles. Each
  * element of the array needs to be deallocated by free and the array itself
  * also needs to deallocated by free*/
 char **d3plot_read_part_titles(d3plot_file *plot_file, size_t *num_parts);
+/* The following functions look up the indices of num_ids ids of nodes,
+ * elements or parts and write them into indices. Ids that do not exist are set
+ * to D3PLT_INVALID_INDEX. The lookup structure is built on the first call.
+ * Returns the number of ids that have been found*/
+size_t d3plot_node_indices(d3plot_file *plot_file, const d3_word *ids,
+                           size_t num_ids, size_t *indices);
+size_t d3plot_solid_indices(d3plot_file *plot_file, const d3_word *ids,
+                            size_t num_ids, size_t *indices);
+size_t d3plot_thick_shell_indices(d3plot_file *plot_file, const d3_word *ids,
+                                  size_t num_ids, size_t *indices);
+size_t d3plot_beam_indices(d3plot_file *plot_file, const d3_word *ids,
+                           size_t num_ids, size_t *indices);
+size_t d3plot_shell_indices(d3plot_file *plot_file, const d3_word *ids,
+                            size_t num_ids, size_t *indices);
+size_t d3plot_part_indices(d3plot_file *plot_file, const d3_word *ids,
+                           size_t num_ids, size_t *indices);
 /* Returns an array containing all axes of all nodes at a given state. See:
  * XYZXYZXYZXYZ...*/
 /* Read the node coordinates of all nodes of a given state (time step). The
@@ -111,8 +363,65 @@ double *d3plot_read_node_velocity(d3plot_file *plot_file, size_t state,
  * with index 20: rv[20*3+0], rv[20*3+1], rv[20*3+2]*/
 double *d3plot_read_node_acceleration(d3plot_file *plot_file, size_t state,
                                       size_t *num_nodes);
+/* Same as the functions above, but write into coords which needs to be able
+ * to hold numnp * 3 values. Returns 0 on failure*/
+int d3plot_read_node_coordinates_into(d3plot_file *plot_file, size_t state,
+                                      double *coords);
+int d3plot_read_node_velocity_into(d3plot_file *plot_file, size_t state,
+                                   double *velocity);
+int d3plot_read_node_acceleration_into(d3plot_file *plot_file, size_t state,
+                                       double *acceleration);
+/* Read the node coordinates of the GEOMETRY DATA section, which are the
+ * coordinates before the first state. The return value needs to be
+ * deallocated by free*/
+double *d3plot_read_node_initial_coordinates(d3plot_file *plot_file,
+                                             size_t *num_nodes);
+/* Read the displacement (coordinates minus initial coordinates) of all nodes
+ * of a given state. The initial coordinates are only read once. The return
+ * value needs to be deallocated by free*/
+double *d3plot_read_node_displacement(d3plot_file *plot_file, size_t state,
+                                      size_t *num_nodes);
+/* Read the length of the displacement of every node of a given state. The
+ * return value needs to be deallocated by free*/
+double *d3plot_read_node_displacement_magnitude(d3plot_file *plot_file,
+                                                size_t state,
+                                                size_t *num_nodes);
+/* Same as d3plot_read_node_displacement, but writes into displacement which
+ * needs to be able to hold numnp * 3 values. If magnitudes is not NULL the
+ * length of every displacement (numnp values) is written into it in the same
+ * pass. displacement may be NULL if only the magnitudes are needed. Returns 0
+ * on failure*/
+int d3plot_read_node_displacement_into(d3plot_file *plot_file, size_t state,
+                                       double *displacement,
+                                       double *magnitudes);
 /* Read the time of a given state (time step) in milliseconds*/
 double d3plot_read_time(d3plot_file *plot_file, size_t state);
+/* Returns the times of all states (time steps) in milliseconds. This does not
+ * need to read anything from the files. The return value needs to be
+ * deallocated by free*/
+double *d3plot_read_times(d3plot_file *plot_file, size_t *num_states);
+/* Returns all NGLBV words of the GLOBAL block (kinetic, internal and total
+ * energy, velocity and the values of every material, see D3PLT_GLOBAL_*) of
+ * all states as a num_states * num_globals matrix. The return value needs to be
+ * deallocated by free*/
+double *d3plot_read_global_history(d3plot_file *plot_file, size_t *num_states,
+                                   size_t *num_globals);
+/* Read the values of every part (internal and kinetic energy, velocity, mass
+ * and force) out of the GLOBAL block of all states. histories needs to hold
+ * D3PLT_PART_QUANTITY_COUNT pointers. For every quantity (D3PLT_PART_*) whose
+ * bit is set inside quantities, a num_states * num_parts matrix is allocated
+ * and the others are set to NULL. The parts are ordered like in the files:
+ * solid, beam, shell and thick shell materials followed by the rigid bodies.
+ * All quantities are taken out of one pass over the states. The matrices need
+ * to be deallocated by free. Returns 0 on failure*/
+int d3plot_read_part_global_history(d3plot_file *plot_file,
+                                    unsigned int quantities,
+                                    double **histories, size_t *num_states,
+                                    size_t *num_parts);
+/* Returns the index of the last state (time step) whose time is less than or
+ * equal to time. Returns 0 if time lies before the first state. This uses a
+ * binary search over the times of the states*/
+size_t d3plot_find_state(d3plot_file *plot_file, double time);
 /* Returns stress, strain (if NEIPH >= 6) for a given state. The return value
  * needs to be deallocated by free.*/
 d3plot_solid *d3plot_read_solids_state(d3plot_file *plot_file, size_t state,
@@ -132,6 +441,195 @@ d3plot_beam *d3plot_read_beams_state(d3plot_file *plot_file, size_t state,
  * by free.*/
 d3plot_shell *d3plot_read_shells_state(d3plot_file *plot_file, size_t state,
                                        size_t *num_shells);
+/* Same as the functions above, but write into memory that needs to be able to
+ * hold nel8, nelt, nel2 or nel4 elements. Returns 0 on failure*/
+int d3plot_read_solids_state_into(d3plot_file *plot_file, size_t state,
+                                  d3plot_solid *solids);
+int d3plot_read_thick_shells_state_into(d3plot_file *plot_file, size_t state,
+                                        d3plot_thick_shell *thick_shells);
+int d3plot_read_beams_state_into(d3plot_file *plot_file, size_t state,
+                                 d3plot_beam *beams);
+int d3plot_read_shells_state_into(d3plot_file *plot_file, size_t state,
+                                  d3plot_shell *shells);
+/* Returns one flag per node of a given state that is 1 if the node is active
+ * and 0 if it has been deleted. Only available if MDLOPT == 1. The return
+ * value needs to be deallocated by free.*/
+uint8_t *d3plot_read_node_deletion(d3plot_file *plot_file, size_t state,
+                                   size_t *num_nodes);
+/* Returns one flag per element of a given state that is 1 if the element is
+ * active and 0 if it has been deleted (eroded). Only available if MDLOPT == 2.
+ * The return value needs to be deallocated by free.*/
+uint8_t *d3plot_read_solids_deletion(d3plot_file *plot_file, size_t state,
+                                     size_t *num_solids);
+uint8_t *d3plot_read_thick_shells_deletion(d3plot_file *plot_file,
+                                           size_t state,
+                                           size_t *num_thick_shells);
+uint8_t *d3plot_read_beams_deletion(d3plot_file *plot_file, size_t state,
+                                    size_t *num_beams);
+uint8_t *d3plot_read_shells_deletion(d3plot_file *plot_file, size_t state,
+                                     size_t *num_shells);
+/* Same as d3plot_read_solids_state etc., but only returns the elements that
+ * are active in the given state. The indices of the returned elements are
+ * stored in element_indices (in ascending order), which needs to be
+ * deallocated by free as well. If the file does not contain element deletion
+ * data (MDLOPT != 2) all elements are returned*/
+d3plot_solid *d3plot_read_solids_state_alive(d3plot_file *plot_file,
+                                             size_t state, size_t *num_solids,
+                                             size_t **element_indices);
+d3plot_thick_shell *
+d3plot_read_thick_shells_state_alive(d3plot_file *plot_file, size_t state,
+                                     size_t *num_thick_shells,
+                                     size_t **element_indices);
+d3plot_beam *d3plot_read_beams_state_alive(d3plot_file *plot_file,
+                                           size_t state, size_t *num_beams,
+                                           size_t **element_indices);
+d3plot_shell *d3plot_read_shells_state_alive(d3plot_file *plot_file,
+                                             size_t state, size_t *num_shells,
+                                             size_t **element_indices);
+/* Returns the von Mises stress, the pressure or the three principal
+ * stresses (in descending order) of every element for a given state. They are
+ * computed directly from the stresses inside the files without reading the
+ * remaining values of the elements. The surface (D3PLT_SURFACE_*) selects the
+ * integration point of shells and thick shells. The return value needs to be
+ * deallocated by free.*/
+double *d3plot_read_solids_von_mises(d3plot_file *plot_file, size_t state,
+                                     size_t *num_solids);
+double *d3plot_read_solids_pressure(d3plot_file *plot_file, size_t state,
+                                    size_t *num_solids);
+double *d3plot_read_solids_principal_stresses(d3plot_file *plot_file,
+                                              size_t state,
+                                              size_t *num_solids);
+double *d3plot_read_thick_shells_von_mises(d3plot_file *plot_file,
+                                           size_t state, int surface,
+                                           size_t *num_thick_shells);
+double *d3plot_read_thick_shells_pressure(d3plot_file *plot_file, size_t state,
+                                          int surface,
+                                          size_t *num_thick_shells);
+double *d3plot_read_thick_shells_principal_stresses(d3plot_file *plot_file,
+                                                    size_t state, int surface,
+                                                    size_t *num_thick_shells);
+double *d3plot_read_shells_von_mises(d3plot_file *plot_file, size_t state,
+                                     int surface, size_t *num_shells);
+double *d3plot_read_shells_pressure(d3plot_file *plot_file, size_t state,
+                                    int surface, size_t *num_shells);
+double *d3plot_read_shells_principal_stresses(d3plot_file *plot_file,
+                                              size_t state, int surface,
+                                              size_t *num_shells);
+/* The following functions work the same as their counterparts without
+ * _at_time. Instead of a state they take a time in milliseconds. Only the two
+ * states around time are read and linearly interpolated. If time lies before
+ * the first or after the last state, the values of that state are returned*/
+double *d3plot_read_node_coordinates_at_time(d3plot_file *plot_file,
+                                             double time, size_t *num_nodes);
+double *d3plot_read_node_velocity_at_time(d3plot_file *plot_file, double time,
+                                          size_t *num_nodes);
+double *d3plot_read_node_acceleration_at_time(d3plot_file *plot_file,
+                                              double time, size_t *num_nodes);
+d3plot_solid *d3plot_read_solids_state_at_time(d3plot_file *plot_file,
+                                               double time,
+                                               size_t *num_solids);
+d3plot_thick_shell *
+d3plot_read_thick_shells_state_at_time(d3plot_file *plot_file, double time,
+                                       size_t *num_thick_shells);
+d3plot_beam *d3plot_read_beams_state_at_time(d3plot_file *plot_file,
+                                             double time, size_t *num_beams);
+d3plot_shell *d3plot_read_shells_state_at_time(d3plot_file *plot_file,
+                                               double time,
+                                               size_t *num_shells);
+/* The following functions work the same as their counterparts without _f32,
+ * but return single precision values. If the d3plot files are single
+ * precision the values are read directly into the returned memory*/
+float *d3plot_read_node_coordinates_f32(d3plot_file *plot_file, size_t state,
+                                        size_t *num_nodes);
+float *d3plot_read_node_velocity_f32(d3plot_file *plot_file, size_t state,
+                                     size_t *num_nodes);
+float *d3plot_read_node_acceleration_f32(d3plot_file *plot_file, size_t state,
+                                         size_t *num_nodes);
+d3plot_solid_f32 *d3plot_read_solids_state_f32(d3plot_file *plot_file,
+                                               size_t state,
+                                               size_t *num_solids);
+d3plot_shell_f32 *d3plot_read_shells_state_f32(d3plot_file *plot_file,
+                                               size_t state,
+                                               size_t *num_shells);
+/* The following functions work the same as their counterparts without
+ * _fields, but only read the values selected by fields (D3PLT_FIELD_*). The
+ * selected values are stored in the order of the element struct and
+ * num_values is set to the number of values per element. The return value
+ * needs to be deallocated by free*/
+double *d3plot_read_solids_state_fields(d3plot_file *plot_file, size_t state,
+                                        unsigned int fields,
+                                        size_t *num_solids,
+                                        size_t *num_values);
+double *d3plot_read_thick_shells_state_fields(d3plot_file *plot_file,
+                                              size_t state,
+                                              unsigned int fields,
+                                              size_t *num_thick_shells,
+                                              size_t *num_values);
+double *d3plot_read_shells_state_fields(d3plot_file *plot_file, size_t state,
+                                        unsigned int fields,
+                                        size_t *num_shells,
+                                        size_t *num_values);
+/* The following functions work the same as their counterparts without _soa,
+ * but write every component into its own array instead of interleaving them.
+ * The arrays are supplied by the caller and need to be able to hold one value
+ * per node or element. The element functions take one array per value of the
+ * element struct (see D3PLT_COMPONENT). Arrays that are NULL are skipped.
+ * Returns 0 on failure*/
+int d3plot_read_node_coordinates_soa(d3plot_file *plot_file, size_t state,
+                                     double *x, double *y, double *z);
+int d3plot_read_node_velocity_soa(d3plot_file *plot_file, size_t state,
+                                  double *x, double *y, double *z);
+int d3plot_read_node_acceleration_soa(d3plot_file *plot_file, size_t state,
+                                      double *x, double *y, double *z);
+int d3plot_read_solids_state_soa(d3plot_file *plot_file, size_t state,
+                                 double **components);
+int d3plot_read_thick_shells_state_soa(d3plot_file *plot_file, size_t state,
+                                       double **components);
+int d3plot_read_beams_state_soa(d3plot_file *plot_file, size_t state,
+                                double **components);
+int d3plot_read_shells_state_soa(d3plot_file *plot_file, size_t state,
+                                 double **components);
+/* Read the node coordinates, velocity or acceleration of the nodes at
+ * node_indices over all states. Only the words of the requested nodes are read.
+ * Returns an array of num_states * num_indices * 3 values, in which the values
+ * of a state are stored in the order of node_indices. The return value needs
+ * to be deallocated by free*/
+double *d3plot_read_node_coordinates_history(d3plot_file *plot_file,
+                                             const size_t *node_indices,
+                                             size_t num_indices,
+                                             size_t *num_states);
+double *d3plot_read_node_velocity_history(d3plot_file *plot_file,
+                                          const size_t *node_indices,
+                                          size_t num_indices,
+                                          size_t *num_states);
+double *d3plot_read_node_acceleration_history(d3plot_file *plot_file,
+                                              const size_t *node_indices,
+                                              size_t num_indices,
+                                              size_t *num_states);
+/* The following functions read the values of the elements at element_indices
+ * over all states. Only the words of the requested elements are read. fields
+ * selects the values (see the _fields functions) and num_values is set to the
+ * number of values per element. Returns an array of num_states * num_indices *
+ * num_values values, in which the elements of a state are stored in the order
+ * of element_indices. Beams always return all values of d3plot_beam. The
+ * return value needs to be deallocated by free*/
+double *d3plot_read_solids_history(d3plot_file *plot_file,
+                                   const size_t *element_indices,
+                                   size_t num_indices, unsigned int fields,
+                                   size_t *num_states, size_t *num_values);
+double *d3plot_read_thick_shells_history(d3plot_file *plot_file,
+                                         const size_t *element_indices,
+                                         size_t num_indices,
+                                         unsigned int fields,
+                                         size_t *num_states,
+                                         size_t *num_values);
+double *d3plot_read_beams_history(d3plot_file *plot_file,
+                                  const size_t *element_indices,
+                                  size_t num_indices, size_t *num_states);
+double *d3plot_read_shells_history(d3plot_file *plot_file,
+                                   const size_t *element_indices,
+                                   size_t num_indices, unsigned int fields,
+                                   size_t *num_states, size_t *num_values);
 /* Returns the node connectivity + material number of all 8 node solid
  * elements. The return value needs to be deallocated by free*/
 d3plot_solid_con *d3plot_read_solid_elements(d3plot_file *plot_file,
@@ -158,6 +656,12 @@ struct tm *d3plot_read_run_time(d3plot_file *plot_file);
  * over the array returned by d3plot_read_part_ids. The return value needs to be
  * deallocated by _d3plot_free_part*/
 d3plot_part d3plot_read_part(d3plot_file *plot_file, size_t part_index);
+/* Returns the states of all elements of a part at a given state. Only the
+ * words of the elements of the part are read. The elements are stored in the
+ * same order as the ids returned by d3plot_read_part. The return value needs to
+ * be deallocated by d3plot_free_part_state*/
+d3plot_part_state d3plot_read_part_state(d3plot_file *plot_file,
+                                         size_t part_index, size_t state);
 
 /***** Data sections *******/
 /* GEOMETRY DATA pg. 17*/
@@ -171,11 +675,19 @@ int _d3plot_read_extra_node_connectivity(d3plot_file *plot_file);
 int _d3plot_read_adapted_element_parent_list(d3plot_file *plot_file);
 /* HEADER, PART & CONTACT INTERFACE TITLES pg. 22*/
 int _d3plot_read_header(d3plot_file *plot_file);
-/* STATE DATA pg. 31*/
+/* STATE DATA pg. 31. Only computes the layout and size of a state from the
+ * CONTROL DATA without reading anything*/
 int _d3plot_read_state_data(d3plot_file *plot_file);
+/* Find all states starting at word_pos by using the state size. Only the time
+ * of each state is read to detect the EOF markers. The times are stored inside
+ * state_times*/
+int _d3plot_index_states(d3plot_file *plot_file, size_t word_pos);
 /***************************/
 
 /***** Private Functions ********/
+/* Set every member of plot_file that is deallocated by d3plot_close to its
+ * empty value. Used by all functions that open a d3plot_file*/
+void _d3plot_init_file(d3plot_file *plot_file);
 /* Return a string representing the given file type*/
 const char *_d3plot_get_file_type_name(d3_word file_type);
 /* Return the nth digit of an integer as an integer.
@@ -186,14 +698,253 @@ int _get_nth_digit(d3_word value, int n);
  * data_type is one of the D3PLT_PTR values*/
 double *_d3plot_read_node_data(d3plot_file *plot_file, size_t state,
                                size_t *num_nodes, size_t data_type);
+/* Same as _d3plot_read_node_data, but writes into dst. Returns 0 on failure*/
+int _d3plot_read_node_data_into(d3plot_file *plot_file, size_t state,
+                                size_t data_type, double *dst);
+/* Same as _d3plot_read_node_data, but returns single precision values*/
+float *_d3plot_read_node_data_f32(d3plot_file *plot_file, size_t state,
+                                  size_t *num_nodes, size_t data_type);
+/* Returns the initial coordinates of plot_file and reads them if they have
+ * not been read yet*/
+const double *_d3plot_initial_coordinates(d3plot_file *plot_file);
+/* Read the history of node data (see _d3plot_read_node_data)*/
+double *_d3plot_read_node_history(d3plot_file *plot_file,
+                                  const size_t *node_indices,
+                                  size_t num_indices, size_t *num_states,
+                                  size_t data_type);
+/* Read the history of element data. If value_fields is not NULL only the
+ * values selected by fields are read (see _d3plot_read_element_data_fields)*/
+double *_d3plot_read_element_history(d3plot_file *plot_file,
+                                     const size_t *element_indices,
+                                     size_t num_indices, size_t num_elements,
+                                     size_t num_words, size_t data_type,
+                                     size_t *value_map, size_t num_values,
+                                     const unsigned int *value_fields,
+                                     unsigned int fields, size_t *num_states,
+                                     size_t *num_selected_values);
+/* Read the values of the items (nodes or elements with num_words words each) at
+ * indices over all states and convert them using value_map (see
+ * _d3plot_read_element_data). Returns num_states * num_indices * num_values
+ * values*/
+double *_d3plot_read_history(d3plot_file *plot_file, const size_t *indices,
+                             size_t num_indices, size_t num_items,
+                             size_t num_words, size_t data_type,
+                             const size_t *value_map, size_t num_values,
+                             size_t *num_states);
+/* Read the elements at element_indices of one state and convert them using
+ * value_map. Returns num_indices * num_values values*/
+double *_d3plot_read_element_subset(d3plot_file *plot_file, size_t state,
+                                    const size_t *element_indices,
+                                    size_t num_indices, size_t num_elements,
+                                    size_t num_words, size_t data_type,
+                                    const size_t *value_map,
+                                    size_t num_values);
+/* Read every field of state that has a buffer in data into it. Used by the
+ * background thread of d3plot_state_iter. Returns 0 on failure*/
+int _d3plot_state_iter_read(d3plot_file *plot_file, size_t state,
+                            d3plot_state_data *data);
+/* Start reading iter->next_state in the background. Reads it directly if
+ * there is no background thread*/
+void _d3plot_state_iter_prefetch(d3plot_state_iter *iter);
+/* Wait until the background thread has finished reading*/
+void _d3plot_state_iter_wait(d3plot_state_iter *iter);
+/* Copy plot_file into reader, which gets its own file handles, scratch memory
+ * and state cache. Everything else is shared with plot_file. The
+ * buffer.error_string of reader is set on failure*/
+void _d3plot_open_reader(d3plot_file *plot_file, d3plot_file *reader);
+/* Close everything that has been opened by _d3plot_open_reader*/
+void _d3plot_close_reader(d3plot_file *reader);
+/* Returns the number of elements of element_type (solids, thick shells or
+ * shells) and the layout of their state words: num_words words per element
+ * starting at data_pointers[data_type]. The words of the stress tensor and
+ * the effective plastic strain of surface inside of an element are written
+ * into stress_word and plastic_strain_word (D3PLT_NO_VALUE if they are not
+ * inside the files)*/
+size_t _d3plot_surface_words(d3plot_file *plot_file, int element_type,
+                             int surface, size_t *num_words, size_t *data_type,
+                             size_t *stress_word, size_t *plastic_strain_word);
+/* Reduce the states from first_state until end_state into envelopes, which
+ * have already been allocated. Envelopes without any items are skipped.
+ * Returns 0 on failure*/
+int _d3plot_reduce_envelopes(d3plot_file *plot_file, int surface,
+                             size_t first_state, size_t end_state,
+                             d3plot_envelope *envelopes);
+/* Merge src into dst. dst wins if both are equal, so that src needs to hold
+ * later states*/
+void _d3plot_merge_envelope(d3plot_envelope *dst, const d3plot_envelope *src);
+/* Returns the quantities (D3PLT_ZONE_*) of quantities that can be summarized
+ * by a zone map at surface*/
+unsigned int _d3plot_zone_map_quantities(d3plot_file *plot_file,
+                                         unsigned int quantities, int surface);
+/* Read the stress tensors of one state and compute quantity
+ * (D3PLT_STRESS_*) of every element of element_type (D3PLT_ELEMENT_*) at
+ * surface (D3PLT_SURFACE_*) from them*/
+double *_d3plot_read_stress(d3plot_file *plot_file, size_t state,
+                            int element_type, int surface, int quantity,
+                            size_t *num_elements);
+/* Read the deletion flags of num_items items that start offset words after
+ * the beginning of the deletion data of a state. Returns NULL and sets the
+ * error_string if MDLOPT is not equal to mdlopt*/
+uint8_t *_d3plot_read_deletion(d3plot_file *plot_file, size_t state,
+                               int mdlopt, size_t offset, size_t num_items);
+/* Read only the active elements of one state. offset is the position of the
+ * deletion flags of the element type inside the deletion data*/
+double *_d3plot_read_element_alive(d3plot_file *plot_file, size_t state,
+                                   size_t offset, size_t num_elements,
+                                   size_t num_words, size_t data_type,
+                                   const size_t *value_map, size_t num_values,
+                                   size_t *num_alive,
+                                   size_t **element_indices);
+/* Sort indices into sorted_items (2 * num_indices values) and combine them
+ * into runs of (first item, last item + 1, first entry of sorted_items) that
+ * are read at once. index_runs needs to be able to hold 3 * num_indices
+ * values. Returns the number of runs or 0 if an index is out of bounds*/
+size_t _d3plot_index_runs(d3plot_file *plot_file, const size_t *indices,
+                          size_t num_indices, size_t num_items,
+                          size_t num_words, size_t *sorted_items,
+                          size_t *index_runs, size_t *max_run_length);
+/* Read the runs of items of the state data at word_pos into run_data and
+ * convert every item into dst using value_runs (see _d3plot_value_map_runs).
+ * run_data needs to be able to hold the words of the longest run*/
+void _d3plot_read_index_runs(d3plot_file *plot_file, size_t word_pos,
+                             size_t num_words, const size_t *sorted_items,
+                             size_t num_indices, const size_t *index_runs,
+                             size_t num_index_runs, const size_t *value_runs,
+                             size_t num_value_runs, size_t num_values,
+                             void *run_data, double *dst);
+/* Build part_offsets and part_elements of plot_file from a single pass over
+ * the connectivity of every element type. Does nothing if they have already
+ * been built*/
+void _d3plot_build_part_index(d3plot_file *plot_file);
+/* Returns the indices of the elements of type (D3PLT_ELEMENT_*) that belong to
+ * part_index. The returned memory belongs to plot_file*/
+const size_t *_d3plot_part_elements(d3plot_file *plot_file, int type,
+                                    size_t part_index, size_t *num_elements);
+/* Build sorted_ids and sorted_id_indices of id_type (D3PLT_ELEMENT_* or
+ * D3PLT_ID_*) from the ids at data_type. Does nothing if they have already
+ * been built. Returns the number of ids*/
+size_t _d3plot_build_id_index(d3plot_file *plot_file, int id_type,
+                              size_t data_type, size_t num_ids);
+/* Look up ids of id_type using binary search (see d3plot_node_indices)*/
+size_t _d3plot_id_indices(d3plot_file *plot_file, int id_type,
+                          size_t data_type, size_t num_type_ids,
+                          const d3_word *ids, size_t num_ids, size_t *indices);
+/* Merge the sorted ids of all element types. element_types and
+ * element_indices receive the origin of every id if they are not NULL*/
+d3_word *_d3plot_merge_element_ids(d3plot_file *plot_file, size_t *num_ids,
+                                   uint8_t *element_types,
+                                   size_t *element_indices);
+/* Compares the indices at the start of two entries for qsort*/
+int _d3plot_compare_indices(const void *lhs, const void *rhs);
+/* Insert entry as the most recently used entry into the state cache and evict
+ * the least recently used entries until it fits into the budget*/
+void _d3plot_cache_insert(d3plot_file *plot_file, d3plot_cached_state *entry);
+/* Remove entry from the state cache and give back the reference of the
+ * cache*/
+void _d3plot_cache_evict(d3plot_file *plot_file, d3plot_cached_state *entry);
+/* Remove entry from the state cache without giving back any reference*/
+void _d3plot_cache_unlink(d3plot_file *plot_file, d3plot_cached_state *entry);
+/* Read the GLOBAL blocks of the states from first_state until end_state into
+ * dst, which needs to be able to hold (end_state - first_state) * nglbv
+ * values. Blocks of consecutive states that lie close to each other are read
+ * at once*/
+void _d3plot_read_globals(d3plot_file *plot_file, size_t first_state,
+                          size_t end_state, double *dst);
+/* Returns the scratch memory of plot_file with at least size bytes. The memory
+ * is only valid until the next call*/
+void *_d3plot_scratch(d3plot_file *plot_file, size_t size);
+/* Read num_words words at word_pos into dst and widen them if the file uses
+ * single precision. dst needs to be able to hold num_words values*/
+void _d3plot_read_f64(d3plot_file *plot_file, double *dst, size_t num_words,
+                      size_t word_pos);
+void _d3plot_read_u64(d3plot_file *plot_file, d3_word *dst, size_t num_words,
+                      size_t word_pos);
+/* Fill value_map (see _d3plot_read_element_data) for the state of an element
+ * type. Returns the number of values of the element struct*/
+size_t _d3plot_solid_value_map(d3plot_file *plot_file, size_t *value_map);
+size_t _d3plot_thick_shell_value_map(d3plot_file *plot_file,
+                                     size_t *value_map);
+size_t _d3plot_beam_value_map(d3plot_file *plot_file, size_t *value_map);
+size_t _d3plot_shell_value_map(d3plot_file *plot_file, size_t *value_map);
+/* Remove all values from value_map whose field (value_fields) is not inside
+ * fields. Returns the new number of values*/
+size_t _d3plot_select_fields(size_t *value_map, size_t num_values,
+                             const unsigned int *value_fields,
+                             unsigned int fields);
+/* Read the values selected by fields of an element state*/
+double *_d3plot_read_element_data_fields(
+    d3plot_file *plot_file, size_t state, size_t num_elements,
+    size_t num_words, size_t data_type, size_t *value_map, size_t num_values,
+    const unsigned int *value_fields, unsigned int fields,
+    size_t *num_selected_values);
+/* Combine consecutive values of value_map into runs of (dst, src, length).
+ * runs needs to be able to hold 3 * num_values values. Returns the number of
+ * runs*/
+size_t _d3plot_value_map_runs(const size_t *value_map, size_t num_values,
+                              size_t *runs);
+/* Read num_elements elements with num_words words each from the state data
+ * located at data_type and convert them into elements of num_values doubles.
+ * value_map holds the index of the word of every value inside an element or
+ * D3PLT_NO_VALUE if the value should be zero*/
+double *_d3plot_read_element_data(d3plot_file *plot_file, size_t state,
+                                  size_t num_elements, size_t num_words,
+                                  size_t data_type, const size_t *value_map,
+                                  size_t num_values);
+/* Same as _d3plot_read_element_data, but writes into values which needs to be
+ * able to hold num_elements * num_values values. Returns 0 on failure*/
+int _d3plot_read_element_data_into(d3plot_file *plot_file, size_t state,
+                                   size_t num_elements, size_t num_words,
+                                   size_t data_type, const size_t *value_map,
+                                   size_t num_values, double *values);
+/* Same as _d3plot_read_element_data, but writes every value into its own
+ * array of components. Returns 0 on failure*/
+int _d3plot_read_element_data_soa(d3plot_file *plot_file, size_t state,
+                                  size_t num_elements, size_t num_words,
+                                  size_t data_type, const size_t *value_map,
+                                  size_t num_values, double **components);
+/* Same as _d3plot_read_element_data, but returns single precision values*/
+float *_d3plot_read_element_data_f32(d3plot_file *plot_file, size_t state,
+                                     size_t num_elements, size_t num_words,
+                                     size_t data_type, const size_t *value_map,
+                                     size_t num_values);
 /* A nice function to read node and element ids*/
 d3_word *_d3plot_read_ids(d3plot_file *plot_file, size_t *num_ids,
                           size_t data_type, size_t num_ids_value);
-/* Insert a sorted (ascending) array (src) into a sorted array (dst)*/
-d3_word *_insert_sorted(d3_word *dst, size_t dst_size, const d3_word *src,
-                        size_t src_size);
+/* Read only the ids at indices of the num_ids ids located at data_type*/
+d3_word *_d3plot_read_id_subset(d3plot_file *plot_file, size_t data_type,
+                                size_t num_ids, const size_t *indices,
+                                size_t num_indices);
+/* Returns the state before time and stores the interpolation factor between
+ * this and the next state in alpha. alpha is 0 if no interpolation is needed*/
+size_t _d3plot_find_states_at_time(d3plot_file *plot_file, double time,
+                                   double *alpha);
+/* lhs = lhs + alpha * (rhs - lhs)*/
+void _d3plot_interpolate(double *lhs, const double *rhs, double alpha,
+                         size_t num_values);
+/* Load the layout from an index file. Returns 0 if the index file does not
+ * exist or does not fit the opened files*/
+int _d3plot_read_index(d3plot_file *plot_file, const char *index_file_name);
+/* Load a zone map that has been written by d3plot_write_zone_map. Returns 0
+ * if the file does not exist or does not fit the opened files*/
+int _d3plot_read_zone_map(d3plot_file *plot_file,
+                          const char *zone_map_file_name,
+                          d3plot_zone_map *zone_map);
+/* Write the number of files of the family and the size and modification time
+ * of every file. Returns 0 on failure*/
+int _d3plot_write_file_stamps(d3plot_file *plot_file, FILE *file);
+/* Read the values written by _d3plot_write_file_stamps. Returns 0 if they
+ * could not be read or if any file has been changed since*/
+int _d3plot_read_file_stamps(d3plot_file *plot_file, FILE *file);
+/* Returns the modification time of a file or -1 on failure*/
+int64_t _d3plot_get_file_mtime(FILE *file);
 /* Deallocates all memory of a d3plot_part*/
 void d3plot_free_part(d3plot_part *part);
+/* Deallocates all memory of a d3plot_part_state*/
+void d3plot_free_part_state(d3plot_part_state *part_state);
+/* Deallocates all memory of a d3plot_envelope*/
+void d3plot_free_envelope(d3plot_envelope *envelope);
+/* Deallocates all memory of a d3plot_zone_map*/
+void d3plot_free_zone_map(d3plot_zone_map *zone_map);
 /********************************/
 
 #ifdef __cplusplus
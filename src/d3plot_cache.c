@@ -0,0 +1,186 @@
+/***********************************************************************************
+ *                         This file is part of dynareadout
+ *                    https://github.com/PucklaMotzer09/dynareadout
+ ***********************************************************************************
+ * Copyright (c) 2022 PucklaMotzer09
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ * that you wrote the original software. If you use this software in a product,
+ * an acknowledgment in the product documentation would be appreciated but is
+ * not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ ************************************************************************************/
+
+#include "d3plot.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+void d3plot_set_cache_size(d3plot_file *plot_file, size_t max_cache_size) {
+  plot_file->max_cache_size = max_cache_size;
+
+  /* A budget of 0 also evicts the entries without any data*/
+  while (plot_file->cache_last &&
+         (plot_file->max_cache_size == 0 ||
+          plot_file->cache_size > plot_file->max_cache_size)) {
+    _d3plot_cache_evict(plot_file, plot_file->cache_last);
+  }
+}
+
+d3plot_cached_state *d3plot_cache_get(d3plot_file *plot_file, size_t state,
+                                      int field) {
+  /* The cache only holds a few entries, so a linear search is enough*/
+  d3plot_cached_state *entry = plot_file->cache_first;
+  while (entry) {
+    if (entry->state == state && entry->field == field) {
+      if (entry != plot_file->cache_first) {
+        /* Move the entry to the front, since it is now the most recently
+         * used one*/
+        _d3plot_cache_unlink(plot_file, entry);
+        _d3plot_cache_insert(plot_file, entry);
+      }
+
+      entry->ref_count++;
+      return entry;
+    }
+
+    entry = entry->next;
+  }
+
+  /* The readers set a new error_string if they fail*/
+  const char *previous_error = plot_file->error_string;
+  entry = malloc(sizeof(d3plot_cached_state));
+  entry->state = state;
+  entry->field = field;
+  entry->ref_count = 1;
+  entry->prev = NULL;
+  entry->next = NULL;
+
+  switch (field) {
+  case D3PLT_CACHE_NODE_COORDINATES:
+    entry->data =
+        d3plot_read_node_coordinates(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * 3 * sizeof(double);
+    break;
+  case D3PLT_CACHE_NODE_VELOCITY:
+    entry->data = d3plot_read_node_velocity(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * 3 * sizeof(double);
+    break;
+  case D3PLT_CACHE_NODE_ACCELERATION:
+    entry->data =
+        d3plot_read_node_acceleration(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * 3 * sizeof(double);
+    break;
+  case D3PLT_CACHE_SOLIDS:
+    entry->data = d3plot_read_solids_state(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * sizeof(d3plot_solid);
+    break;
+  case D3PLT_CACHE_THICK_SHELLS:
+    entry->data =
+        d3plot_read_thick_shells_state(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * sizeof(d3plot_thick_shell);
+    break;
+  case D3PLT_CACHE_BEAMS:
+    entry->data = d3plot_read_beams_state(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * sizeof(d3plot_beam);
+    break;
+  case D3PLT_CACHE_SHELLS:
+    entry->data = d3plot_read_shells_state(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * sizeof(d3plot_shell);
+    break;
+  case D3PLT_CACHE_NODE_DISPLACEMENT:
+    entry->data =
+        d3plot_read_node_displacement(plot_file, state, &entry->num_items);
+    entry->size = entry->num_items * 3 * sizeof(double);
+    break;
+  default:
+    free(entry);
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is not a valid cache field", field);
+    return NULL;
+  }
+
+  /* The readers of fields without any items do not check the state*/
+  if (!entry->data && plot_file->error_string == previous_error &&
+      state >= plot_file->num_states) {
+    plot_file->error_string = malloc(70);
+    sprintf(plot_file->error_string, "%d is out of bounds for the states",
+            (int)state);
+  }
+  /* A failed read is reported and not cached, so that it is tried again by
+   * the next call*/
+  if (!entry->data && plot_file->error_string != previous_error) {
+    free(entry);
+    return NULL;
+  }
+
+  /* Entries that do not fit into the budget are returned without caching
+   * them*/
+  if (plot_file->max_cache_size != 0 &&
+      entry->size <= plot_file->max_cache_size) {
+    entry->ref_count++;
+    _d3plot_cache_insert(plot_file, entry);
+  }
+
+  return entry;
+}
+
+void d3plot_cache_retain(d3plot_cached_state *entry) { entry->ref_count++; }
+
+void d3plot_cache_release(d3plot_cached_state *entry) {
+  entry->ref_count--;
+  if (entry->ref_count == 0) {
+    free(entry->data);
+    free(entry);
+  }
+}
+
+void _d3plot_cache_insert(d3plot_file *plot_file, d3plot_cached_state *entry) {
+  /* Make room for the entry*/
+  while (plot_file->cache_last &&
+         plot_file->cache_size + entry->size > plot_file->max_cache_size) {
+    _d3plot_cache_evict(plot_file, plot_file->cache_last);
+  }
+
+  entry->prev = NULL;
+  entry->next = plot_file->cache_first;
+  if (plot_file->cache_first) {
+    plot_file->cache_first->prev = entry;
+  } else {
+    plot_file->cache_last = entry;
+  }
+  plot_file->cache_first = entry;
+  plot_file->cache_size += entry->size;
+}
+
+void _d3plot_cache_evict(d3plot_file *plot_file, d3plot_cached_state *entry) {
+  _d3plot_cache_unlink(plot_file, entry);
+  d3plot_cache_release(entry);
+}
+
+void _d3plot_cache_unlink(d3plot_file *plot_file, d3plot_cached_state *entry) {
+  if (entry->prev) {
+    entry->prev->next = entry->next;
+  } else {
+    plot_file->cache_first = entry->next;
+  }
+  if (entry->next) {
+    entry->next->prev = entry->prev;
+  } else {
+    plot_file->cache_last = entry->prev;
+  }
+  entry->prev = NULL;
+  entry->next = NULL;
+  plot_file->cache_size -= entry->size;
+}
@@ -0,0 +1,421 @@
+/***********************************************************************************
+ *                         This file is part of dynareadout
+ *                    https://github.com/PucklaMotzer09/dynareadout
+ ***********************************************************************************
+ * Copyright (c) 2022 PucklaMotzer09
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ * that you wrote the original software. If you use this software in a product,
+ * an acknowledgment in the product documentation would be appreciated but is
+ * not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ ************************************************************************************/
+
+#ifndef _WIN32
+/* Needed for pthread*/
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "d3plot.h"
+#include "d3_kernels.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/* The von Mises stress and effective plastic strain quantities of solids,
+ * thick shells and shells*/
+static const int _d3plot_envelope_element_types[3] = {
+    D3PLT_ELEMENT_SOLID, D3PLT_ELEMENT_THICK_SHELL, D3PLT_ELEMENT_SHELL};
+static const int _d3plot_envelope_von_mises[3] = {
+    D3PLT_ENVELOPE_SOLID_VON_MISES, D3PLT_ENVELOPE_THICK_SHELL_VON_MISES,
+    D3PLT_ENVELOPE_SHELL_VON_MISES};
+static const int _d3plot_envelope_plastic_strain[3] = {
+    D3PLT_ENVELOPE_SOLID_PLASTIC_STRAIN,
+    D3PLT_ENVELOPE_THICK_SHELL_PLASTIC_STRAIN,
+    D3PLT_ENVELOPE_SHELL_PLASTIC_STRAIN};
+
+/* A range of states that is reduced by its own thread*/
+typedef struct {
+  d3plot_file reader;
+  int surface;
+  size_t first_state, end_state;
+  d3plot_envelope envelopes[D3PLT_ENVELOPE_QUANTITY_COUNT];
+  /* 0 if the files could not be opened again*/
+  int has_reader;
+  void *thread;
+  int result;
+} d3plot_envelope_worker;
+
+#ifdef _WIN32
+static DWORD WINAPI _d3plot_envelope_thread(LPVOID arg) {
+#else
+static void *_d3plot_envelope_thread(void *arg) {
+#endif
+  d3plot_envelope_worker *worker = (d3plot_envelope_worker *)arg;
+  worker->result = _d3plot_reduce_envelopes(
+      &worker->reader, worker->surface, worker->first_state, worker->end_state,
+      worker->envelopes);
+  return 0;
+}
+
+/* Allocate the selected envelopes of quantities, so that every value of the
+ * first state replaces them*/
+static void _d3plot_alloc_envelopes(d3plot_file *plot_file,
+                                    unsigned int quantities, int surface,
+                                    d3plot_envelope *envelopes) {
+  int q = 0;
+  while (q < D3PLT_ENVELOPE_QUANTITY_COUNT) {
+    envelopes[q].max = NULL;
+    envelopes[q].min = NULL;
+    envelopes[q].max_state = NULL;
+    envelopes[q].min_state = NULL;
+    envelopes[q].num_items = 0;
+    q++;
+  }
+
+  if (quantities & (1 << D3PLT_ENVELOPE_NODE_DISPLACEMENT)) {
+    envelopes[D3PLT_ENVELOPE_NODE_DISPLACEMENT].num_items =
+        plot_file->control_data.numnp;
+  }
+  int t = 0;
+  while (t < 3) {
+    size_t num_words, data_type, stress_word, plastic_strain_word;
+    const size_t num_elements = _d3plot_surface_words(
+        plot_file, _d3plot_envelope_element_types[t], surface, &num_words,
+        &data_type, &stress_word, &plastic_strain_word);
+    if (quantities & (1 << _d3plot_envelope_von_mises[t])) {
+      envelopes[_d3plot_envelope_von_mises[t]].num_items = num_elements;
+    }
+    if (quantities & (1 << _d3plot_envelope_plastic_strain[t])) {
+      envelopes[_d3plot_envelope_plastic_strain[t]].num_items = num_elements;
+    }
+    t++;
+  }
+
+  q = 0;
+  while (q < D3PLT_ENVELOPE_QUANTITY_COUNT) {
+    d3plot_envelope *envelope = &envelopes[q];
+    if (envelope->num_items != 0) {
+      envelope->max = malloc(envelope->num_items * sizeof(double));
+      envelope->min = malloc(envelope->num_items * sizeof(double));
+      envelope->max_state = malloc(envelope->num_items * sizeof(size_t));
+      envelope->min_state = malloc(envelope->num_items * sizeof(size_t));
+
+      size_t i = 0;
+      while (i < envelope->num_items) {
+        envelope->max[i] = -HUGE_VAL;
+        envelope->min[i] = HUGE_VAL;
+        envelope->max_state[i] = 0;
+        envelope->min_state[i] = 0;
+        i++;
+      }
+    }
+    q++;
+  }
+}
+
+int d3plot_read_envelopes(d3plot_file *plot_file, unsigned int quantities,
+                          int surface, size_t num_threads,
+                          d3plot_envelope *envelopes) {
+  if (surface < D3PLT_SURFACE_MID || surface > D3PLT_SURFACE_OUTER) {
+    _d3plot_alloc_envelopes(plot_file, 0, D3PLT_SURFACE_MID, envelopes);
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is not a valid surface", surface);
+    return 0;
+  }
+
+  /* Check that the files hold the words of all selected quantities before
+   * reading anything*/
+  int t = 0;
+  while (t < 3) {
+    size_t num_words, data_type, stress_word, plastic_strain_word;
+    const size_t num_elements = _d3plot_surface_words(
+        plot_file, _d3plot_envelope_element_types[t], surface, &num_words,
+        &data_type, &stress_word, &plastic_strain_word);
+    if (num_elements != 0 &&
+        (((quantities & (1 << _d3plot_envelope_von_mises[t])) &&
+          stress_word == D3PLT_NO_VALUE) ||
+         ((quantities & (1 << _d3plot_envelope_plastic_strain[t])) &&
+          plastic_strain_word == D3PLT_NO_VALUE))) {
+      _d3plot_alloc_envelopes(plot_file, 0, D3PLT_SURFACE_MID, envelopes);
+      plot_file->error_string = malloc(60);
+      sprintf(plot_file->error_string,
+              "The files do not hold the values of quantity %d",
+              (quantities & (1 << _d3plot_envelope_von_mises[t]))
+                  ? _d3plot_envelope_von_mises[t]
+                  : _d3plot_envelope_plastic_strain[t]);
+      return 0;
+    }
+    t++;
+  }
+
+  _d3plot_alloc_envelopes(plot_file, quantities, surface, envelopes);
+
+  const size_t num_states = plot_file->num_states;
+  if (num_states == 0) {
+    return 1;
+  }
+  if (num_threads == 0) {
+    num_threads = 1;
+  }
+  if (num_threads > num_states) {
+    num_threads = num_states;
+  }
+
+  /* The readers share the initial coordinates of plot_file*/
+  if (quantities & (1 << D3PLT_ENVELOPE_NODE_DISPLACEMENT)) {
+    _d3plot_initial_coordinates(plot_file);
+  }
+  /* The instruction set of the kernels is detected on their first call. Do
+   * it here, so that the workers do not detect it at the same time*/
+  d3_kernels_get_isa();
+
+  /* Every worker reduces a range of consecutive states into its own
+   * envelopes with its own file handles. The first range is reduced by the
+   * calling thread directly into envelopes*/
+  const size_t num_workers = num_threads - 1;
+  d3plot_envelope_worker *workers =
+      malloc(num_workers * sizeof(d3plot_envelope_worker));
+  size_t w = 0;
+  while (w < num_workers) {
+    d3plot_envelope_worker *worker = &workers[w];
+    worker->surface = surface;
+    worker->first_state = num_states * (w + 1) / num_threads;
+    worker->end_state = num_states * (w + 2) / num_threads;
+    worker->thread = NULL;
+    worker->result = 1;
+    _d3plot_alloc_envelopes(plot_file, quantities, surface,
+                            worker->envelopes);
+    _d3plot_open_reader(plot_file, &worker->reader);
+    worker->has_reader = worker->reader.buffer.error_string == NULL;
+    if (!worker->has_reader) {
+      /* The range is reduced by the calling thread on plot_file later on*/
+      free(worker->reader.buffer.error_string);
+      worker->reader.buffer.error_string = NULL;
+      _d3plot_close_reader(&worker->reader);
+      w++;
+      continue;
+    }
+
+#ifdef _WIN32
+    HANDLE *thread = malloc(sizeof(HANDLE));
+    *thread =
+        CreateThread(NULL, 0, _d3plot_envelope_thread, worker, 0, NULL);
+    if (*thread) {
+      worker->thread = thread;
+    } else {
+      free(thread);
+    }
+#else
+    pthread_t *thread = malloc(sizeof(pthread_t));
+    if (pthread_create(thread, NULL, _d3plot_envelope_thread, worker) == 0) {
+      worker->thread = thread;
+    } else {
+      free(thread);
+    }
+#endif
+    w++;
+  }
+
+  int result = _d3plot_reduce_envelopes(plot_file, surface, 0,
+                                        num_states / num_threads, envelopes);
+
+  w = 0;
+  while (w < num_workers) {
+    d3plot_envelope_worker *worker = &workers[w];
+    if (worker->thread) {
+#ifdef _WIN32
+      HANDLE *thread = (HANDLE *)worker->thread;
+      WaitForSingleObject(*thread, INFINITE);
+      CloseHandle(*thread);
+#else
+      pthread_t *thread = (pthread_t *)worker->thread;
+      pthread_join(*thread, NULL);
+#endif
+      free(thread);
+    } else if (result) {
+      /* No thread could be created or the files could not be opened again,
+       * so that the range is reduced by the calling thread*/
+      worker->result = _d3plot_reduce_envelopes(
+          worker->has_reader ? &worker->reader : plot_file, surface,
+          worker->first_state, worker->end_state, worker->envelopes);
+    }
+
+    if (!worker->result) {
+      /* Keep the first error. Errors of plot_file are already set*/
+      if (result && worker->has_reader) {
+        plot_file->error_string = worker->reader.error_string;
+        worker->reader.error_string = NULL;
+      }
+      result = 0;
+    }
+
+    /* Merge in order of the ranges, so that the first state of a maximum or
+     * minimum is kept*/
+    int q = 0;
+    while (q < D3PLT_ENVELOPE_QUANTITY_COUNT) {
+      if (result) {
+        _d3plot_merge_envelope(&envelopes[q], &worker->envelopes[q]);
+      }
+      d3plot_free_envelope(&worker->envelopes[q]);
+      q++;
+    }
+    if (worker->has_reader) {
+      _d3plot_close_reader(&worker->reader);
+    }
+    w++;
+  }
+  free(workers);
+
+  if (!result) {
+    int q = 0;
+    while (q < D3PLT_ENVELOPE_QUANTITY_COUNT) {
+      d3plot_free_envelope(&envelopes[q]);
+      q++;
+    }
+  }
+
+  return result;
+}
+
+void d3plot_free_envelope(d3plot_envelope *envelope) {
+  free(envelope->max);
+  free(envelope->min);
+  free(envelope->max_state);
+  free(envelope->min_state);
+  envelope->max = NULL;
+  envelope->min = NULL;
+  envelope->max_state = NULL;
+  envelope->min_state = NULL;
+  envelope->num_items = 0;
+}
+
+int _d3plot_reduce_envelopes(d3plot_file *plot_file, int surface,
+                             size_t first_state, size_t end_state,
+                             d3plot_envelope *envelopes) {
+  d3plot_envelope *displacement =
+      &envelopes[D3PLT_ENVELOPE_NODE_DISPLACEMENT];
+  size_t num_values = D3PLT_ELEMENT_BLOCK_SIZE;
+  if (displacement->num_items > num_values) {
+    num_values = displacement->num_items;
+  }
+  double *values = malloc(num_values * sizeof(double));
+
+  size_t state = first_state;
+  while (state < end_state) {
+    if (displacement->num_items != 0) {
+      if (!d3plot_read_node_displacement_into(plot_file, state, NULL,
+                                              values)) {
+        free(values);
+        return 0;
+      }
+      d3_kernel_envelope(displacement->max, displacement->min,
+                         displacement->max_state, displacement->min_state,
+                         values, state, displacement->num_items);
+    }
+
+    /* Both quantities of an element type are taken out of one read of its
+     * words, which is done block by block*/
+    int t = 0;
+    while (t < 3) {
+      d3plot_envelope *von_mises = &envelopes[_d3plot_envelope_von_mises[t]];
+      d3plot_envelope *plastic_strain =
+          &envelopes[_d3plot_envelope_plastic_strain[t]];
+      if (von_mises->num_items == 0 && plastic_strain->num_items == 0) {
+        t++;
+        continue;
+      }
+
+      size_t num_words, data_type, stress_word, plastic_strain_word;
+      const size_t num_elements = _d3plot_surface_words(
+          plot_file, _d3plot_envelope_element_types[t], surface, &num_words,
+          &data_type, &stress_word, &plastic_strain_word);
+      const size_t word_pos =
+          plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+          plot_file->data_pointers[data_type];
+      void *data =
+          _d3plot_scratch(plot_file, D3PLT_ELEMENT_BLOCK_SIZE * num_words *
+                                         plot_file->buffer.word_size);
+
+      size_t i = 0;
+      while (i < num_elements) {
+        const size_t block_size = num_elements - i < D3PLT_ELEMENT_BLOCK_SIZE
+                                      ? num_elements - i
+                                      : D3PLT_ELEMENT_BLOCK_SIZE;
+        d3_buffer_read_words_at(&plot_file->buffer, data,
+                                block_size * num_words,
+                                word_pos + i * num_words);
+
+        if (von_mises->num_items != 0) {
+          if (plot_file->buffer.word_size == 4) {
+            d3_kernel_von_mises_f32(values, (const float *)data + stress_word,
+                                    num_words, block_size);
+          } else {
+            d3_kernel_von_mises_f64(values, (const double *)data + stress_word,
+                                    num_words, block_size);
+          }
+          d3_kernel_envelope(&von_mises->max[i], &von_mises->min[i],
+                             &von_mises->max_state[i],
+                             &von_mises->min_state[i], values, state,
+                             block_size);
+        }
+        if (plastic_strain->num_items != 0) {
+          if (plot_file->buffer.word_size == 4) {
+            d3_kernel_widen_f32_gather(values,
+                                       (const float *)data +
+                                           plastic_strain_word,
+                                       num_words, block_size);
+          } else {
+            d3_kernel_copy_f64_gather(values,
+                                      (const double *)data +
+                                          plastic_strain_word,
+                                      num_words, block_size);
+          }
+          d3_kernel_envelope(&plastic_strain->max[i], &plastic_strain->min[i],
+                             &plastic_strain->max_state[i],
+                             &plastic_strain->min_state[i], values, state,
+                             block_size);
+        }
+
+        i += block_size;
+      }
+      t++;
+    }
+
+    state++;
+  }
+
+  free(values);
+  return 1;
+}
+
+void _d3plot_merge_envelope(d3plot_envelope *dst, const d3plot_envelope *src) {
+  size_t i = 0;
+  while (i < dst->num_items) {
+    if (src->max[i] > dst->max[i]) {
+      dst->max[i] = src->max[i];
+      dst->max_state[i] = src->max_state[i];
+    }
+    if (src->min[i] < dst->min[i]) {
+      dst->min[i] = src->min[i];
+      dst->min_state[i] = src->min_state[i];
+    }
+    i++;
+  }
+}
@@ -0,0 +1,395 @@
+/***********************************************************************************
+ *                         This file is part of dynareadout
+ *                    https://github.com/PucklaMotzer09/dynareadout
+ ***********************************************************************************
+ * Copyright (c) 2022 PucklaMotzer09
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ * that you wrote the original software. If you use this software in a product,
+ * an acknowledgment in the product documentation would be appreciated but is
+ * not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ ************************************************************************************/
+
+#ifndef _WIN32
+/* Needed for fileno*/
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "d3plot.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#define fstat _fstat
+#define fileno _fileno
+#define stat _stat
+#endif
+
+/* The index file starts with this magic followed by the sizes of the
+ * serialized types. If any of them differ the index is considered invalid*/
+#define D3PLOT_INDEX_MAGIC "D3PLTIDX"
+#define D3PLOT_INDEX_MAGIC_SIZE 8
+#define D3PLOT_INDEX_VERSION 1
+
+/* Zone map files use the same checks as index files*/
+#define D3PLOT_ZONE_MAP_MAGIC "D3PLTZMP"
+#define D3PLOT_ZONE_MAP_VERSION 1
+
+/**** Layout of the index file ****
+ * magic, version, sizeof(size_t), sizeof(control_data), D3PLT_PTR_COUNT,
+ * word_size, num_files, (file_size, file_mtime) * num_files,
+ * control_data, state_size, num_states,
+ * data_pointers (D3PLT_PTR_COUNT + num_states), state_times (num_states)
+ **********************************/
+
+/**** Layout of the zone map file ****
+ * magic, version, num_files, (file_size, file_mtime) * num_files,
+ * quantities, surface, num_states, num_parts,
+ * min (num_states * num_parts * D3PLT_ZONE_QUANTITY_COUNT), max (same)
+ *************************************/
+
+#define WRITE_INDEX_VALUE(value)                                               \
+  if (fwrite(&value, sizeof(value), 1, file) != 1) {                           \
+    success = 0;                                                               \
+  }
+#define READ_INDEX_VALUE(value)                                                \
+  if (fread(&value, sizeof(value), 1, file) != 1) {                            \
+    fclose(file);                                                              \
+    return 0;                                                                  \
+  }
+
+int d3plot_write_index(d3plot_file *plot_file, const char *index_file_name) {
+  FILE *file = fopen(index_file_name, "wb");
+  if (!file) {
+    const char *error_string = strerror(errno);
+    plot_file->error_string =
+        malloc(strlen(index_file_name) + 2 + strlen(error_string) + 1);
+    sprintf(plot_file->error_string, "%s: %s", index_file_name, error_string);
+    return 0;
+  }
+
+  int success = 1;
+  const uint64_t version = D3PLOT_INDEX_VERSION;
+  const uint64_t size_t_size = sizeof(size_t);
+  const uint64_t control_data_size = sizeof(plot_file->control_data);
+  const uint64_t data_pointer_count = D3PLT_PTR_COUNT;
+  const uint64_t word_size = plot_file->buffer.word_size;
+
+  if (fwrite(D3PLOT_INDEX_MAGIC, 1, D3PLOT_INDEX_MAGIC_SIZE, file) !=
+      D3PLOT_INDEX_MAGIC_SIZE) {
+    success = 0;
+  }
+  WRITE_INDEX_VALUE(version);
+  WRITE_INDEX_VALUE(size_t_size);
+  WRITE_INDEX_VALUE(control_data_size);
+  WRITE_INDEX_VALUE(data_pointer_count);
+  WRITE_INDEX_VALUE(word_size);
+  if (!_d3plot_write_file_stamps(plot_file, file)) {
+    success = 0;
+  }
+
+  WRITE_INDEX_VALUE(plot_file->control_data);
+  WRITE_INDEX_VALUE(plot_file->state_size);
+  WRITE_INDEX_VALUE(plot_file->num_states);
+
+  if (fwrite(plot_file->data_pointers, sizeof(size_t),
+             D3PLT_PTR_COUNT + plot_file->num_states,
+             file) != D3PLT_PTR_COUNT + plot_file->num_states) {
+    success = 0;
+  }
+  if (plot_file->num_states > 0 &&
+      fwrite(plot_file->state_times, sizeof(double), plot_file->num_states,
+             file) != plot_file->num_states) {
+    success = 0;
+  }
+
+  if (fclose(file) != 0) {
+    success = 0;
+  }
+
+  if (!success) {
+    plot_file->error_string = malloc(strlen(index_file_name) + 22 + 1);
+    sprintf(plot_file->error_string, "Failed to write index %s",
+            index_file_name);
+    return 0;
+  }
+
+  return 1;
+}
+
+d3plot_file d3plot_open_indexed(const char *root_file_name,
+                                const char *index_file_name) {
+  d3plot_file plot_file;
+  _d3plot_init_file(&plot_file);
+
+  plot_file.buffer = d3_buffer_open(root_file_name);
+  if (plot_file.buffer.error_string) {
+    /* Swaperoo*/
+    plot_file.error_string = plot_file.buffer.error_string;
+    plot_file.buffer.error_string = NULL;
+    return plot_file;
+  }
+
+  if (_d3plot_read_index(&plot_file, index_file_name)) {
+    return plot_file;
+  }
+
+  /* The index does not exist or is outdated. So we need to parse everything
+   * and write a new index*/
+  d3plot_close(&plot_file);
+  plot_file = d3plot_open(root_file_name);
+  if (plot_file.error_string) {
+    return plot_file;
+  }
+
+  if (!d3plot_write_index(&plot_file, index_file_name)) {
+    /* The index is only an optimisation. Failing to write it should not fail
+     * the whole opening*/
+    free(plot_file.error_string);
+    plot_file.error_string = NULL;
+  }
+
+  return plot_file;
+}
+
+int _d3plot_read_index(d3plot_file *plot_file, const char *index_file_name) {
+  FILE *file = fopen(index_file_name, "rb");
+  if (!file) {
+    return 0;
+  }
+
+  char magic[D3PLOT_INDEX_MAGIC_SIZE];
+  uint64_t version, size_t_size, control_data_size, data_pointer_count,
+      word_size;
+
+  if (fread(magic, 1, D3PLOT_INDEX_MAGIC_SIZE, file) !=
+          D3PLOT_INDEX_MAGIC_SIZE ||
+      memcmp(magic, D3PLOT_INDEX_MAGIC, D3PLOT_INDEX_MAGIC_SIZE) != 0) {
+    fclose(file);
+    return 0;
+  }
+  READ_INDEX_VALUE(version);
+  READ_INDEX_VALUE(size_t_size);
+  READ_INDEX_VALUE(control_data_size);
+  READ_INDEX_VALUE(data_pointer_count);
+  READ_INDEX_VALUE(word_size);
+
+  /* Only use the index if none of the files has been changed since it has been
+   * written*/
+  if (version != D3PLOT_INDEX_VERSION || size_t_size != sizeof(size_t) ||
+      control_data_size != sizeof(plot_file->control_data) ||
+      data_pointer_count != D3PLT_PTR_COUNT ||
+      word_size != plot_file->buffer.word_size ||
+      !_d3plot_read_file_stamps(plot_file, file)) {
+    fclose(file);
+    return 0;
+  }
+
+  READ_INDEX_VALUE(plot_file->control_data);
+  READ_INDEX_VALUE(plot_file->state_size);
+  READ_INDEX_VALUE(plot_file->num_states);
+
+  plot_file->data_pointers =
+      malloc((D3PLT_PTR_COUNT + plot_file->num_states) * sizeof(size_t));
+  plot_file->state_times = malloc(plot_file->num_states * sizeof(double));
+
+  if (fread(plot_file->data_pointers, sizeof(size_t),
+            D3PLT_PTR_COUNT + plot_file->num_states,
+            file) != D3PLT_PTR_COUNT + plot_file->num_states ||
+      (plot_file->num_states > 0 &&
+       fread(plot_file->state_times, sizeof(double), plot_file->num_states,
+             file) != plot_file->num_states)) {
+    fclose(file);
+    free(plot_file->data_pointers);
+    free(plot_file->state_times);
+    plot_file->data_pointers = NULL;
+    plot_file->state_times = NULL;
+    plot_file->num_states = 0;
+    plot_file->state_size = 0;
+    return 0;
+  }
+
+  fclose(file);
+  return 1;
+}
+
+int64_t _d3plot_get_file_mtime(FILE *file) {
+  struct stat file_stat;
+  if (fstat(fileno(file), &file_stat) != 0) {
+    return -1;
+  }
+
+  return (int64_t)file_stat.st_mtime;
+}
+
+int d3plot_write_zone_map(d3plot_file *plot_file,
+                          const d3plot_zone_map *zone_map,
+                          const char *zone_map_file_name) {
+  FILE *file = fopen(zone_map_file_name, "wb");
+  if (!file) {
+    const char *error_string = strerror(errno);
+    plot_file->error_string =
+        malloc(strlen(zone_map_file_name) + 2 + strlen(error_string) + 1);
+    sprintf(plot_file->error_string, "%s: %s", zone_map_file_name,
+            error_string);
+    return 0;
+  }
+
+  int success = 1;
+  const uint64_t version = D3PLOT_ZONE_MAP_VERSION;
+  const uint64_t quantities = zone_map->quantities;
+  const int64_t surface = zone_map->surface;
+  const uint64_t num_states = zone_map->num_states;
+  const uint64_t num_parts = zone_map->num_parts;
+  const size_t num_values =
+      zone_map->num_states * zone_map->num_parts * D3PLT_ZONE_QUANTITY_COUNT;
+
+  if (fwrite(D3PLOT_ZONE_MAP_MAGIC, 1, D3PLOT_INDEX_MAGIC_SIZE, file) !=
+      D3PLOT_INDEX_MAGIC_SIZE) {
+    success = 0;
+  }
+  WRITE_INDEX_VALUE(version);
+  if (!_d3plot_write_file_stamps(plot_file, file)) {
+    success = 0;
+  }
+  WRITE_INDEX_VALUE(quantities);
+  WRITE_INDEX_VALUE(surface);
+  WRITE_INDEX_VALUE(num_states);
+  WRITE_INDEX_VALUE(num_parts);
+
+  if (num_values > 0 &&
+      (fwrite(zone_map->min, sizeof(double), num_values, file) != num_values ||
+       fwrite(zone_map->max, sizeof(double), num_values, file) !=
+           num_values)) {
+    success = 0;
+  }
+
+  if (fclose(file) != 0) {
+    success = 0;
+  }
+
+  if (!success) {
+    plot_file->error_string = malloc(strlen(zone_map_file_name) + 25 + 1);
+    sprintf(plot_file->error_string, "Failed to write zone map %s",
+            zone_map_file_name);
+    return 0;
+  }
+
+  return 1;
+}
+
+int _d3plot_read_zone_map(d3plot_file *plot_file,
+                          const char *zone_map_file_name,
+                          d3plot_zone_map *zone_map) {
+  FILE *file = fopen(zone_map_file_name, "rb");
+  if (!file) {
+    return 0;
+  }
+
+  char magic[D3PLOT_INDEX_MAGIC_SIZE];
+  uint64_t version, quantities, num_states, num_parts;
+  int64_t surface;
+
+  if (fread(magic, 1, D3PLOT_INDEX_MAGIC_SIZE, file) !=
+          D3PLOT_INDEX_MAGIC_SIZE ||
+      memcmp(magic, D3PLOT_ZONE_MAP_MAGIC, D3PLOT_INDEX_MAGIC_SIZE) != 0) {
+    fclose(file);
+    return 0;
+  }
+  READ_INDEX_VALUE(version);
+  if (version != D3PLOT_ZONE_MAP_VERSION ||
+      !_d3plot_read_file_stamps(plot_file, file)) {
+    fclose(file);
+    return 0;
+  }
+  READ_INDEX_VALUE(quantities);
+  READ_INDEX_VALUE(surface);
+  READ_INDEX_VALUE(num_states);
+  READ_INDEX_VALUE(num_parts);
+
+  /* The sizes of the arrays need to fit the opened files*/
+  if (num_states != plot_file->num_states ||
+      num_parts != plot_file->control_data.nmmat) {
+    fclose(file);
+    return 0;
+  }
+
+  const size_t num_values =
+      plot_file->num_states * num_parts * D3PLT_ZONE_QUANTITY_COUNT;
+  zone_map->min = malloc(num_values * sizeof(double));
+  zone_map->max = malloc(num_values * sizeof(double));
+  zone_map->num_states = plot_file->num_states;
+  zone_map->num_parts = num_parts;
+  zone_map->quantities = (unsigned int)quantities;
+  zone_map->surface = (int)surface;
+
+  if (num_values > 0 &&
+      (fread(zone_map->min, sizeof(double), num_values, file) != num_values ||
+       fread(zone_map->max, sizeof(double), num_values, file) !=
+           num_values)) {
+    fclose(file);
+    d3plot_free_zone_map(zone_map);
+    return 0;
+  }
+
+  fclose(file);
+  return 1;
+}
+
+int _d3plot_write_file_stamps(d3plot_file *plot_file, FILE *file) {
+  int success = 1;
+  const uint64_t num_files = plot_file->buffer.num_file_handles;
+  WRITE_INDEX_VALUE(num_files);
+
+  size_t i = 0;
+  while (i < plot_file->buffer.num_file_handles) {
+    const uint64_t file_size = plot_file->buffer.file_sizes[i];
+    const int64_t file_mtime =
+        _d3plot_get_file_mtime(plot_file->buffer.file_handles[i]);
+    WRITE_INDEX_VALUE(file_size);
+    WRITE_INDEX_VALUE(file_mtime);
+
+    i++;
+  }
+
+  return success;
+}
+
+int _d3plot_read_file_stamps(d3plot_file *plot_file, FILE *file) {
+  uint64_t num_files;
+  if (fread(&num_files, sizeof(num_files), 1, file) != 1 ||
+      num_files != plot_file->buffer.num_file_handles) {
+    return 0;
+  }
+
+  size_t i = 0;
+  while (i < plot_file->buffer.num_file_handles) {
+    uint64_t file_size;
+    int64_t file_mtime;
+    if (fread(&file_size, sizeof(file_size), 1, file) != 1 ||
+        fread(&file_mtime, sizeof(file_mtime), 1, file) != 1 ||
+        file_size != plot_file->buffer.file_sizes[i] ||
+        file_mtime !=
+            _d3plot_get_file_mtime(plot_file->buffer.file_handles[i])) {
+      return 0;
+    }
+
+    i++;
+  }
+
+  return 1;
+}
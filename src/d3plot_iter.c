@@ -0,0 +1,379 @@
+/***********************************************************************************
+ *                         This file is part of dynareadout
+ *                    https://github.com/PucklaMotzer09/dynareadout
+ ***********************************************************************************
+ * Copyright (c) 2022 PucklaMotzer09
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ * that you wrote the original software. If you use this software in a product,
+ * an acknowledgment in the product documentation would be appreciated but is
+ * not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ ************************************************************************************/
+
+#ifndef _WIN32
+/* Needed for pthread*/
+#define _POSIX_C_SOURCE 200112L
+#endif
+#include "d3plot.h"
+#include "d3_kernels.h"
+#include <stdio.h>
+#include <stdlib.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/* Reads every state that is requested by _d3plot_state_iter_prefetch until
+ * iter->quit is set. Runs on the background thread*/
+#ifdef _WIN32
+static DWORD WINAPI _d3plot_state_iter_thread(LPVOID arg) {
+  d3plot_state_iter *iter = (d3plot_state_iter *)arg;
+  while (1) {
+    WaitForSingleObject(iter->request_event, INFINITE);
+    if (iter->quit) {
+      break;
+    }
+
+    iter->read_result =
+        _d3plot_state_iter_read(&iter->reader, iter->next_state,
+                                &iter->buffers[iter->next_state % 2]);
+    SetEvent(iter->done_event);
+  }
+  return 0;
+}
+#else
+static void *_d3plot_state_iter_thread(void *arg) {
+  d3plot_state_iter *iter = (d3plot_state_iter *)arg;
+  pthread_mutex_lock(&iter->mutex);
+  while (1) {
+    while (!iter->busy && !iter->quit) {
+      pthread_cond_wait(&iter->cond, &iter->mutex);
+    }
+    if (iter->quit) {
+      break;
+    }
+    pthread_mutex_unlock(&iter->mutex);
+
+    const int read_result =
+        _d3plot_state_iter_read(&iter->reader, iter->next_state,
+                                &iter->buffers[iter->next_state % 2]);
+
+    pthread_mutex_lock(&iter->mutex);
+    iter->read_result = read_result;
+    iter->busy = 0;
+    pthread_cond_signal(&iter->cond);
+  }
+  pthread_mutex_unlock(&iter->mutex);
+  return NULL;
+}
+#endif
+
+/* Start the background thread. Sets iter->has_thread to 0 on failure*/
+static void _d3plot_state_iter_start(d3plot_state_iter *iter) {
+  iter->busy = 0;
+  iter->quit = 0;
+#ifdef _WIN32
+  iter->request_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+  iter->done_event = CreateEvent(NULL, FALSE, FALSE, NULL);
+  iter->thread = NULL;
+  if (iter->request_event && iter->done_event) {
+    iter->thread =
+        CreateThread(NULL, 0, _d3plot_state_iter_thread, iter, 0, NULL);
+  }
+  iter->has_thread = iter->thread != NULL;
+  if (!iter->has_thread) {
+    if (iter->request_event) {
+      CloseHandle(iter->request_event);
+    }
+    if (iter->done_event) {
+      CloseHandle(iter->done_event);
+    }
+  }
+#else
+  pthread_mutex_init(&iter->mutex, NULL);
+  pthread_cond_init(&iter->cond, NULL);
+  iter->has_thread =
+      pthread_create(&iter->thread, NULL, _d3plot_state_iter_thread, iter) ==
+      0;
+  if (!iter->has_thread) {
+    pthread_cond_destroy(&iter->cond);
+    pthread_mutex_destroy(&iter->mutex);
+  }
+#endif
+}
+
+int d3plot_state_iter_begin(d3plot_file *plot_file, d3plot_state_iter *iter,
+                            unsigned int fields) {
+  iter->plot_file = plot_file;
+  iter->next_state = 0;
+  iter->has_thread = 0;
+  iter->read_result = 1;
+
+  /* The background thread gets its own file handles and scratch memory, so
+   * that it does not interfere with the functions called on plot_file. The
+   * layout of the files (control data, data pointers and state times) is
+   * shared. The initial coordinates are read beforehand, so that the reader
+   * shares them as well*/
+  if (fields & (1 << D3PLT_CACHE_NODE_DISPLACEMENT)) {
+    _d3plot_initial_coordinates(plot_file);
+  }
+  /* The instruction set of the kernels is detected on their first call,
+   * which must not happen in the background thread and in the calling thread
+   * at the same time*/
+  d3_kernels_get_isa();
+  _d3plot_open_reader(plot_file, &iter->reader);
+
+  size_t item_sizes[D3PLT_CACHE_FIELD_COUNT];
+  item_sizes[D3PLT_CACHE_NODE_COORDINATES] = 3 * sizeof(double);
+  item_sizes[D3PLT_CACHE_NODE_VELOCITY] = 3 * sizeof(double);
+  item_sizes[D3PLT_CACHE_NODE_ACCELERATION] = 3 * sizeof(double);
+  item_sizes[D3PLT_CACHE_SOLIDS] = sizeof(d3plot_solid);
+  item_sizes[D3PLT_CACHE_THICK_SHELLS] = sizeof(d3plot_thick_shell);
+  item_sizes[D3PLT_CACHE_BEAMS] = sizeof(d3plot_beam);
+  item_sizes[D3PLT_CACHE_SHELLS] = sizeof(d3plot_shell);
+  item_sizes[D3PLT_CACHE_NODE_DISPLACEMENT] = 3 * sizeof(double);
+
+  size_t num_items[D3PLT_CACHE_FIELD_COUNT];
+  num_items[D3PLT_CACHE_NODE_COORDINATES] = plot_file->control_data.numnp;
+  num_items[D3PLT_CACHE_NODE_VELOCITY] = plot_file->control_data.numnp;
+  num_items[D3PLT_CACHE_NODE_ACCELERATION] = plot_file->control_data.numnp;
+  num_items[D3PLT_CACHE_SOLIDS] = plot_file->control_data.nel8;
+  num_items[D3PLT_CACHE_THICK_SHELLS] = plot_file->control_data.nelt;
+  num_items[D3PLT_CACHE_BEAMS] = plot_file->control_data.nel2;
+  num_items[D3PLT_CACHE_SHELLS] = plot_file->control_data.nel4;
+  num_items[D3PLT_CACHE_NODE_DISPLACEMENT] = plot_file->control_data.numnp;
+
+  /* Allocate both buffers once. They are reused for every state*/
+  int b = 0;
+  while (b < 2) {
+    int field = 0;
+    while (field < D3PLT_CACHE_FIELD_COUNT) {
+      if ((fields & (1 << field)) && num_items[field] != 0) {
+        iter->buffers[b].data[field] =
+            malloc(num_items[field] * item_sizes[field]);
+        iter->buffers[b].num_items[field] = num_items[field];
+      } else {
+        iter->buffers[b].data[field] = NULL;
+        iter->buffers[b].num_items[field] = 0;
+      }
+      field++;
+    }
+    b++;
+  }
+
+  if (iter->reader.buffer.error_string) {
+    plot_file->error_string = iter->reader.buffer.error_string;
+    iter->reader.buffer.error_string = NULL;
+    d3plot_state_iter_end(iter);
+    return 0;
+  }
+
+  if (iter->reader.num_states != 0) {
+    _d3plot_state_iter_start(iter);
+    _d3plot_state_iter_prefetch(iter);
+  }
+
+  return 1;
+}
+
+d3plot_state_data *d3plot_state_iter_next(d3plot_state_iter *iter) {
+  if (iter->next_state >= iter->reader.num_states) {
+    return NULL;
+  }
+
+  _d3plot_state_iter_wait(iter);
+  if (!iter->read_result) {
+    iter->plot_file->error_string = iter->reader.error_string;
+    iter->reader.error_string = NULL;
+    iter->next_state = iter->reader.num_states;
+    return NULL;
+  }
+
+  d3plot_state_data *data = &iter->buffers[iter->next_state % 2];
+
+  /* The other buffer is not used by the caller anymore, so that the next
+   * state can be read into it while the caller processes this one*/
+  iter->next_state++;
+  if (iter->next_state < iter->reader.num_states) {
+    _d3plot_state_iter_prefetch(iter);
+  }
+
+  return data;
+}
+
+void d3plot_state_iter_end(d3plot_state_iter *iter) {
+  _d3plot_state_iter_wait(iter);
+
+  if (iter->has_thread) {
+#ifdef _WIN32
+    iter->quit = 1;
+    SetEvent(iter->request_event);
+    WaitForSingleObject(iter->thread, INFINITE);
+    CloseHandle(iter->thread);
+    CloseHandle(iter->request_event);
+    CloseHandle(iter->done_event);
+#else
+    pthread_mutex_lock(&iter->mutex);
+    iter->quit = 1;
+    pthread_cond_signal(&iter->cond);
+    pthread_mutex_unlock(&iter->mutex);
+    pthread_join(iter->thread, NULL);
+    pthread_cond_destroy(&iter->cond);
+    pthread_mutex_destroy(&iter->mutex);
+#endif
+    iter->has_thread = 0;
+  }
+
+  int b = 0;
+  while (b < 2) {
+    int field = 0;
+    while (field < D3PLT_CACHE_FIELD_COUNT) {
+      free(iter->buffers[b].data[field]);
+      iter->buffers[b].data[field] = NULL;
+      iter->buffers[b].num_items[field] = 0;
+      field++;
+    }
+    b++;
+  }
+
+  _d3plot_close_reader(&iter->reader);
+  iter->next_state = iter->reader.num_states;
+}
+
+int _d3plot_state_iter_read(d3plot_file *plot_file, size_t state,
+                            d3plot_state_data *data) {
+  data->state = state;
+  data->time = plot_file->state_times[state];
+
+  int field = 0;
+  while (field < D3PLT_CACHE_FIELD_COUNT) {
+    if (data->data[field]) {
+      int result;
+      switch (field) {
+      case D3PLT_CACHE_NODE_COORDINATES:
+        result = d3plot_read_node_coordinates_into(plot_file, state,
+                                                   data->data[field]);
+        break;
+      case D3PLT_CACHE_NODE_VELOCITY:
+        result =
+            d3plot_read_node_velocity_into(plot_file, state, data->data[field]);
+        break;
+      case D3PLT_CACHE_NODE_ACCELERATION:
+        result = d3plot_read_node_acceleration_into(plot_file, state,
+                                                    data->data[field]);
+        break;
+      case D3PLT_CACHE_SOLIDS:
+        result =
+            d3plot_read_solids_state_into(plot_file, state, data->data[field]);
+        break;
+      case D3PLT_CACHE_THICK_SHELLS:
+        result = d3plot_read_thick_shells_state_into(plot_file, state,
+                                                     data->data[field]);
+        break;
+      case D3PLT_CACHE_BEAMS:
+        result =
+            d3plot_read_beams_state_into(plot_file, state, data->data[field]);
+        break;
+      case D3PLT_CACHE_SHELLS:
+        result =
+            d3plot_read_shells_state_into(plot_file, state, data->data[field]);
+        break;
+      default:
+        if (data->data[D3PLT_CACHE_NODE_COORDINATES]) {
+          /* The coordinates have already been read, so that they only need
+           * to be subtracted*/
+          d3_kernel_displacement_f64(
+              data->data[field], NULL,
+              data->data[D3PLT_CACHE_NODE_COORDINATES],
+              _d3plot_initial_coordinates(plot_file), data->num_items[field]);
+          result = 1;
+        } else {
+          result = d3plot_read_node_displacement_into(
+              plot_file, state, data->data[field], NULL);
+        }
+        break;
+      }
+
+      if (!result) {
+        return 0;
+      }
+    }
+    field++;
+  }
+
+  return 1;
+}
+
+void _d3plot_state_iter_prefetch(d3plot_state_iter *iter) {
+  if (!iter->has_thread) {
+    iter->read_result =
+        _d3plot_state_iter_read(&iter->reader, iter->next_state,
+                                &iter->buffers[iter->next_state % 2]);
+    return;
+  }
+
+#ifdef _WIN32
+  iter->busy = 1;
+  SetEvent(iter->request_event);
+#else
+  pthread_mutex_lock(&iter->mutex);
+  iter->busy = 1;
+  pthread_cond_signal(&iter->cond);
+  pthread_mutex_unlock(&iter->mutex);
+#endif
+}
+
+void _d3plot_state_iter_wait(d3plot_state_iter *iter) {
+  if (!iter->has_thread) {
+    return;
+  }
+
+#ifdef _WIN32
+  /* busy is only used by the calling thread*/
+  if (iter->busy) {
+    WaitForSingleObject(iter->done_event, INFINITE);
+    iter->busy = 0;
+  }
+#else
+  pthread_mutex_lock(&iter->mutex);
+  while (iter->busy) {
+    pthread_cond_wait(&iter->cond, &iter->mutex);
+  }
+  pthread_mutex_unlock(&iter->mutex);
+#endif
+}
+
+void _d3plot_open_reader(d3plot_file *plot_file, d3plot_file *reader) {
+  *reader = *plot_file;
+  reader->buffer = d3_buffer_open(plot_file->buffer.root_file_name);
+  reader->error_string = NULL;
+  reader->scratch = NULL;
+  reader->scratch_size = 0;
+  reader->cache_first = NULL;
+  reader->cache_last = NULL;
+  reader->cache_size = 0;
+  reader->max_cache_size = 0;
+}
+
+void _d3plot_close_reader(d3plot_file *reader) {
+  d3_buffer_close(&reader->buffer);
+  free(reader->scratch);
+  free(reader->error_string);
+  reader->scratch = NULL;
+  reader->scratch_size = 0;
+  reader->error_string = NULL;
+}
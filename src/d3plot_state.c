@@ -27,110 +27,74 @@
 #include <stdlib.h>
 
 #define CDP plot_file->control_data
-#define DT_PTR_SET(value)                                                      \
-  if (plot_file->num_states == 1)                                              \
-  plot_file->data_pointers[value] = plot_file->buffer.cur_word - state_start
+#define DT_PTR_SET(value) plot_file->data_pointers[value] = state_word
+#define SKIP_WORDS(num_words) state_word += num_words
 
 int _d3plot_read_state_data(d3plot_file *plot_file) {
-  const size_t state_start = plot_file->buffer.cur_word;
+  /* The layout of every state is completely determined by the CONTROL DATA.
+   * Therefore we only walk through the sections and count words instead of
+   * reading them from the files*/
+  size_t state_word = 0;
 
-  double time;
-  d3_buffer_read_double_word(&plot_file->buffer, &time);
-
-  if (time == D3_EOF) {
-    return 2;
-  }
-
-  plot_file->num_states++;
-  plot_file->data_pointers =
-      realloc(plot_file->data_pointers,
-              (D3PLT_PTR_COUNT + plot_file->num_states) * sizeof(size_t));
-  plot_file->data_pointers[D3PLT_PTR_STATES + plot_file->num_states - 1] =
-      state_start;
+  DT_PTR_SET(D3PLT_PTR_STATE_TIME);
+  SKIP_WORDS(1);
 
   /* GLOBAL*/
-  const size_t global_start = plot_file->buffer.cur_word;
+  const size_t global_start = state_word;
 
   double ke, ie, te, x, y, z, mass, force;
-  d3_buffer_skip_words(&plot_file->buffer, 6);
-  /* TODO: read functions for KE, IE, TE, X, Y and Z*/
-
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat8);
-  /* TODO: read function for MAT8 IE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat2);
-  /* TODO: read function for MAT2 IE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat4);
-  /* TODO: read function for MAT4 IE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummatt);
-  /* TODO: read function for MATT IE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.numrbs);
-  /* TODO: read function for RBS IE*/
-
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat8);
-  /* TODO: read function for MAT8 KE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat2);
-  /* TODO: read function for MAT2 KE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat4);
-  /* TODO: read function for MAT4 KE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummatt);
-  /* TODO: read function for MATT KE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.numrbs);
-  /* TODO: read function for RBS KE*/
-
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat8);
-  /* TODO: read function for MAT8 X*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat2);
-  /* TODO: read function for MAT2 X*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat4);
-  /* TODO: read function for MAT4 X*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummatt);
-  /* TODO: read function for MATT X*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.numrbs);
-  /* TODO: read function for RBS X*/
-
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat8);
-  /* TODO: read function for MAT8 Y*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat2);
-  /* TODO: read function for MAT2 Y*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat4);
-  /* TODO: read function for MAT4 Y*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummatt);
-  /* TODO: read function for MATT Y*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.numrbs);
-  /* TODO: read function for RBS Y*/
-
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat8);
-  /* TODO: read function for MAT8 Z*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat2);
-  /* TODO: read function for MAT2 Z*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat4);
-  /* TODO: read function for MAT4 Z*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummatt);
-  /* TODO: read function for MATT Z*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.numrbs);
-  /* TODO: read function for RBS Z*/
-
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat8);
-  /* TODO: read function for MAT8 MASS*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat2);
-  /* TODO: read function for MAT2 MASS*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat4);
-  /* TODO: read function for MAT4 MASS*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummatt);
-  /* TODO: read function for MATT MASS*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.numrbs);
-  /* TODO: read function for RBS MASS*/
-
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat8);
-  /* TODO: read function for MAT8 FORCE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat2);
-  /* TODO: read function for MAT2 FORCE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummat4);
-  /* TODO: read function for MAT4 FORCE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nummatt);
-  /* TODO: read function for MATT FORCE*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.numrbs);
-  /* TODO: read function for RBS FORCE*/
+  SKIP_WORDS(6);
+  /* KE, IE, TE, X, Y and Z are read by d3plot_read_global_history*/
+
+  /* MAT8, MAT2, MAT4, MATT and RBS IE*/
+  SKIP_WORDS(CDP.nummat8);
+  SKIP_WORDS(CDP.nummat2);
+  SKIP_WORDS(CDP.nummat4);
+  SKIP_WORDS(CDP.nummatt);
+  SKIP_WORDS(CDP.numrbs);
+
+  /* MAT8, MAT2, MAT4, MATT and RBS KE*/
+  SKIP_WORDS(CDP.nummat8);
+  SKIP_WORDS(CDP.nummat2);
+  SKIP_WORDS(CDP.nummat4);
+  SKIP_WORDS(CDP.nummatt);
+  SKIP_WORDS(CDP.numrbs);
+
+  /* MAT8, MAT2, MAT4, MATT and RBS X*/
+  SKIP_WORDS(CDP.nummat8);
+  SKIP_WORDS(CDP.nummat2);
+  SKIP_WORDS(CDP.nummat4);
+  SKIP_WORDS(CDP.nummatt);
+  SKIP_WORDS(CDP.numrbs);
+
+  /* MAT8, MAT2, MAT4, MATT and RBS Y*/
+  SKIP_WORDS(CDP.nummat8);
+  SKIP_WORDS(CDP.nummat2);
+  SKIP_WORDS(CDP.nummat4);
+  SKIP_WORDS(CDP.nummatt);
+  SKIP_WORDS(CDP.numrbs);
+
+  /* MAT8, MAT2, MAT4, MATT and RBS Z*/
+  SKIP_WORDS(CDP.nummat8);
+  SKIP_WORDS(CDP.nummat2);
+  SKIP_WORDS(CDP.nummat4);
+  SKIP_WORDS(CDP.nummatt);
+  SKIP_WORDS(CDP.numrbs);
+
+  /* MAT8, MAT2, MAT4, MATT and RBS MASS*/
+  SKIP_WORDS(CDP.nummat8);
+  SKIP_WORDS(CDP.nummat2);
+  SKIP_WORDS(CDP.nummat4);
+  SKIP_WORDS(CDP.nummatt);
+  SKIP_WORDS(CDP.numrbs);
+
+  /* MAT8, MAT2, MAT4, MATT and RBS FORCE*/
+  SKIP_WORDS(CDP.nummat8);
+  SKIP_WORDS(CDP.nummat2);
+  SKIP_WORDS(CDP.nummat4);
+  SKIP_WORDS(CDP.nummatt);
+  SKIP_WORDS(CDP.numrbs);
+  /* The values of all parts are read by d3plot_read_part_global_history*/
 
   /* Assume that N is one*/
   const size_t RWN = 1;
@@ -142,15 +106,15 @@ int _d3plot_read_state_data(d3plot_file *plot_file) {
             RWN;
   }
 
-  d3_buffer_skip_words(&plot_file->buffer, numrw);
+  SKIP_WORDS(numrw);
   /* TODO: read function for RW_FORCE*/
 
   if (RWN == 4) {
-    d3_buffer_skip_words(&plot_file->buffer, numrw * 3);
+    SKIP_WORDS(numrw * 3);
     /* TODO: read function for RW_POS*/
   }
 
-  const size_t global_end = plot_file->buffer.cur_word;
+  const size_t global_end = state_word;
   const size_t global_size = global_end - global_start;
 
   if (global_size != CDP.nglbv) {
@@ -165,7 +129,7 @@ int _d3plot_read_state_data(d3plot_file *plot_file) {
    * IT, U, Mass Scaling, V, A
    ******************************/
 
-  const size_t node_data_start = plot_file->buffer.cur_word;
+  const size_t node_data_start = state_word;
 
   uint8_t it = _get_nth_digit(CDP.it, 0);
   uint8_t N = it * (it > 1);
@@ -179,36 +143,36 @@ int _d3plot_read_state_data(d3plot_file *plot_file) {
       ((it + N + mass_N) + CDP.ndim * (CDP.iu + CDP.iv + CDP.ia)) * CDP.numnp;
 
   if (it > 0) {
-    d3_buffer_skip_words(&plot_file->buffer, it * CDP.numnp);
+    SKIP_WORDS(it * CDP.numnp);
     /* TODO: read function for IT data*/
   }
 
   if (N > 0) {
-    d3_buffer_skip_words(&plot_file->buffer, N * CDP.numnp);
+    SKIP_WORDS(N * CDP.numnp);
     /* TODO: read function for NODE FLUX data*/
   }
 
   if (mass_N) {
-    d3_buffer_skip_words(&plot_file->buffer, CDP.numnp);
+    SKIP_WORDS(CDP.numnp);
     /* TODO: read function for MASS SCALING*/
   }
 
   if (CDP.iu) {
     DT_PTR_SET(D3PLT_PTR_STATE_NODE_COORDS);
-    d3_buffer_skip_words(&plot_file->buffer, 3 * CDP.numnp);
+    SKIP_WORDS(3 * CDP.numnp);
   }
 
   if (CDP.iv) {
     DT_PTR_SET(D3PLT_PTR_STATE_NODE_VEL);
-    d3_buffer_skip_words(&plot_file->buffer, 3 * CDP.numnp);
+    SKIP_WORDS(3 * CDP.numnp);
   }
 
   if (CDP.ia) {
     DT_PTR_SET(D3PLT_PTR_STATE_NODE_ACC);
-    d3_buffer_skip_words(&plot_file->buffer, 3 * CDP.numnp);
+    SKIP_WORDS(3 * CDP.numnp);
   }
 
-  const size_t node_data_end = plot_file->buffer.cur_word;
+  const size_t node_data_end = state_word;
   const size_t node_data_size = node_data_end - node_data_start;
   if (node_data_size != NND) {
     plot_file->error_string = malloc(70);
@@ -218,7 +182,7 @@ int _d3plot_read_state_data(d3plot_file *plot_file) {
   }
 
   /* THERMDATA*/
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nt3d * CDP.nel8);
+  SKIP_WORDS(CDP.nt3d * CDP.nel8);
   /* TODO: read function for nt3d data*/
 
   /* CFDDATA is no longer output*/
@@ -228,23 +192,23 @@ int _d3plot_read_state_data(d3plot_file *plot_file) {
       CDP.nel8 * CDP.nv3d + CDP.nelt * CDP.nv3dt + CDP.nel2 * CDP.nv1d +
       CDP.nel4 * CDP.nv2d +
       CDP.nmsph * 0; /* We don't support SMOOTH PARTICLE HYDRODYNAMICS*/
-  const size_t elem_data_start = plot_file->buffer.cur_word;
+  const size_t elem_data_start = state_word;
 
   DT_PTR_SET(D3PLT_PTR_STATE_ELEMENT_SOLID);
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nv3d * CDP.nel8);
+  SKIP_WORDS(CDP.nv3d * CDP.nel8);
 
   DT_PTR_SET(D3PLT_PTR_STATE_ELEMENT_BEAM);
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nv1d * CDP.nel2);
+  SKIP_WORDS(CDP.nv1d * CDP.nel2);
 
   DT_PTR_SET(D3PLT_PTR_STATE_ELEMENT_SHELL);
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nv2d * CDP.nel4);
+  SKIP_WORDS(CDP.nv2d * CDP.nel4);
 
   /* Then follows who knows what -_(′_′)_-*/
   /* But because we don't support NMSPH, we can assume that NELT follows*/
   DT_PTR_SET(D3PLT_PTR_STATE_ELEMENT_THICK_SHELL);
-  d3_buffer_skip_words(&plot_file->buffer, CDP.nv3dt * CDP.nelt);
+  SKIP_WORDS(CDP.nv3dt * CDP.nelt);
 
-  const size_t elem_data_end = plot_file->buffer.cur_word;
+  const size_t elem_data_end = state_word;
   const size_t elem_data_size = elem_data_end - elem_data_start;
   if (elem_data_size < ENN) {
     plot_file->error_string = malloc(70);
@@ -269,12 +233,69 @@ int _d3plot_read_state_data(d3plot_file *plot_file) {
   }
 
   if (skip_words > 0) {
-    d3_buffer_skip_words(&plot_file->buffer, skip_words);
+    SKIP_WORDS(skip_words);
+  }
+
+  plot_file->state_size = state_word;
+
+  return 1;
+}
+int _d3plot_index_states(d3plot_file *plot_file, size_t word_pos) {
+  d3_buffer *buffer = &plot_file->buffer;
+
+  /* Search the file in which word_pos lies*/
+  size_t file_index = 0;
+  size_t file_start = 0;
+  while (file_index < buffer->num_file_handles &&
+         file_start + buffer->file_sizes[file_index] / buffer->word_size <=
+             word_pos) {
+    file_start += buffer->file_sizes[file_index] / buffer->word_size;
+    file_index++;
   }
 
-  const size_t state_end = plot_file->buffer.cur_word;
-  const size_t state_size =
-      (state_end - state_start) * plot_file->buffer.word_size;
+  while (file_index < buffer->num_file_handles) {
+    const size_t file_end =
+        file_start + buffer->file_sizes[file_index] / buffer->word_size;
+
+    /* Reserve enough data pointers for all states that fit into this file*/
+    if (word_pos + plot_file->state_size <= file_end) {
+      const size_t max_states = plot_file->num_states +
+                                (file_end - word_pos) / plot_file->state_size;
+      plot_file->data_pointers =
+          realloc(plot_file->data_pointers,
+                  (D3PLT_PTR_COUNT + max_states) * sizeof(size_t));
+      plot_file->state_times =
+          realloc(plot_file->state_times, max_states * sizeof(double));
+    }
+
+    /* All states of one file follow directly after each other and the last
+     * one is followed by an EOF marker. So we only need to look at the first
+     * word (the time) of every state*/
+    while (word_pos + plot_file->state_size <= file_end) {
+      double time;
+      if (buffer->word_size == 4) {
+        float time32;
+        d3_buffer_read_words_at(buffer, &time32, 1, word_pos);
+        time = time32;
+      } else {
+        d3_buffer_read_words_at(buffer, &time, 1, word_pos);
+      }
+
+      if (time == D3_EOF) {
+        break;
+      }
+
+      plot_file->data_pointers[D3PLT_PTR_STATES + plot_file->num_states] =
+          word_pos;
+      plot_file->state_times[plot_file->num_states] = time;
+      plot_file->num_states++;
+      word_pos += plot_file->state_size;
+    }
+
+    file_index++;
+    file_start = file_end;
+    word_pos = file_end;
+  }
 
   return 1;
-}
\ No newline at end of file
+}
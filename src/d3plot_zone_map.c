@@ -0,0 +1,519 @@
+/***********************************************************************************
+ *                         This file is part of dynareadout
+ *                    https://github.com/PucklaMotzer09/dynareadout
+ ***********************************************************************************
+ * Copyright (c) 2022 PucklaMotzer09
+ *
+ * This software is provided 'as-is', without any express or implied warranty.
+ * In no event will the authors be held liable for any damages arising from the
+ * use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not claim
+ * that you wrote the original software. If you use this software in a product,
+ * an acknowledgment in the product documentation would be appreciated but is
+ * not required.
+ *
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ * misrepresented as being the original software.
+ *
+ * 3. This notice may not be removed or altered from any source distribution.
+ ************************************************************************************/
+
+#include "d3plot.h"
+#include "d3_kernels.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define D3PLT_ZONE_COORDINATES                                                 \
+  ((1 << D3PLT_ZONE_COORDINATE_X) | (1 << D3PLT_ZONE_COORDINATE_Y) |           \
+   (1 << D3PLT_ZONE_COORDINATE_Z))
+#define D3PLT_ZONE_NODE_QUANTITIES                                             \
+  (D3PLT_ZONE_COORDINATES | (1 << D3PLT_ZONE_VELOCITY))
+#define D3PLT_ZONE_ELEMENT_QUANTITIES                                          \
+  ((1 << D3PLT_ZONE_PLASTIC_STRAIN) | (1 << D3PLT_ZONE_VON_MISES))
+
+/* The element types that hold stresses and plastic strains*/
+static const int _d3plot_zone_element_types[3] = {
+    D3PLT_ELEMENT_SOLID, D3PLT_ELEMENT_THICK_SHELL, D3PLT_ELEMENT_SHELL};
+
+/* The number of nodes and the number of words of the connectivity of every
+ * element type (D3PLT_ELEMENT_*)*/
+static const size_t _d3plot_zone_num_nodes[D3PLT_ELEMENT_TYPE_COUNT] = {
+    8, 8, 2, 4};
+static const size_t _d3plot_zone_con_words[D3PLT_ELEMENT_TYPE_COUNT] = {
+    sizeof(d3plot_solid_con) / sizeof(d3_word),
+    sizeof(d3plot_thick_shell_con) / sizeof(d3_word),
+    sizeof(d3plot_beam_con) / sizeof(d3_word),
+    sizeof(d3plot_shell_con) / sizeof(d3_word)};
+
+static void _d3plot_zone_update(double *min, double *max, double value) {
+  /* NaN fails both comparisons and is therefore ignored*/
+  if (value < *min) {
+    *min = value;
+  }
+  if (value > *max) {
+    *max = value;
+  }
+}
+
+static int _d3plot_zone_matches(const d3plot_zone_map *zone_map, size_t index,
+                                double min_value, double max_value) {
+  const double min = zone_map->min[index];
+  const double max = zone_map->max[index];
+  return min <= max && min <= max_value && max >= min_value;
+}
+
+/* Build the nodes of every part in the CSR format of part_offsets and
+ * part_elements. The nodes of a part are the nodes of all of its elements,
+ * each of which is stored once*/
+static void _d3plot_build_part_nodes(d3plot_file *plot_file,
+                                     size_t **node_offsets, size_t **nodes) {
+  const size_t num_parts = plot_file->control_data.nmmat;
+  const size_t num_nodes = plot_file->control_data.numnp;
+
+  d3_word *cons[D3PLT_ELEMENT_TYPE_COUNT];
+  size_t num_elements;
+  cons[D3PLT_ELEMENT_SOLID] =
+      (d3_word *)d3plot_read_solid_elements(plot_file, &num_elements);
+  cons[D3PLT_ELEMENT_THICK_SHELL] =
+      (d3_word *)d3plot_read_thick_shell_elements(plot_file, &num_elements);
+  cons[D3PLT_ELEMENT_BEAM] =
+      (d3_word *)d3plot_read_beam_elements(plot_file, &num_elements);
+  cons[D3PLT_ELEMENT_SHELL] =
+      (d3_word *)d3plot_read_shell_elements(plot_file, &num_elements);
+
+  /* The last part that a node has been added to, so that a node that is
+   * shared by several elements of a part is only added once*/
+  size_t *last_part = malloc(num_nodes * sizeof(size_t));
+  *node_offsets = malloc((num_parts + 1) * sizeof(size_t));
+  *nodes = NULL;
+
+  /* Count the nodes of every part in the first pass and place them in the
+   * second one*/
+  int pass = 0;
+  while (pass < 2) {
+    size_t i = 0;
+    while (i < num_nodes) {
+      last_part[i] = D3PLT_INVALID_INDEX;
+      i++;
+    }
+
+    size_t num_part_nodes = 0;
+    size_t p = 0;
+    while (p < num_parts) {
+      (*node_offsets)[p] = num_part_nodes;
+
+      int t = 0;
+      while (t < D3PLT_ELEMENT_TYPE_COUNT) {
+        const size_t *elements =
+            _d3plot_part_elements(plot_file, t, p, &num_elements);
+        size_t e = 0;
+        while (e < num_elements) {
+          const d3_word *node_ids =
+              &cons[t][elements[e] * _d3plot_zone_con_words[t]];
+          size_t k = 0;
+          while (k < _d3plot_zone_num_nodes[t]) {
+            /* The connectivity holds node numbers starting at 1*/
+            const d3_word node = node_ids[k] - 1;
+            if (node_ids[k] >= 1 && node < num_nodes && last_part[node] != p) {
+              last_part[node] = p;
+              if (pass == 1) {
+                (*nodes)[num_part_nodes] = node;
+              }
+              num_part_nodes++;
+            }
+            k++;
+          }
+          e++;
+        }
+        t++;
+      }
+
+      p++;
+    }
+    (*node_offsets)[num_parts] = num_part_nodes;
+
+    if (pass == 0) {
+      *nodes = malloc(num_part_nodes * sizeof(size_t));
+    }
+    pass++;
+  }
+
+  free(last_part);
+  int t = 0;
+  while (t < D3PLT_ELEMENT_TYPE_COUNT) {
+    free(cons[t]);
+    t++;
+  }
+}
+
+int d3plot_build_zone_map(d3plot_file *plot_file, unsigned int quantities,
+                          int surface, d3plot_zone_map *zone_map) {
+  zone_map->min = NULL;
+  zone_map->max = NULL;
+  zone_map->num_states = 0;
+  zone_map->num_parts = 0;
+  zone_map->quantities = 0;
+  zone_map->surface = surface;
+
+  if (surface < D3PLT_SURFACE_MID || surface > D3PLT_SURFACE_OUTER) {
+    plot_file->error_string = malloc(50);
+    sprintf(plot_file->error_string, "%d is not a valid surface", surface);
+    return 0;
+  }
+
+  quantities = _d3plot_zone_map_quantities(plot_file, quantities, surface);
+  const size_t num_parts = plot_file->control_data.nmmat;
+  const size_t num_values =
+      plot_file->num_states * num_parts * D3PLT_ZONE_QUANTITY_COUNT;
+  zone_map->min = malloc(num_values * sizeof(double));
+  zone_map->max = malloc(num_values * sizeof(double));
+  zone_map->num_states = plot_file->num_states;
+  zone_map->num_parts = num_parts;
+  zone_map->quantities = quantities;
+
+  size_t i = 0;
+  while (i < num_values) {
+    zone_map->min[i] = HUGE_VAL;
+    zone_map->max[i] = -HUGE_VAL;
+    i++;
+  }
+  if (num_values == 0) {
+    return 1;
+  }
+
+  /* Nodes can belong to several parts, so that they are summarized part by
+   * part. Elements only belong to one part and are summarized in the order of
+   * the files by looking up their part*/
+  size_t *node_offsets = NULL, *part_nodes = NULL;
+  double *node_data = NULL;
+  if (quantities & D3PLT_ZONE_NODE_QUANTITIES) {
+    _d3plot_build_part_nodes(plot_file, &node_offsets, &part_nodes);
+    node_data = malloc(plot_file->control_data.numnp * 3 * sizeof(double));
+  }
+
+  size_t *element_parts[3] = {NULL, NULL, NULL};
+  size_t num_elements[3] = {0, 0, 0};
+  size_t num_words[3], data_types[3], stress_words[3], plastic_strain_words[3];
+  int t = 0;
+  while (t < 3) {
+    num_elements[t] = _d3plot_surface_words(
+        plot_file, _d3plot_zone_element_types[t], surface, &num_words[t],
+        &data_types[t], &stress_words[t], &plastic_strain_words[t]);
+    if (!(quantities & D3PLT_ZONE_ELEMENT_QUANTITIES) ||
+        num_elements[t] == 0) {
+      num_elements[t] = 0;
+      t++;
+      continue;
+    }
+
+    element_parts[t] = malloc(num_elements[t] * sizeof(size_t));
+    i = 0;
+    while (i < num_elements[t]) {
+      element_parts[t][i] = D3PLT_INVALID_INDEX;
+      i++;
+    }
+    size_t p = 0;
+    while (p < num_parts) {
+      size_t num_part_elements;
+      const size_t *elements = _d3plot_part_elements(
+          plot_file, _d3plot_zone_element_types[t], p, &num_part_elements);
+      i = 0;
+      while (i < num_part_elements) {
+        element_parts[t][elements[i]] = p;
+        i++;
+      }
+      p++;
+    }
+    t++;
+  }
+  double *von_mises = malloc(2 * D3PLT_ELEMENT_BLOCK_SIZE * sizeof(double));
+  double *plastic_strain = &von_mises[D3PLT_ELEMENT_BLOCK_SIZE];
+
+  int result = 1;
+  size_t state = 0;
+  while (state < plot_file->num_states) {
+    double *min = &zone_map->min[state * num_parts * D3PLT_ZONE_QUANTITY_COUNT];
+    double *max = &zone_map->max[state * num_parts * D3PLT_ZONE_QUANTITY_COUNT];
+
+    if (quantities & D3PLT_ZONE_COORDINATES) {
+      if (!_d3plot_read_node_data_into(plot_file, state,
+                                       D3PLT_PTR_STATE_NODE_COORDS,
+                                       node_data)) {
+        result = 0;
+        break;
+      }
+
+      size_t p = 0;
+      while (p < num_parts) {
+        const size_t zone = p * D3PLT_ZONE_QUANTITY_COUNT;
+        i = node_offsets[p];
+        while (i < node_offsets[p + 1]) {
+          const double *coords = &node_data[part_nodes[i] * 3];
+          _d3plot_zone_update(&min[zone + D3PLT_ZONE_COORDINATE_X],
+                              &max[zone + D3PLT_ZONE_COORDINATE_X], coords[0]);
+          _d3plot_zone_update(&min[zone + D3PLT_ZONE_COORDINATE_Y],
+                              &max[zone + D3PLT_ZONE_COORDINATE_Y], coords[1]);
+          _d3plot_zone_update(&min[zone + D3PLT_ZONE_COORDINATE_Z],
+                              &max[zone + D3PLT_ZONE_COORDINATE_Z], coords[2]);
+          i++;
+        }
+        p++;
+      }
+    }
+
+    if (quantities & (1 << D3PLT_ZONE_VELOCITY)) {
+      if (!_d3plot_read_node_data_into(plot_file, state,
+                                       D3PLT_PTR_STATE_NODE_VEL, node_data)) {
+        result = 0;
+        break;
+      }
+
+      size_t p = 0;
+      while (p < num_parts) {
+        const size_t zone = p * D3PLT_ZONE_QUANTITY_COUNT;
+        i = node_offsets[p];
+        while (i < node_offsets[p + 1]) {
+          const double *vel = &node_data[part_nodes[i] * 3];
+          _d3plot_zone_update(
+              &min[zone + D3PLT_ZONE_VELOCITY],
+              &max[zone + D3PLT_ZONE_VELOCITY],
+              sqrt(vel[0] * vel[0] + vel[1] * vel[1] + vel[2] * vel[2]));
+          i++;
+        }
+        p++;
+      }
+    }
+
+    t = 0;
+    while (t < 3) {
+      if (num_elements[t] == 0) {
+        t++;
+        continue;
+      }
+
+      const size_t word_pos =
+          plot_file->data_pointers[D3PLT_PTR_STATES + state] +
+          plot_file->data_pointers[data_types[t]];
+      void *data = _d3plot_scratch(plot_file, D3PLT_ELEMENT_BLOCK_SIZE *
+                                                  num_words[t] *
+                                                  plot_file->buffer.word_size);
+
+      size_t e = 0;
+      while (e < num_elements[t]) {
+        const size_t block_size =
+            num_elements[t] - e < D3PLT_ELEMENT_BLOCK_SIZE
+                ? num_elements[t] - e
+                : D3PLT_ELEMENT_BLOCK_SIZE;
+        d3_buffer_read_words_at(&plot_file->buffer, data,
+                                block_size * num_words[t],
+                                word_pos + e * num_words[t]);
+
+        if (quantities & (1 << D3PLT_ZONE_VON_MISES)) {
+          if (plot_file->buffer.word_size == 4) {
+            d3_kernel_von_mises_f32(von_mises,
+                                    (const float *)data + stress_words[t],
+                                    num_words[t], block_size);
+          } else {
+            d3_kernel_von_mises_f64(von_mises,
+                                    (const double *)data + stress_words[t],
+                                    num_words[t], block_size);
+          }
+        }
+        if (quantities & (1 << D3PLT_ZONE_PLASTIC_STRAIN)) {
+          if (plot_file->buffer.word_size == 4) {
+            d3_kernel_widen_f32_gather(
+                plastic_strain,
+                (const float *)data + plastic_strain_words[t], num_words[t],
+                block_size);
+          } else {
+            d3_kernel_copy_f64_gather(
+                plastic_strain,
+                (const double *)data + plastic_strain_words[t], num_words[t],
+                block_size);
+          }
+        }
+
+        i = 0;
+        while (i < block_size) {
+          const size_t p = element_parts[t][e + i];
+          if (p != D3PLT_INVALID_INDEX) {
+            const size_t zone = p * D3PLT_ZONE_QUANTITY_COUNT;
+            if (quantities & (1 << D3PLT_ZONE_VON_MISES)) {
+              _d3plot_zone_update(&min[zone + D3PLT_ZONE_VON_MISES],
+                                  &max[zone + D3PLT_ZONE_VON_MISES],
+                                  von_mises[i]);
+            }
+            if (quantities & (1 << D3PLT_ZONE_PLASTIC_STRAIN)) {
+              _d3plot_zone_update(&min[zone + D3PLT_ZONE_PLASTIC_STRAIN],
+                                  &max[zone + D3PLT_ZONE_PLASTIC_STRAIN],
+                                  plastic_strain[i]);
+            }
+          }
+          i++;
+        }
+
+        e += block_size;
+      }
+      t++;
+    }
+
+    state++;
+  }
+
+  free(von_mises);
+  t = 0;
+  while (t < 3) {
+    free(element_parts[t]);
+    t++;
+  }
+  free(node_data);
+  free(part_nodes);
+  free(node_offsets);
+
+  if (!result) {
+    d3plot_free_zone_map(zone_map);
+  }
+  return result;
+}
+
+int d3plot_open_zone_map(d3plot_file *plot_file, unsigned int quantities,
+                         int surface, const char *zone_map_file_name,
+                         d3plot_zone_map *zone_map) {
+  if (_d3plot_read_zone_map(plot_file, zone_map_file_name, zone_map)) {
+    /* The file may hold more quantities than needed, but not less*/
+    if (zone_map->surface == surface &&
+        (_d3plot_zone_map_quantities(plot_file, quantities, surface) &
+         ~zone_map->quantities) == 0) {
+      return 1;
+    }
+    d3plot_free_zone_map(zone_map);
+  }
+
+  if (!d3plot_build_zone_map(plot_file, quantities, surface, zone_map)) {
+    return 0;
+  }
+
+  if (!d3plot_write_zone_map(plot_file, zone_map, zone_map_file_name)) {
+    /* The file is only an optimisation. Failing to write it should not fail
+     * the whole building*/
+    free(plot_file->error_string);
+    plot_file->error_string = NULL;
+  }
+
+  return 1;
+}
+
+size_t *d3plot_zone_map_states(const d3plot_zone_map *zone_map, int quantity,
+                               double min_value, double max_value,
+                               const size_t *part_indices,
+                               size_t num_part_indices, size_t *num_states) {
+  /* States cannot be skipped for quantities that have not been summarized*/
+  const int summarized = quantity >= 0 &&
+                         quantity < D3PLT_ZONE_QUANTITY_COUNT &&
+                         (zone_map->quantities & (1 << quantity));
+  size_t *states = malloc(zone_map->num_states * sizeof(size_t));
+  *num_states = 0;
+
+  size_t state = 0;
+  while (state < zone_map->num_states) {
+    const size_t zone = state * zone_map->num_parts;
+    int matches = !summarized;
+
+    size_t i = 0;
+    const size_t num_parts = part_indices ? num_part_indices
+                                          : zone_map->num_parts;
+    while (!matches && i < num_parts) {
+      const size_t p = part_indices ? part_indices[i] : i;
+      matches = p < zone_map->num_parts &&
+                _d3plot_zone_matches(zone_map,
+                                     (zone + p) * D3PLT_ZONE_QUANTITY_COUNT +
+                                         quantity,
+                                     min_value, max_value);
+      i++;
+    }
+
+    if (matches) {
+      states[(*num_states)++] = state;
+    }
+    state++;
+  }
+
+  return states;
+}
+
+size_t *d3plot_zone_map_parts(const d3plot_zone_map *zone_map, size_t state,
+                              int quantity, double min_value, double max_value,
+                              size_t *num_parts) {
+  *num_parts = 0;
+  if (state >= zone_map->num_states) {
+    return NULL;
+  }
+
+  const int summarized = quantity >= 0 &&
+                         quantity < D3PLT_ZONE_QUANTITY_COUNT &&
+                         (zone_map->quantities & (1 << quantity));
+  size_t *parts = malloc(zone_map->num_parts * sizeof(size_t));
+
+  size_t p = 0;
+  while (p < zone_map->num_parts) {
+    if (!summarized ||
+        _d3plot_zone_matches(zone_map,
+                             (state * zone_map->num_parts + p) *
+                                     D3PLT_ZONE_QUANTITY_COUNT +
+                                 quantity,
+                             min_value, max_value)) {
+      parts[(*num_parts)++] = p;
+    }
+    p++;
+  }
+
+  return parts;
+}
+
+void d3plot_free_zone_map(d3plot_zone_map *zone_map) {
+  free(zone_map->min);
+  free(zone_map->max);
+  zone_map->min = NULL;
+  zone_map->max = NULL;
+  zone_map->num_states = 0;
+  zone_map->num_parts = 0;
+  zone_map->quantities = 0;
+}
+
+unsigned int _d3plot_zone_map_quantities(d3plot_file *plot_file,
+                                         unsigned int quantities,
+                                         int surface) {
+  unsigned int available = 0;
+  if (plot_file->control_data.iu) {
+    available |= D3PLT_ZONE_COORDINATES;
+  }
+  if (plot_file->control_data.iv) {
+    available |= 1 << D3PLT_ZONE_VELOCITY;
+  }
+
+  /* The element quantities are only summarized if every element type holds
+   * them, since a missing summary would make queries skip elements*/
+  available |= D3PLT_ZONE_ELEMENT_QUANTITIES;
+  int t = 0;
+  while (t < 3) {
+    size_t num_words, data_type, stress_word, plastic_strain_word;
+    const size_t num_elements = _d3plot_surface_words(
+        plot_file, _d3plot_zone_element_types[t], surface, &num_words,
+        &data_type, &stress_word, &plastic_strain_word);
+    if (num_elements != 0 && stress_word == D3PLT_NO_VALUE) {
+      available &= ~(1 << D3PLT_ZONE_VON_MISES);
+    }
+    if (num_elements != 0 && plastic_strain_word == D3PLT_NO_VALUE) {
+      available &= ~(1 << D3PLT_ZONE_PLASTIC_STRAIN);
+    }
+    t++;
+  }
+
+  return quantities & available;
+}
@@ -89,6 +89,8 @@ template <typename T> inline const char *get_array_name() {
     return "DoubleArray";
   } else if constexpr (std::is_same_v<T, dVec3>) {
     return "Vec3Array";
+  } else if constexpr (std::is_same_v<T, fVec3>) {
+    return "FloatVec3Array";
   } else if constexpr (std::is_same_v<T, d3plot_solid_con>) {
     return "SolidConArray";
   } else if constexpr (std::is_same_v<T, d3plot_beam_con>) {
@@ -105,6 +107,10 @@ template <typename T> inline const char *get_array_name() {
     return "BeamArray";
   } else if constexpr (std::is_same_v<T, d3plot_shell>) {
     return "ShellArray";
+  } else if constexpr (std::is_same_v<T, d3plot_solid_f32>) {
+    return "SolidF32Array";
+  } else if constexpr (std::is_same_v<T, d3plot_shell_f32>) {
+    return "ShellF32Array";
   }
 }
 
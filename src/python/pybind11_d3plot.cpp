@@ -36,6 +36,35 @@ namespace py = pybind11;
     return array_vector_wrapper(plot_file.func(state));                        \
   }
 
+// The fields of a StateView are overwritten by the background thread of its
+// StateRange, so that Python gets its own copy of them
+#define STATE_VIEW_COPY_WRAPPER(func)                                          \
+  [](const dro::StateView &view) { return copy_state_view_field(view.func()); }
+
+template <typename T>
+inline dro::Array<T> copy_state_view_field(const dro::Array<T> &field) {
+  if (field.empty()) {
+    return dro::Array<T>(nullptr, 0);
+  }
+
+  T *data = reinterpret_cast<T *>(malloc(field.size() * sizeof(T)));
+  memcpy(data, field.data(), field.size() * sizeof(T));
+  return dro::Array<T>(data, field.size());
+}
+
+template <typename T>
+inline void add_cached_state_type_to_module(py::module_ &m, const char *name) {
+  py::class_<dro::CachedState<T>>(m, name)
+      .def("__len__", &dro::CachedState<T>::size)
+      .def("__getitem__", [](const dro::CachedState<T> &self, size_t index) {
+        try {
+          return self[index];
+        } catch (const std::runtime_error &) {
+          throw py::index_error("Index out of range");
+        }
+      });
+}
+
 inline void add_d3plot_arrays_to_module(py::module_ &m) {
   dro::add_array_type_to_module<d3plot_solid_con>(m);
   dro::add_array_type_to_module<d3plot_beam_con>(m);
@@ -45,11 +74,77 @@ inline void add_d3plot_arrays_to_module(py::module_ &m) {
   dro::add_array_type_to_module<d3plot_beam>(m);
   dro::add_array_type_to_module<d3plot_shell>(m);
   dro::add_array_type_to_module<dro::dVec3>(m);
+  dro::add_array_type_to_module<d3plot_solid_f32>(m);
+  dro::add_array_type_to_module<d3plot_shell_f32>(m);
+  dro::add_array_type_to_module<dro::fVec3>(m);
+
+  add_cached_state_type_to_module<dro::dVec3>(m, "CachedVec3State");
+  add_cached_state_type_to_module<d3plot_solid>(m, "CachedSolidState");
+  add_cached_state_type_to_module<d3plot_thick_shell>(m,
+                                                      "CachedThickShellState");
+  add_cached_state_type_to_module<d3plot_beam>(m, "CachedBeamState");
+  add_cached_state_type_to_module<d3plot_shell>(m, "CachedShellState");
 }
 
 void add_d3plot_library_to_module(py::module_ &m) {
   add_d3plot_arrays_to_module(m);
 
+  m.attr("D3PLT_FIELD_STRESS") = D3PLT_FIELD_STRESS;
+  m.attr("D3PLT_FIELD_EFFECTIVE_PLASTIC_STRAIN") =
+      D3PLT_FIELD_EFFECTIVE_PLASTIC_STRAIN;
+  m.attr("D3PLT_FIELD_EXTRA") = D3PLT_FIELD_EXTRA;
+  m.attr("D3PLT_FIELD_STRAIN") = D3PLT_FIELD_STRAIN;
+  m.attr("D3PLT_FIELD_INTERNAL_ENERGY") = D3PLT_FIELD_INTERNAL_ENERGY;
+  m.attr("D3PLT_FIELD_ALL") = D3PLT_FIELD_ALL;
+  m.attr("D3PLT_INVALID_INDEX") = D3PLT_INVALID_INDEX;
+  m.attr("D3PLT_GLOBAL_KINETIC_ENERGY") = D3PLT_GLOBAL_KINETIC_ENERGY;
+  m.attr("D3PLT_GLOBAL_INTERNAL_ENERGY") = D3PLT_GLOBAL_INTERNAL_ENERGY;
+  m.attr("D3PLT_GLOBAL_TOTAL_ENERGY") = D3PLT_GLOBAL_TOTAL_ENERGY;
+  m.attr("D3PLT_GLOBAL_VELOCITY_X") = D3PLT_GLOBAL_VELOCITY_X;
+  m.attr("D3PLT_GLOBAL_VELOCITY_Y") = D3PLT_GLOBAL_VELOCITY_Y;
+  m.attr("D3PLT_GLOBAL_VELOCITY_Z") = D3PLT_GLOBAL_VELOCITY_Z;
+  m.attr("D3PLT_PART_INTERNAL_ENERGY") = D3PLT_PART_INTERNAL_ENERGY;
+  m.attr("D3PLT_PART_KINETIC_ENERGY") = D3PLT_PART_KINETIC_ENERGY;
+  m.attr("D3PLT_PART_VELOCITY_X") = D3PLT_PART_VELOCITY_X;
+  m.attr("D3PLT_PART_VELOCITY_Y") = D3PLT_PART_VELOCITY_Y;
+  m.attr("D3PLT_PART_VELOCITY_Z") = D3PLT_PART_VELOCITY_Z;
+  m.attr("D3PLT_PART_MASS") = D3PLT_PART_MASS;
+  m.attr("D3PLT_PART_FORCE") = D3PLT_PART_FORCE;
+  m.attr("D3PLT_PART_ALL") = D3PLT_PART_ALL;
+  m.attr("D3PLT_SURFACE_MID") = D3PLT_SURFACE_MID;
+  m.attr("D3PLT_SURFACE_INNER") = D3PLT_SURFACE_INNER;
+  m.attr("D3PLT_SURFACE_OUTER") = D3PLT_SURFACE_OUTER;
+  m.attr("D3PLT_ENVELOPE_NODE_DISPLACEMENT") = D3PLT_ENVELOPE_NODE_DISPLACEMENT;
+  m.attr("D3PLT_ENVELOPE_SOLID_VON_MISES") = D3PLT_ENVELOPE_SOLID_VON_MISES;
+  m.attr("D3PLT_ENVELOPE_SOLID_PLASTIC_STRAIN") =
+      D3PLT_ENVELOPE_SOLID_PLASTIC_STRAIN;
+  m.attr("D3PLT_ENVELOPE_THICK_SHELL_VON_MISES") =
+      D3PLT_ENVELOPE_THICK_SHELL_VON_MISES;
+  m.attr("D3PLT_ENVELOPE_THICK_SHELL_PLASTIC_STRAIN") =
+      D3PLT_ENVELOPE_THICK_SHELL_PLASTIC_STRAIN;
+  m.attr("D3PLT_ENVELOPE_SHELL_VON_MISES") = D3PLT_ENVELOPE_SHELL_VON_MISES;
+  m.attr("D3PLT_ENVELOPE_SHELL_PLASTIC_STRAIN") =
+      D3PLT_ENVELOPE_SHELL_PLASTIC_STRAIN;
+  m.attr("D3PLT_ENVELOPE_QUANTITY_COUNT") = D3PLT_ENVELOPE_QUANTITY_COUNT;
+  m.attr("D3PLT_ENVELOPE_ALL") = D3PLT_ENVELOPE_ALL;
+  m.attr("D3PLT_ZONE_COORDINATE_X") = D3PLT_ZONE_COORDINATE_X;
+  m.attr("D3PLT_ZONE_COORDINATE_Y") = D3PLT_ZONE_COORDINATE_Y;
+  m.attr("D3PLT_ZONE_COORDINATE_Z") = D3PLT_ZONE_COORDINATE_Z;
+  m.attr("D3PLT_ZONE_VELOCITY") = D3PLT_ZONE_VELOCITY;
+  m.attr("D3PLT_ZONE_PLASTIC_STRAIN") = D3PLT_ZONE_PLASTIC_STRAIN;
+  m.attr("D3PLT_ZONE_VON_MISES") = D3PLT_ZONE_VON_MISES;
+  m.attr("D3PLT_ZONE_QUANTITY_COUNT") = D3PLT_ZONE_QUANTITY_COUNT;
+  m.attr("D3PLT_ZONE_ALL") = D3PLT_ZONE_ALL;
+  m.attr("D3PLT_CACHE_NODE_COORDINATES") = D3PLT_CACHE_NODE_COORDINATES;
+  m.attr("D3PLT_CACHE_NODE_VELOCITY") = D3PLT_CACHE_NODE_VELOCITY;
+  m.attr("D3PLT_CACHE_NODE_ACCELERATION") = D3PLT_CACHE_NODE_ACCELERATION;
+  m.attr("D3PLT_CACHE_SOLIDS") = D3PLT_CACHE_SOLIDS;
+  m.attr("D3PLT_CACHE_THICK_SHELLS") = D3PLT_CACHE_THICK_SHELLS;
+  m.attr("D3PLT_CACHE_BEAMS") = D3PLT_CACHE_BEAMS;
+  m.attr("D3PLT_CACHE_SHELLS") = D3PLT_CACHE_SHELLS;
+  m.attr("D3PLT_CACHE_NODE_DISPLACEMENT") = D3PLT_CACHE_NODE_DISPLACEMENT;
+  m.attr("D3PLT_ITER_ALL") = D3PLT_ITER_ALL;
+
   py::class_<d3plot_solid_con>(m, "d3plot_solid_con")
       .def_readonly("node_ids", &d3plot_solid_con::node_ids)
       .def_readonly("material_id", &d3plot_solid_con::material_id)
@@ -140,8 +235,122 @@ void add_d3plot_library_to_module(py::module_ &m) {
 
       ;
 
+  py::class_<dro::D3plotPartState>(m, "D3plotPartState")
+      .def_readonly("solids", &dro::D3plotPartState::solids)
+      .def_readonly("thick_shells", &dro::D3plotPartState::thick_shells)
+      .def_readonly("beams", &dro::D3plotPartState::beams)
+      .def_readonly("shells", &dro::D3plotPartState::shells)
+
+      ;
+
+  py::class_<d3plot_tensor_f32>(m, "d3plot_tensor_f32")
+      .def_readonly("x", &d3plot_tensor_f32::x)
+      .def_readonly("y", &d3plot_tensor_f32::y)
+      .def_readonly("z", &d3plot_tensor_f32::z)
+      .def_readonly("xy", &d3plot_tensor_f32::xy)
+      .def_readonly("yx", &d3plot_tensor_f32::yx)
+      .def_readonly("yz", &d3plot_tensor_f32::yz)
+      .def_readonly("zy", &d3plot_tensor_f32::zy)
+      .def_readonly("xz", &d3plot_tensor_f32::xz)
+      .def_readonly("zx", &d3plot_tensor_f32::zx)
+
+      ;
+
+  py::class_<d3plot_surface_f32>(m, "d3plot_surface_f32")
+      .def_readonly("sigma", &d3plot_surface_f32::sigma)
+      .def_readonly("stress", &d3plot_surface_f32::stress)
+      .def_readonly("effective_plastic_strain",
+                    &d3plot_surface_f32::effective_plastic_strain)
+      .def_readonly("material_dependent_value",
+                    &d3plot_surface_f32::material_dependent_value)
+
+      ;
+
+  py::class_<d3plot_solid_f32>(m, "d3plot_solid_f32")
+      .def_readonly("sigma", &d3plot_solid_f32::sigma)
+      .def_readonly("stress", &d3plot_solid_f32::stress)
+      .def_readonly("effective_plastic_strain",
+                    &d3plot_solid_f32::effective_plastic_strain)
+      .def_readonly("material_dependent_value",
+                    &d3plot_solid_f32::material_dependent_value)
+      .def_readonly("extra1", &d3plot_solid_f32::extra1)
+      .def_readonly("extra2", &d3plot_solid_f32::extra2)
+      .def_readonly("epsilon", &d3plot_solid_f32::epsilon)
+      .def_readonly("strain", &d3plot_solid_f32::strain)
+
+      ;
+
+  py::class_<d3plot_shell_f32>(m, "d3plot_shell_f32")
+      .def_readonly("mid", &d3plot_shell_f32::mid)
+      .def_readonly("inner", &d3plot_shell_f32::inner)
+      .def_readonly("outer", &d3plot_shell_f32::outer)
+      .def_readonly("inner_epsilon", &d3plot_shell_f32::inner_epsilon)
+      .def_readonly("inner_strain", &d3plot_shell_f32::inner_strain)
+      .def_readonly("outer_epsilon", &d3plot_shell_f32::outer_epsilon)
+      .def_readonly("outer_strain", &d3plot_shell_f32::outer_strain)
+      .def_readonly("internal_energy", &d3plot_shell_f32::internal_energy)
+
+      ;
+
+  // Every field is returned as a copy, which stays valid after the range has
+  // been advanced. The copy needs to be taken before advancing the range,
+  // since the next state after it is read into the same buffer
+  py::class_<dro::StateView>(m, "StateView")
+      .def_property_readonly("state", &dro::StateView::state)
+      .def_property_readonly("time", &dro::StateView::time)
+      .def("node_coordinates", STATE_VIEW_COPY_WRAPPER(node_coordinates))
+      .def("node_velocity", STATE_VIEW_COPY_WRAPPER(node_velocity))
+      .def("node_acceleration", STATE_VIEW_COPY_WRAPPER(node_acceleration))
+      .def("solids", STATE_VIEW_COPY_WRAPPER(solids))
+      .def("thick_shells", STATE_VIEW_COPY_WRAPPER(thick_shells))
+      .def("beams", STATE_VIEW_COPY_WRAPPER(beams))
+      .def("shells", STATE_VIEW_COPY_WRAPPER(shells))
+      .def("node_displacement", STATE_VIEW_COPY_WRAPPER(node_displacement))
+
+      ;
+
+  py::class_<dro::StateRange>(m, "StateRange")
+      .def("__iter__", [](py::object self) { return self; })
+      .def(
+          "__next__",
+          [](dro::StateRange &self) {
+            const d3plot_state_data *data = self.next();
+            if (!data) {
+              throw py::stop_iteration();
+            }
+            return dro::StateView(data);
+          },
+          py::keep_alive<0, 1>())
+
+      ;
+
+  py::class_<dro::Envelope>(m, "Envelope")
+      .def_readonly("max", &dro::Envelope::max)
+      .def_readonly("min", &dro::Envelope::min)
+      .def_readonly("max_state", &dro::Envelope::max_state)
+      .def_readonly("min_state", &dro::Envelope::min_state)
+
+      ;
+
+  py::class_<dro::ZoneMap>(m, "ZoneMap")
+      .def("min", &dro::ZoneMap::min)
+      .def("max", &dro::ZoneMap::max)
+      .def("states", &dro::ZoneMap::states, py::arg("quantity"),
+           py::arg("min_value"), py::arg("max_value"),
+           py::arg("part_indices") = std::vector<size_t>())
+      .def("parts", &dro::ZoneMap::parts)
+      .def("num_states", &dro::ZoneMap::num_states)
+      .def("num_parts", &dro::ZoneMap::num_parts)
+      .def("quantities", &dro::ZoneMap::quantities)
+      .def("surface", &dro::ZoneMap::surface)
+
+      ;
+
   py::class_<dro::D3plot>(m, "D3plot")
       .def(py::init<const std::string &>())
+      .def(py::init<const std::string &, const std::string &>())
+      .def("refresh", &dro::D3plot::refresh)
+      .def("write_index", &dro::D3plot::write_index)
       .def("read_node_ids", &dro::D3plot::read_node_ids)
       .def("read_solid_element_ids", &dro::D3plot::read_solid_element_ids)
       .def("read_beam_element_ids", &dro::D3plot::read_beam_element_ids)
@@ -149,17 +358,247 @@ void add_d3plot_library_to_module(py::module_ &m) {
       .def("read_solid_shell_element_ids",
            &dro::D3plot::read_solid_shell_element_ids)
       .def("read_all_element_ids", &dro::D3plot::read_all_element_ids)
+      .def("read_all_element_ids_origin",
+           [](dro::D3plot &plot_file) {
+             dro::Array<uint8_t> element_types(nullptr, 0);
+             dro::Array<size_t> element_indices(nullptr, 0);
+             auto ids = plot_file.read_all_element_ids_origin(element_types,
+                                                              element_indices);
+             return py::make_tuple(std::move(ids), std::move(element_types),
+                                   std::move(element_indices));
+           })
       .def("read_part_ids", &dro::D3plot::read_part_ids)
 
       .def("read_part_titles", &dro::D3plot::read_part_titles)
 
-      .def("read_node_coordinates", &dro::D3plot::read_node_coordinates)
-      .def("read_node_velocity", &dro::D3plot::read_node_velocity)
-      .def("read_node_acceleration", &dro::D3plot::read_node_acceleration)
+      .def("node_indices", &dro::D3plot::node_indices)
+      .def("solid_indices", &dro::D3plot::solid_indices)
+      .def("thick_shell_indices", &dro::D3plot::thick_shell_indices)
+      .def("beam_indices", &dro::D3plot::beam_indices)
+      .def("shell_indices", &dro::D3plot::shell_indices)
+      .def("part_indices", &dro::D3plot::part_indices)
+
+      .def("read_node_coordinates",
+           py::overload_cast<size_t>(&dro::D3plot::read_node_coordinates))
+      .def("read_node_coordinates",
+           py::overload_cast<size_t, dro::Array<dro::dVec3> &>(
+               &dro::D3plot::read_node_coordinates))
+      .def("read_node_velocity",
+           py::overload_cast<size_t>(&dro::D3plot::read_node_velocity))
+      .def("read_node_velocity",
+           py::overload_cast<size_t, dro::Array<dro::dVec3> &>(
+               &dro::D3plot::read_node_velocity))
+      .def("read_node_acceleration",
+           py::overload_cast<size_t>(&dro::D3plot::read_node_acceleration))
+      .def("read_node_acceleration",
+           py::overload_cast<size_t, dro::Array<dro::dVec3> &>(
+               &dro::D3plot::read_node_acceleration))
+      .def("read_node_initial_coordinates",
+           &dro::D3plot::read_node_initial_coordinates)
+      .def("read_node_displacement",
+           py::overload_cast<size_t>(&dro::D3plot::read_node_displacement))
+      .def("read_node_displacement",
+           py::overload_cast<size_t, dro::Array<dro::dVec3> &>(
+               &dro::D3plot::read_node_displacement))
+      .def("read_node_displacement",
+           py::overload_cast<size_t, dro::Array<dro::dVec3> &,
+                             dro::Array<double> &>(
+               &dro::D3plot::read_node_displacement))
+      .def("read_node_displacement_magnitude",
+           &dro::D3plot::read_node_displacement_magnitude)
       .def("read_time", &dro::D3plot::read_time)
-      .def("read_solids_state", &dro::D3plot::read_solids_state)
-      .def("read_beams_state", &dro::D3plot::read_beams_state)
-      .def("read_shells_state", &dro::D3plot::read_shells_state)
+      .def("read_times", &dro::D3plot::read_times)
+      .def("read_global_history",
+           [](dro::D3plot &plot_file) {
+             return plot_file.read_global_history();
+           })
+      .def(
+          "read_part_global_history",
+          [](dro::D3plot &plot_file, unsigned int quantities) {
+            return plot_file.read_part_global_history(quantities);
+          },
+          py::arg("quantities") = D3PLT_PART_ALL)
+      .def("find_state", &dro::D3plot::find_state)
+      .def("read_solids_state",
+           py::overload_cast<size_t>(&dro::D3plot::read_solids_state))
+      .def("read_solids_state",
+           py::overload_cast<size_t, dro::Array<d3plot_solid> &>(
+               &dro::D3plot::read_solids_state))
+      .def("read_beams_state",
+           py::overload_cast<size_t>(&dro::D3plot::read_beams_state))
+      .def("read_beams_state",
+           py::overload_cast<size_t, dro::Array<d3plot_beam> &>(
+               &dro::D3plot::read_beams_state))
+      .def("read_shells_state",
+           py::overload_cast<size_t>(&dro::D3plot::read_shells_state))
+      .def("read_shells_state",
+           py::overload_cast<size_t, dro::Array<d3plot_shell> &>(
+               &dro::D3plot::read_shells_state))
+      .def("read_solids_von_mises", &dro::D3plot::read_solids_von_mises)
+      .def("read_solids_pressure", &dro::D3plot::read_solids_pressure)
+      .def("read_solids_principal_stresses",
+           &dro::D3plot::read_solids_principal_stresses)
+      .def("read_thick_shells_von_mises",
+           &dro::D3plot::read_thick_shells_von_mises, py::arg("state"),
+           py::arg("surface") = D3PLT_SURFACE_MID)
+      .def("read_thick_shells_pressure",
+           &dro::D3plot::read_thick_shells_pressure, py::arg("state"),
+           py::arg("surface") = D3PLT_SURFACE_MID)
+      .def("read_thick_shells_principal_stresses",
+           &dro::D3plot::read_thick_shells_principal_stresses, py::arg("state"),
+           py::arg("surface") = D3PLT_SURFACE_MID)
+      .def("read_shells_von_mises", &dro::D3plot::read_shells_von_mises,
+           py::arg("state"), py::arg("surface") = D3PLT_SURFACE_MID)
+      .def("read_shells_pressure", &dro::D3plot::read_shells_pressure,
+           py::arg("state"), py::arg("surface") = D3PLT_SURFACE_MID)
+      .def("read_shells_principal_stresses",
+           &dro::D3plot::read_shells_principal_stresses, py::arg("state"),
+           py::arg("surface") = D3PLT_SURFACE_MID)
+      .def("read_node_deletion", &dro::D3plot::read_node_deletion)
+      .def("read_solids_deletion", &dro::D3plot::read_solids_deletion)
+      .def("read_thick_shells_deletion",
+           &dro::D3plot::read_thick_shells_deletion)
+      .def("read_beams_deletion", &dro::D3plot::read_beams_deletion)
+      .def("read_shells_deletion", &dro::D3plot::read_shells_deletion)
+      .def("read_solids_state_alive",
+           [](dro::D3plot &plot_file, size_t state) {
+             dro::Array<size_t> element_indices(nullptr, 0);
+             auto elements =
+                 plot_file.read_solids_state_alive(state, element_indices);
+             return py::make_tuple(std::move(elements),
+                                   std::move(element_indices));
+           })
+      .def("read_thick_shells_state_alive",
+           [](dro::D3plot &plot_file, size_t state) {
+             dro::Array<size_t> element_indices(nullptr, 0);
+             auto elements = plot_file.read_thick_shells_state_alive(
+                 state, element_indices);
+             return py::make_tuple(std::move(elements),
+                                   std::move(element_indices));
+           })
+      .def("read_beams_state_alive",
+           [](dro::D3plot &plot_file, size_t state) {
+             dro::Array<size_t> element_indices(nullptr, 0);
+             auto elements =
+                 plot_file.read_beams_state_alive(state, element_indices);
+             return py::make_tuple(std::move(elements),
+                                   std::move(element_indices));
+           })
+      .def("read_shells_state_alive",
+           [](dro::D3plot &plot_file, size_t state) {
+             dro::Array<size_t> element_indices(nullptr, 0);
+             auto elements =
+                 plot_file.read_shells_state_alive(state, element_indices);
+             return py::make_tuple(std::move(elements),
+                                   std::move(element_indices));
+           })
+
+      .def("set_cache_size", &dro::D3plot::set_cache_size)
+      .def("cached_node_coordinates", &dro::D3plot::cached_node_coordinates)
+      .def("cached_node_velocity", &dro::D3plot::cached_node_velocity)
+      .def("cached_node_acceleration", &dro::D3plot::cached_node_acceleration)
+      .def("cached_solids_state", &dro::D3plot::cached_solids_state)
+      .def("cached_thick_shells_state",
+           &dro::D3plot::cached_thick_shells_state)
+      .def("cached_beams_state", &dro::D3plot::cached_beams_state)
+      .def("cached_shells_state", &dro::D3plot::cached_shells_state)
+      .def("cached_node_displacement", &dro::D3plot::cached_node_displacement)
+      .def("states", &dro::D3plot::states, py::arg("fields") = D3PLT_ITER_ALL,
+           py::keep_alive<0, 1>())
+      .def("read_envelopes", &dro::D3plot::read_envelopes,
+           py::arg("quantities") = D3PLT_ENVELOPE_ALL,
+           py::arg("surface") = D3PLT_SURFACE_MID, py::arg("num_threads") = 0)
+      .def("build_zone_map", &dro::D3plot::build_zone_map,
+           py::arg("quantities") = D3PLT_ZONE_ALL,
+           py::arg("surface") = D3PLT_SURFACE_MID)
+      .def(
+          "open_zone_map",
+          [](dro::D3plot &plot_file, const std::string &zone_map_file_name,
+             unsigned int quantities, int surface) {
+            return plot_file.open_zone_map(zone_map_file_name, quantities,
+                                           surface);
+          },
+          py::arg("zone_map_file_name"), py::arg("quantities") = D3PLT_ZONE_ALL,
+          py::arg("surface") = D3PLT_SURFACE_MID)
+      .def("write_zone_map",
+           [](dro::D3plot &plot_file, const dro::ZoneMap &zone_map,
+              const std::string &zone_map_file_name) {
+             plot_file.write_zone_map(zone_map, zone_map_file_name);
+           })
+
+      .def("read_node_coordinates_f32",
+           &dro::D3plot::read_node_coordinates_f32)
+      .def("read_node_velocity_f32", &dro::D3plot::read_node_velocity_f32)
+      .def("read_node_acceleration_f32",
+           &dro::D3plot::read_node_acceleration_f32)
+      .def("read_solids_state_f32", &dro::D3plot::read_solids_state_f32)
+      .def("read_shells_state_f32", &dro::D3plot::read_shells_state_f32)
+
+      .def("read_solids_state_fields",
+           [](dro::D3plot &plot_file, size_t state, unsigned int fields) {
+             return plot_file.read_solids_state_fields(state, fields);
+           })
+      .def("read_thick_shells_state_fields",
+           [](dro::D3plot &plot_file, size_t state, unsigned int fields) {
+             return plot_file.read_thick_shells_state_fields(state, fields);
+           })
+      .def("read_shells_state_fields",
+           [](dro::D3plot &plot_file, size_t state, unsigned int fields) {
+             return plot_file.read_shells_state_fields(state, fields);
+           })
+
+      .def("read_node_coordinates_soa",
+           &dro::D3plot::read_node_coordinates_soa)
+      .def("read_node_velocity_soa", &dro::D3plot::read_node_velocity_soa)
+      .def("read_node_acceleration_soa",
+           &dro::D3plot::read_node_acceleration_soa)
+      .def("read_solids_state_soa", &dro::D3plot::read_solids_state_soa)
+      .def("read_thick_shells_state_soa",
+           &dro::D3plot::read_thick_shells_state_soa)
+      .def("read_beams_state_soa", &dro::D3plot::read_beams_state_soa)
+      .def("read_shells_state_soa", &dro::D3plot::read_shells_state_soa)
+
+      .def("read_node_coordinates_history",
+           &dro::D3plot::read_node_coordinates_history)
+      .def("read_node_velocity_history",
+           &dro::D3plot::read_node_velocity_history)
+      .def("read_node_acceleration_history",
+           &dro::D3plot::read_node_acceleration_history)
+
+      .def(
+          "read_solids_history",
+          [](dro::D3plot &plot_file, const std::vector<size_t> &element_indices,
+             unsigned int fields) {
+            return plot_file.read_solids_history(element_indices, fields);
+          },
+          py::arg("element_indices"), py::arg("fields") = D3PLT_FIELD_ALL)
+      .def(
+          "read_thick_shells_history",
+          [](dro::D3plot &plot_file, const std::vector<size_t> &element_indices,
+             unsigned int fields) {
+            return plot_file.read_thick_shells_history(element_indices, fields);
+          },
+          py::arg("element_indices"), py::arg("fields") = D3PLT_FIELD_ALL)
+      .def("read_beams_history", &dro::D3plot::read_beams_history)
+      .def(
+          "read_shells_history",
+          [](dro::D3plot &plot_file, const std::vector<size_t> &element_indices,
+             unsigned int fields) {
+            return plot_file.read_shells_history(element_indices, fields);
+          },
+          py::arg("element_indices"), py::arg("fields") = D3PLT_FIELD_ALL)
+
+      .def("read_node_coordinates_at_time",
+           &dro::D3plot::read_node_coordinates_at_time)
+      .def("read_node_velocity_at_time",
+           &dro::D3plot::read_node_velocity_at_time)
+      .def("read_node_acceleration_at_time",
+           &dro::D3plot::read_node_acceleration_at_time)
+      .def("read_solids_state_at_time", &dro::D3plot::read_solids_state_at_time)
+      .def("read_thick_shells_state_at_time",
+           &dro::D3plot::read_thick_shells_state_at_time)
+      .def("read_beams_state_at_time", &dro::D3plot::read_beams_state_at_time)
+      .def("read_shells_state_at_time", &dro::D3plot::read_shells_state_at_time)
 
       .def("read_solid_elements", &dro::D3plot::read_solid_elements)
       .def("read_thick_shell_elements", &dro::D3plot::read_thick_shell_elements)
@@ -168,6 +607,7 @@ void add_d3plot_library_to_module(py::module_ &m) {
       .def("read_title", &dro::D3plot::read_title)
       /*TODO: read_run_time*/
       .def("read_part", &dro::D3plot::read_part)
+      .def("read_part_state", &dro::D3plot::read_part_state)
 
       .def("num_time_steps", &dro::D3plot::num_time_steps)
 
@@ -25,9 +25,15 @@
 
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
 #define DOCTEST_CONFIG_TREAT_CHAR_STAR_AS_STRING
+#include <algorithm>
+#include <cmath>
 #include <ctime>
+#include <d3_kernels.h>
 #include <d3plot.h>
 #include <doctest/doctest.h>
+#include <filesystem>
+#include <string>
+#include <vector>
 #ifdef D3PLOT_CPP
 #include <d3plot.hpp>
 #endif
@@ -107,6 +113,17 @@ TEST_CASE("d3plot") {
 
   free(node_ids);
 
+  {
+    const d3_word ids[] = {84285019, 10, 0, 84340381, 2852};
+    size_t indices[5];
+    CHECK(d3plot_node_indices(&plot_file, ids, 5, indices) == 4);
+    CHECK(indices[0] == 59530);
+    CHECK(indices[1] == 0);
+    CHECK(indices[2] == D3PLT_INVALID_INDEX);
+    CHECK(indices[3] == 114892);
+    CHECK(indices[4] == 2458);
+  }
+
   size_t num_elements;
   d3_word *element_ids = d3plot_read_all_element_ids(&plot_file, &num_elements);
 
@@ -117,6 +134,46 @@ TEST_CASE("d3plot") {
   CHECK(element_ids[3] == 4);
   CHECK(element_ids[133318] == 72044862);
 
+  {
+    uint8_t *element_types;
+    size_t *element_indices;
+    size_t num_origin_elements;
+    d3_word *origin_ids = d3plot_read_all_element_ids_origin(
+        &plot_file, &num_origin_elements, &element_types, &element_indices);
+    REQUIRE(num_origin_elements == num_elements);
+    CHECK(memcmp(origin_ids, element_ids, num_elements * sizeof(d3_word)) ==
+          0);
+
+    size_t num_type_ids[D3PLT_ELEMENT_TYPE_COUNT];
+    d3_word *type_ids[D3PLT_ELEMENT_TYPE_COUNT] = {
+        d3plot_read_solid_element_ids(&plot_file, &num_type_ids[0]),
+        d3plot_read_thick_shell_element_ids(&plot_file, &num_type_ids[1]),
+        d3plot_read_beam_element_ids(&plot_file, &num_type_ids[2]),
+        d3plot_read_shell_element_ids(&plot_file, &num_type_ids[3])};
+
+    size_t num_wrong_origins = 0;
+    size_t i = 0;
+    while (i < num_elements) {
+      const uint8_t type = element_types[i];
+      REQUIRE(type < D3PLT_ELEMENT_TYPE_COUNT);
+      REQUIRE(element_indices[i] < num_type_ids[type]);
+      if (type_ids[type][element_indices[i]] != origin_ids[i]) {
+        num_wrong_origins++;
+      }
+      i++;
+    }
+    CHECK(num_wrong_origins == 0);
+
+    i = 0;
+    while (i < D3PLT_ELEMENT_TYPE_COUNT) {
+      free(type_ids[i]);
+      i++;
+    }
+    free(element_indices);
+    free(element_types);
+    free(origin_ids);
+  }
+
   free(element_ids);
 
   CHECK_APPROX(d3plot_read_time(&plot_file, 0), 0.0);
@@ -140,6 +197,220 @@ TEST_CASE("d3plot") {
   CHECK_APPROX(d3plot_read_time(&plot_file, 18), 1.799880);
   CHECK_APPROX(d3plot_read_time(&plot_file, 19), 1.899986);
 
+  size_t num_states;
+  double *times = d3plot_read_times(&plot_file, &num_states);
+  REQUIRE(num_states == 102);
+  CHECK_APPROX(times[0], 0.0);
+  CHECK_APPROX(times[1], 0.0999492854);
+  CHECK_APPROX(times[19], 1.899986);
+  size_t i = 0;
+  while (i < num_states) {
+    CHECK(times[i] == d3plot_read_time(&plot_file, i));
+    i++;
+  }
+
+  CHECK(d3plot_find_state(&plot_file, -1.0) == 0);
+  CHECK(d3plot_find_state(&plot_file, 0.0) == 0);
+  CHECK(d3plot_find_state(&plot_file, times[1]) == 1);
+  CHECK(d3plot_find_state(&plot_file, 0.15) == 1);
+  CHECK(d3plot_find_state(&plot_file, 1.85) == 18);
+  CHECK(d3plot_find_state(&plot_file, times[101] + 1.0) == 101);
+
+  {
+    size_t num_globals;
+    double *global_history =
+        d3plot_read_global_history(&plot_file, &num_states, &num_globals);
+    REQUIRE(num_states == 102);
+    REQUIRE(num_globals == plot_file.control_data.nglbv);
+    REQUIRE(num_globals > D3PLT_GLOBAL_VELOCITY_Z);
+
+    double *global_values = (double *)malloc(num_globals * sizeof(double));
+    i = 0;
+    while (i < num_states) {
+      _d3plot_read_f64(&plot_file, global_values, num_globals,
+                       plot_file.data_pointers[D3PLT_PTR_STATES + i] +
+                           plot_file.data_pointers[D3PLT_PTR_STATE_TIME] + 1);
+      if (memcmp(global_values, &global_history[i * num_globals],
+                 num_globals * sizeof(double)) != 0) {
+        break;
+      }
+      CHECK(global_history[i * num_globals + D3PLT_GLOBAL_KINETIC_ENERGY] >=
+            0.0);
+      i++;
+    }
+    CHECK(i == num_states);
+
+    double *part_histories[D3PLT_PART_QUANTITY_COUNT];
+    size_t num_parts;
+    REQUIRE(d3plot_read_part_global_history(
+        &plot_file, (1 << D3PLT_PART_INTERNAL_ENERGY) | (1 << D3PLT_PART_MASS),
+        part_histories, &num_states, &num_parts));
+    REQUIRE(num_states == 102);
+    CHECK(num_parts ==
+          plot_file.control_data.nummat8 + plot_file.control_data.nummat2 +
+              plot_file.control_data.nummat4 +
+              plot_file.control_data.nummatt + plot_file.control_data.numrbs);
+    CHECK(!part_histories[D3PLT_PART_KINETIC_ENERGY]);
+    REQUIRE(part_histories[D3PLT_PART_INTERNAL_ENERGY]);
+    REQUIRE(part_histories[D3PLT_PART_MASS]);
+    CHECK(memcmp(&part_histories[D3PLT_PART_MASS][101 * num_parts],
+                 &global_history[101 * num_globals + 6 +
+                                 D3PLT_PART_MASS * num_parts],
+                 num_parts * sizeof(double)) == 0);
+    free(part_histories[D3PLT_PART_INTERNAL_ENERGY]);
+    free(part_histories[D3PLT_PART_MASS]);
+
+    free(global_values);
+    free(global_history);
+  }
+
+  /* Nothing has been added to the files since opening*/
+  REQUIRE(d3plot_refresh(&plot_file));
+  CHECK(plot_file.num_states == 102);
+  CHECK(plot_file.buffer.num_file_handles == 28);
+  CHECK(d3plot_read_time(&plot_file, 101) == times[101]);
+
+  {
+    /* Copy a truncated family into a temporary directory and let it grow like
+     * it does while the solver is still writing it*/
+    const std::filesystem::path temp_dir =
+        std::filesystem::temp_directory_path() / "d3plot_refresh_test";
+    std::filesystem::remove_all(temp_dir);
+    REQUIRE(std::filesystem::create_directories(temp_dir));
+    const std::string temp_root = (temp_dir / "d3plot").string();
+
+    const auto family_file_name = [](const std::string &root, size_t i) {
+      if (i == 0) {
+        return root;
+      }
+      char number[4];
+      sprintf(number, i < 10 ? "%02d" : "%d", (int)i);
+      return root + number;
+    };
+    /* Append the bytes [begin, end) of the ith file to its copy*/
+    const auto copy_file_bytes = [&](size_t i, size_t begin, size_t end) {
+      FILE *src = fopen(family_file_name("test_data/d3plot", i).c_str(), "rb");
+      FILE *dst = fopen(family_file_name(temp_root, i).c_str(), "ab");
+      REQUIRE(src);
+      REQUIRE(dst);
+      REQUIRE(fseek(src, begin, SEEK_SET) == 0);
+      std::vector<char> data(1024 * 1024);
+      while (begin < end) {
+        const size_t size = std::min(end - begin, data.size());
+        REQUIRE(fread(data.data(), 1, size, src) == size);
+        REQUIRE(fwrite(data.data(), 1, size, dst) == size);
+        begin += size;
+      }
+      fclose(src);
+      fclose(dst);
+    };
+
+    const d3_buffer &buffer = plot_file.buffer;
+    /* The file of a state and the byte offset of its middle inside it*/
+    const auto state_file = [&](size_t state, size_t &half_state_offset) {
+      size_t word_pos = plot_file.data_pointers[D3PLT_PTR_STATES + state];
+      size_t i = 0;
+      while (word_pos >= buffer.file_sizes[i] / buffer.word_size) {
+        word_pos -= buffer.file_sizes[i] / buffer.word_size;
+        i++;
+      }
+      half_state_offset =
+          (word_pos + plot_file.state_size / 2) * buffer.word_size;
+      return i;
+    };
+
+    /* The first state that lies in the same file as state*/
+    const auto first_file_state = [&](size_t state) {
+      size_t half_offset;
+      const size_t file = state_file(state, half_offset);
+      while (state > 0 && state_file(state - 1, half_offset) == file) {
+        state--;
+      }
+      return state;
+    };
+
+    const size_t num_states = plot_file.num_states;
+    size_t last_half_offset, grow_half_offset;
+    const size_t last_file = state_file(num_states - 1, last_half_offset);
+    const size_t last_file_state = first_file_state(num_states - 1);
+    REQUIRE(last_file_state > 0);
+    const size_t grow_file_state = first_file_state(last_file_state - 1);
+    const size_t grow_file = state_file(grow_file_state, grow_half_offset);
+
+    /* Stop in the middle of the first state of grow_file*/
+    size_t i = 0;
+    while (i < grow_file) {
+      copy_file_bytes(i, 0, buffer.file_sizes[i]);
+      i++;
+    }
+    copy_file_bytes(grow_file, 0, grow_half_offset);
+
+    d3plot_file refresh_file = d3plot_open(temp_root.c_str());
+    if (refresh_file.error_string) {
+      FAIL(refresh_file.error_string);
+    } else {
+      CHECK(refresh_file.num_states == grow_file_state);
+      CHECK(refresh_file.buffer.num_file_handles == grow_file + 1);
+
+      /* Grow the last file, so that all of its states appear*/
+      copy_file_bytes(grow_file, grow_half_offset,
+                      buffer.file_sizes[grow_file]);
+      REQUIRE(d3plot_refresh(&refresh_file));
+      CHECK(refresh_file.num_states == last_file_state);
+      CHECK(refresh_file.buffer.num_file_handles == grow_file + 1);
+
+      /* Add new files whose last state is only partially written*/
+      i = grow_file + 1;
+      while (i < last_file) {
+        copy_file_bytes(i, 0, buffer.file_sizes[i]);
+        i++;
+      }
+      copy_file_bytes(last_file, 0, last_half_offset);
+      REQUIRE(d3plot_refresh(&refresh_file));
+      CHECK(refresh_file.num_states == num_states - 1);
+      CHECK(refresh_file.buffer.num_file_handles == last_file + 1);
+
+      /* Nothing has been written since the last refresh*/
+      REQUIRE(d3plot_refresh(&refresh_file));
+      CHECK(refresh_file.num_states == num_states - 1);
+
+      copy_file_bytes(last_file, last_half_offset,
+                      buffer.file_sizes[last_file]);
+      REQUIRE(d3plot_refresh(&refresh_file));
+      REQUIRE(refresh_file.num_states == num_states);
+      CHECK(memcmp(refresh_file.data_pointers, plot_file.data_pointers,
+                   (D3PLT_PTR_COUNT + num_states) * sizeof(size_t)) == 0);
+      CHECK(memcmp(refresh_file.state_times, plot_file.state_times,
+                   num_states * sizeof(double)) == 0);
+      CHECK(d3plot_read_time(&refresh_file, num_states - 1) ==
+            d3plot_read_time(&plot_file, num_states - 1));
+    }
+
+    d3plot_close(&refresh_file);
+    std::filesystem::remove_all(temp_dir);
+  }
+
+  {
+    size_t num_nodes0, num_nodes1, num_nodes_at_time;
+    double *nodes0 = d3plot_read_node_coordinates(&plot_file, 18, &num_nodes0);
+    double *nodes1 = d3plot_read_node_coordinates(&plot_file, 19, &num_nodes1);
+    double *nodes_at_time = d3plot_read_node_coordinates_at_time(
+        &plot_file, (times[18] + times[19]) * 0.5, &num_nodes_at_time);
+    REQUIRE(num_nodes_at_time == num_nodes0);
+    CHECK_APPROX(nodes_at_time[0], (nodes0[0] + nodes1[0]) * 0.5);
+    CHECK_APPROX(nodes_at_time[1], (nodes0[1] + nodes1[1]) * 0.5);
+    CHECK_APPROX(nodes_at_time[2], (nodes0[2] + nodes1[2]) * 0.5);
+    free(nodes_at_time);
+
+    nodes_at_time = d3plot_read_node_coordinates_at_time(&plot_file, times[19],
+                                                         &num_nodes_at_time);
+    CHECK(nodes_at_time[3 * 1000 + 2] == nodes1[3 * 1000 + 2]);
+    free(nodes_at_time);
+    free(nodes0);
+    free(nodes1);
+  }
+  free(times);
+
   double *node_data = d3plot_read_node_coordinates(&plot_file, 0, &num_nodes);
   REQUIRE(num_nodes == 114893);
   CHECK_APPROX(node_data[0], 0.031293001);
@@ -195,7 +466,7 @@ TEST_CASE("d3plot") {
   CHECK(solids_con[43985].node_ids[6] == 33139);
   CHECK(solids_con[43985].node_ids[7] == 33138);
 
-  size_t i = 0;
+  i = 0;
   while (i < num_elements) {
     CHECK(solids_con[i].material_id == 9);
     i++;
@@ -320,6 +591,34 @@ TEST_CASE("d3plot") {
   CHECK(part.num_shells == 5000);
   d3plot_free_part(&part);
 
+  {
+    part = d3plot_read_part(&plot_file, 7);
+    d3plot_part_state part_state = d3plot_read_part_state(&plot_file, 7, 101);
+    REQUIRE(part_state.num_shells == part.num_shells);
+    CHECK(part_state.num_solids == part.num_solids);
+    size_t num_ids;
+    d3_word *shell_ids = d3plot_read_shell_element_ids(&plot_file, &num_ids);
+    d3plot_shell *shells =
+        d3plot_read_shells_state(&plot_file, 101, &num_elements);
+    size_t j = 0;
+    i = 0;
+    while (i < num_elements && j < part.num_shells) {
+      if (shell_ids[i] == part.shell_ids[j]) {
+        if (memcmp(&part_state.shells[j], &shells[i], sizeof(d3plot_shell)) !=
+            0) {
+          break;
+        }
+        j++;
+      }
+      i++;
+    }
+    CHECK(j == part.num_shells);
+    free(shells);
+    free(shell_ids);
+    d3plot_free_part_state(&part_state);
+    d3plot_free_part(&part);
+  }
+
   part = d3plot_read_part(&plot_file, 8);
   CHECK(part.num_solids == 45000);
   d3plot_free_part(&part);
@@ -341,8 +640,580 @@ TEST_CASE("d3plot") {
   d3plot_shell *shells =
       d3plot_read_shells_state(&plot_file, 101, &num_elements);
   REQUIRE(num_elements == 88456);
+
+  {
+    d3plot_solid *solids_into =
+        (d3plot_solid *)malloc(45000 * sizeof(d3plot_solid));
+    d3plot_shell *shells_into =
+        (d3plot_shell *)malloc(88456 * sizeof(d3plot_shell));
+    solids = d3plot_read_solids_state(&plot_file, 100, &num_elements);
+    REQUIRE(d3plot_read_solids_state_into(&plot_file, 100, solids_into));
+    CHECK(memcmp(solids_into, solids, 45000 * sizeof(d3plot_solid)) == 0);
+    REQUIRE(d3plot_read_shells_state_into(&plot_file, 101, shells_into));
+    CHECK(memcmp(shells_into, shells, 88456 * sizeof(d3plot_shell)) == 0);
+
+    node_data = d3plot_read_node_coordinates(&plot_file, 50, &num_nodes);
+    double *node_data_into =
+        (double *)malloc(plot_file.control_data.numnp * 3 * sizeof(double));
+    REQUIRE(d3plot_read_node_coordinates_into(&plot_file, 50, node_data_into));
+    CHECK(memcmp(node_data_into, node_data,
+                 num_nodes * 3 * sizeof(double)) == 0);
+
+    CHECK(!d3plot_read_solids_state_into(&plot_file, 102, solids_into));
+    REQUIRE(plot_file.error_string);
+    free(plot_file.error_string);
+    plot_file.error_string = NULL;
+
+    free(node_data_into);
+    free(node_data);
+    free(shells_into);
+    free(solids_into);
+    free(solids);
+  }
+
+  {
+    d3plot_set_cache_size(&plot_file, 2 * 88456 * sizeof(d3plot_shell));
+    d3plot_cached_state *cached_shells =
+        d3plot_cache_get(&plot_file, 101, D3PLT_CACHE_SHELLS);
+    REQUIRE(cached_shells);
+    REQUIRE(cached_shells->num_items == 88456);
+    CHECK(memcmp(cached_shells->data, shells, 88456 * sizeof(d3plot_shell)) ==
+          0);
+    CHECK(d3plot_cache_get(&plot_file, 101, D3PLT_CACHE_SHELLS) ==
+          cached_shells);
+    d3plot_cache_release(cached_shells);
+
+    /* Evict state 101 while it is still referenced*/
+    d3plot_cache_release(d3plot_cache_get(&plot_file, 100, D3PLT_CACHE_SHELLS));
+    d3plot_cache_release(d3plot_cache_get(&plot_file, 99, D3PLT_CACHE_SHELLS));
+    CHECK(plot_file.cache_size == 2 * 88456 * sizeof(d3plot_shell));
+    CHECK(cached_shells->ref_count == 1);
+    CHECK(memcmp(cached_shells->data, shells, 88456 * sizeof(d3plot_shell)) ==
+          0);
+    d3plot_cache_release(cached_shells);
+
+    /* A failed read must not be cached, so the second get fails as well*/
+    const size_t cache_size = plot_file.cache_size;
+    int j = 0;
+    while (j < 2) {
+      CHECK(!d3plot_cache_get(&plot_file, 102, D3PLT_CACHE_SHELLS));
+      REQUIRE(plot_file.error_string);
+      CHECK(strcmp(plot_file.error_string,
+                   "102 is out of bounds for the states") == 0);
+      free(plot_file.error_string);
+      plot_file.error_string = NULL;
+      CHECK(plot_file.cache_size == cache_size);
+      j++;
+    }
+
+    d3plot_set_cache_size(&plot_file, 0);
+    CHECK(plot_file.cache_size == 0);
+    CHECK(!plot_file.cache_first);
+  }
+
+  {
+    size_t num_alive, num_flags;
+    size_t *alive_indices;
+    d3plot_shell *alive_shells = d3plot_read_shells_state_alive(
+        &plot_file, 101, &num_alive, &alive_indices);
+    REQUIRE(!plot_file.error_string);
+    REQUIRE(num_alive <= 88456);
+
+    uint8_t *flags = d3plot_read_shells_deletion(&plot_file, 101, &num_flags);
+    if (plot_file.control_data.mdlopt == 2) {
+      REQUIRE(num_flags == 88456);
+      size_t num_active = 0;
+      size_t i = 0;
+      while (i < num_flags) {
+        num_active += flags[i];
+        i++;
+      }
+      CHECK(num_active == num_alive);
+      free(flags);
+    } else {
+      CHECK(num_alive == 88456);
+      CHECK(!flags);
+      CHECK(num_flags == 0);
+      REQUIRE(plot_file.error_string);
+      free(plot_file.error_string);
+      plot_file.error_string = NULL;
+    }
+
+    size_t num_mismatches = 0;
+    size_t i = 0;
+    while (i < num_alive) {
+      if ((i != 0 && alive_indices[i] <= alive_indices[i - 1]) ||
+          memcmp(&alive_shells[i], &shells[alive_indices[i]],
+                 sizeof(d3plot_shell)) != 0) {
+        num_mismatches++;
+      }
+      i++;
+    }
+    CHECK(num_mismatches == 0);
+    free(alive_indices);
+    free(alive_shells);
+
+    CHECK(!d3plot_read_solids_state_alive(&plot_file, 102, &num_alive,
+                                          &alive_indices));
+    CHECK(num_alive == 0);
+    CHECK(!alive_indices);
+    REQUIRE(plot_file.error_string);
+    free(plot_file.error_string);
+    plot_file.error_string = NULL;
+  }
+
+  {
+    d3plot_state_iter iter;
+    REQUIRE(d3plot_state_iter_begin(
+        &plot_file, &iter,
+        (1 << D3PLT_CACHE_NODE_COORDINATES) | (1 << D3PLT_CACHE_SHELLS)));
+
+    size_t num_iterated = 0;
+    size_t num_mismatches = 0;
+    d3plot_state_data *data;
+    while ((data = d3plot_state_iter_next(&iter))) {
+      if (data->state != num_iterated ||
+          data->time != d3plot_read_time(&plot_file, data->state) ||
+          data->data[D3PLT_CACHE_SOLIDS] ||
+          data->num_items[D3PLT_CACHE_SHELLS] != 88456) {
+        num_mismatches++;
+      }
+      if (data->state == 101 &&
+          memcmp(data->data[D3PLT_CACHE_SHELLS], shells,
+                 88456 * sizeof(d3plot_shell)) != 0) {
+        num_mismatches++;
+      }
+      num_iterated++;
+    }
+    CHECK(!plot_file.error_string);
+    CHECK(num_iterated == plot_file.num_states);
+    CHECK(num_mismatches == 0);
+    CHECK(!d3plot_state_iter_next(&iter));
+    d3plot_state_iter_end(&iter);
+  }
+
+  {
+    size_t num_von_mises, num_pressures;
+    double *von_mises =
+        d3plot_read_shells_von_mises(&plot_file, 101, D3PLT_SURFACE_OUTER,
+                                     &num_von_mises);
+    double *pressures = d3plot_read_shells_pressure(
+        &plot_file, 101, D3PLT_SURFACE_OUTER, &num_pressures);
+    REQUIRE(num_von_mises == 88456);
+    REQUIRE(num_pressures == 88456);
+
+    const d3plot_tensor *t = &shells[88455].outer.sigma;
+    CHECK_APPROX(von_mises[88455],
+                 sqrt(0.5 * ((t->x - t->y) * (t->x - t->y) +
+                             (t->y - t->z) * (t->y - t->z) +
+                             (t->z - t->x) * (t->z - t->x)) +
+                      3.0 * (t->xy * t->xy + t->yz * t->yz + t->zx * t->zx)));
+    CHECK_APPROX(pressures[88455], -(t->x + t->y + t->z) / 3.0);
+    free(pressures);
+    free(von_mises);
+
+    CHECK(!d3plot_read_shells_von_mises(&plot_file, 101, 3, &num_von_mises));
+    CHECK(num_von_mises == 0);
+    REQUIRE(plot_file.error_string);
+    free(plot_file.error_string);
+    plot_file.error_string = NULL;
+  }
+
+  {
+    size_t num_initial, num_displacement, num_magnitudes;
+    double *initial =
+        d3plot_read_node_initial_coordinates(&plot_file, &num_initial);
+    node_data = d3plot_read_node_coordinates(&plot_file, 50, &num_nodes);
+    double *displacement =
+        d3plot_read_node_displacement(&plot_file, 50, &num_displacement);
+    double *magnitudes = d3plot_read_node_displacement_magnitude(
+        &plot_file, 50, &num_magnitudes);
+    REQUIRE(num_initial == num_nodes);
+    REQUIRE(num_displacement == num_nodes);
+    REQUIRE(num_magnitudes == num_nodes);
+
+    size_t num_mismatches = 0;
+    size_t i = 0;
+    while (i < num_nodes) {
+      const double *d = &displacement[i * 3];
+      if (d[0] != node_data[i * 3] - initial[i * 3] ||
+          d[1] != node_data[i * 3 + 1] - initial[i * 3 + 1] ||
+          d[2] != node_data[i * 3 + 2] - initial[i * 3 + 2] ||
+          fabs(magnitudes[i] - sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2])) >
+              10e-6) {
+        num_mismatches++;
+      }
+      i++;
+    }
+    CHECK(num_mismatches == 0);
+    free(magnitudes);
+    free(displacement);
+    free(node_data);
+    free(initial);
+
+    CHECK(!d3plot_read_node_displacement(&plot_file, 102, &num_displacement));
+    CHECK(num_displacement == 0);
+    REQUIRE(plot_file.error_string);
+    free(plot_file.error_string);
+    plot_file.error_string = NULL;
+  }
+
+  {
+    const unsigned int quantities = (1 << D3PLT_ENVELOPE_NODE_DISPLACEMENT) |
+                                    (1 << D3PLT_ENVELOPE_SHELL_VON_MISES);
+    d3plot_envelope single[D3PLT_ENVELOPE_QUANTITY_COUNT];
+    d3plot_envelope threaded[D3PLT_ENVELOPE_QUANTITY_COUNT];
+    REQUIRE(d3plot_read_envelopes(&plot_file, quantities, D3PLT_SURFACE_OUTER,
+                                  1, single));
+    REQUIRE(d3plot_read_envelopes(&plot_file, quantities, D3PLT_SURFACE_OUTER,
+                                  4, threaded));
+    CHECK(single[D3PLT_ENVELOPE_SOLID_VON_MISES].num_items == 0);
+    CHECK(!single[D3PLT_ENVELOPE_SOLID_VON_MISES].max);
+    CHECK(single[D3PLT_ENVELOPE_NODE_DISPLACEMENT].num_items ==
+          plot_file.control_data.numnp);
+    REQUIRE(single[D3PLT_ENVELOPE_SHELL_VON_MISES].num_items == 88456);
+
+    size_t num_von_mises;
+    double *von_mises = d3plot_read_shells_von_mises(
+        &plot_file, 101, D3PLT_SURFACE_OUTER, &num_von_mises);
+    REQUIRE(num_von_mises == 88456);
+
+    const d3plot_envelope *envelope = &single[D3PLT_ENVELOPE_SHELL_VON_MISES];
+    size_t num_mismatches = 0;
+    size_t i = 0;
+    while (i < 88456) {
+      if (envelope->max[i] < von_mises[i] || envelope->min[i] > von_mises[i] ||
+          envelope->max_state[i] >= plot_file.num_states) {
+        num_mismatches++;
+      }
+      i++;
+    }
+    CHECK(num_mismatches == 0);
+    free(von_mises);
+
+    /* The merged ranges of the threads need to give the same result*/
+    int q = 0;
+    while (q < D3PLT_ENVELOPE_QUANTITY_COUNT) {
+      const size_t n = single[q].num_items;
+      REQUIRE(threaded[q].num_items == n);
+      if (n != 0) {
+        CHECK(memcmp(single[q].max, threaded[q].max, n * sizeof(double)) == 0);
+        CHECK(memcmp(single[q].min, threaded[q].min, n * sizeof(double)) == 0);
+        CHECK(memcmp(single[q].max_state, threaded[q].max_state,
+                     n * sizeof(size_t)) == 0);
+        CHECK(memcmp(single[q].min_state, threaded[q].min_state,
+                     n * sizeof(size_t)) == 0);
+      }
+      d3plot_free_envelope(&single[q]);
+      d3plot_free_envelope(&threaded[q]);
+      q++;
+    }
+  }
   free(shells);
 
+  {
+    size_t num_nodes32, num_elements32;
+    node_data = d3plot_read_node_coordinates(&plot_file, 50, &num_nodes);
+    float *node_data32 =
+        d3plot_read_node_coordinates_f32(&plot_file, 50, &num_nodes32);
+    REQUIRE(num_nodes32 == num_nodes);
+    CHECK(node_data32[0] == (float)node_data[0]);
+    CHECK(node_data32[59530 * 3 + 1] == (float)node_data[59530 * 3 + 1]);
+    CHECK(node_data32[num_nodes * 3 - 1] == (float)node_data[num_nodes * 3 - 1]);
+    free(node_data);
+    free(node_data32);
+
+    solids = d3plot_read_solids_state(&plot_file, 101, &num_elements);
+    d3plot_solid_f32 *solids32 =
+        d3plot_read_solids_state_f32(&plot_file, 101, &num_elements32);
+    REQUIRE(num_elements32 == num_elements);
+    CHECK(solids32[0].sigma.x == (float)solids[0].sigma.x);
+    CHECK(solids32[44999].sigma.zx == (float)solids[44999].sigma.zx);
+    CHECK(solids32[20000].effective_plastic_strain ==
+          (float)solids[20000].effective_plastic_strain);
+    CHECK(solids32[20000].epsilon.xy == (float)solids[20000].epsilon.xy);
+    free(solids);
+    free(solids32);
+
+    shells = d3plot_read_shells_state(&plot_file, 101, &num_elements);
+    d3plot_shell_f32 *shells32 =
+        d3plot_read_shells_state_f32(&plot_file, 101, &num_elements32);
+    REQUIRE(num_elements32 == num_elements);
+    CHECK(shells32[0].mid.sigma.x == (float)shells[0].mid.sigma.x);
+    CHECK(shells32[88455].outer.sigma.yz == (float)shells[88455].outer.sigma.yz);
+    CHECK(shells32[4000].inner_epsilon.zx ==
+          (float)shells[4000].inner_epsilon.zx);
+    CHECK(shells32[4000].internal_energy == (float)shells[4000].internal_energy);
+    free(shells);
+    free(shells32);
+  }
+
+  {
+    node_data = d3plot_read_node_coordinates(&plot_file, 50, &num_nodes);
+    double *x = (double *)malloc(num_nodes * sizeof(double));
+    double *y = (double *)malloc(num_nodes * sizeof(double));
+    double *z = (double *)malloc(num_nodes * sizeof(double));
+    REQUIRE(d3plot_read_node_coordinates_soa(&plot_file, 50, x, y, z) == 1);
+    size_t i = 0;
+    while (i < num_nodes) {
+      if (x[i] != node_data[i * 3 + 0] || y[i] != node_data[i * 3 + 1] ||
+          z[i] != node_data[i * 3 + 2]) {
+        break;
+      }
+      i++;
+    }
+    CHECK(i == num_nodes);
+    free(node_data);
+    free(x);
+    free(y);
+    free(z);
+
+    solids = d3plot_read_solids_state(&plot_file, 101, &num_elements);
+    double *components[sizeof(d3plot_solid) / sizeof(double)];
+    memset(components, 0, sizeof(components));
+    components[D3PLT_COMPONENT(d3plot_solid, sigma.x)] =
+        (double *)malloc(num_elements * sizeof(double));
+    components[D3PLT_COMPONENT(d3plot_solid, epsilon.xy)] =
+        (double *)malloc(num_elements * sizeof(double));
+    REQUIRE(d3plot_read_solids_state_soa(&plot_file, 101, components) == 1);
+    i = 0;
+    while (i < num_elements) {
+      if (components[D3PLT_COMPONENT(d3plot_solid, sigma.x)][i] !=
+              solids[i].sigma.x ||
+          components[D3PLT_COMPONENT(d3plot_solid, epsilon.xy)][i] !=
+              solids[i].epsilon.xy) {
+        break;
+      }
+      i++;
+    }
+    CHECK(i == num_elements);
+    free(solids);
+    free(components[D3PLT_COMPONENT(d3plot_solid, sigma.x)]);
+    free(components[D3PLT_COMPONENT(d3plot_solid, epsilon.xy)]);
+
+    CHECK(d3plot_read_solids_state_soa(&plot_file, 102, components) == 0);
+    REQUIRE(plot_file.error_string != NULL);
+    free(plot_file.error_string);
+    plot_file.error_string = NULL;
+  }
+
+  {
+    size_t num_values;
+    solids = d3plot_read_solids_state(&plot_file, 101, &num_elements);
+    double *values = d3plot_read_solids_state_fields(
+        &plot_file, 101, D3PLT_FIELD_EFFECTIVE_PLASTIC_STRAIN, &num_elements,
+        &num_values);
+    REQUIRE(values != NULL);
+    REQUIRE(num_values == 1);
+    size_t i = 0;
+    while (i < num_elements) {
+      if (values[i] != solids[i].effective_plastic_strain) {
+        break;
+      }
+      i++;
+    }
+    CHECK(i == num_elements);
+    free(values);
+    free(solids);
+
+    shells = d3plot_read_shells_state(&plot_file, 101, &num_elements);
+    values = d3plot_read_shells_state_fields(
+        &plot_file, 101, D3PLT_FIELD_STRESS | D3PLT_FIELD_INTERNAL_ENERGY,
+        &num_elements, &num_values);
+    REQUIRE(values != NULL);
+    REQUIRE(num_values == 19);
+    CHECK(values[4000 * num_values + 0] == shells[4000].mid.sigma.x);
+    CHECK(values[4000 * num_values + 12] == shells[4000].outer.sigma.x);
+    CHECK(values[4000 * num_values + 18] == shells[4000].internal_energy);
+    free(values);
+    free(shells);
+  }
+
+  {
+    const size_t node_indices[] = {59530, 0, 100, 59530};
+    size_t num_states;
+    double *history = d3plot_read_node_coordinates_history(
+        &plot_file, node_indices, 4, &num_states);
+    REQUIRE(history != NULL);
+    REQUIRE(num_states == plot_file.num_states);
+    node_data = d3plot_read_node_coordinates(&plot_file, 50, &num_nodes);
+    size_t i = 0;
+    while (i < 4) {
+      const double *node = &history[(50 * 4 + i) * 3];
+      if (node[0] != node_data[node_indices[i] * 3 + 0] ||
+          node[1] != node_data[node_indices[i] * 3 + 1] ||
+          node[2] != node_data[node_indices[i] * 3 + 2]) {
+        break;
+      }
+      i++;
+    }
+    CHECK(i == 4);
+    free(node_data);
+    free(history);
+
+    const size_t invalid_index = num_nodes;
+    CHECK(d3plot_read_node_coordinates_history(&plot_file, &invalid_index, 1,
+                                               &num_states) == NULL);
+    CHECK(num_states == 0);
+    REQUIRE(plot_file.error_string != NULL);
+    free(plot_file.error_string);
+    plot_file.error_string = NULL;
+  }
+
+  {
+    const size_t element_indices[] = {88455, 4000};
+    size_t num_states, num_values;
+    double *history = d3plot_read_shells_history(
+        &plot_file, element_indices, 2, D3PLT_FIELD_INTERNAL_ENERGY,
+        &num_states, &num_values);
+    REQUIRE(history != NULL);
+    REQUIRE(num_states == plot_file.num_states);
+    REQUIRE(num_values == 1);
+    shells = d3plot_read_shells_state(&plot_file, 101, &num_elements);
+    CHECK(history[101 * 2 + 0] == shells[88455].internal_energy);
+    CHECK(history[101 * 2 + 1] == shells[4000].internal_energy);
+    free(shells);
+    free(history);
+  }
+
+  {
+    const char *index_file_name = "d3plot_test.index";
+    remove(index_file_name);
+
+    /* The first open writes the index and the second one reads it*/
+    int j = 0;
+    while (j < 2) {
+      d3plot_file indexed_file =
+          d3plot_open_indexed("test_data/d3plot", index_file_name);
+      if (indexed_file.error_string) {
+        FAIL(indexed_file.error_string);
+        d3plot_close(&indexed_file);
+        break;
+      }
+
+      CHECK(indexed_file.num_states == plot_file.num_states);
+      CHECK(indexed_file.state_size == plot_file.state_size);
+      CHECK(indexed_file.control_data.numnp == plot_file.control_data.numnp);
+      CHECK(indexed_file.control_data.nel4 == plot_file.control_data.nel4);
+      CHECK(indexed_file.control_data.nel8 == plot_file.control_data.nel8);
+      CHECK(indexed_file.control_data.istrn == plot_file.control_data.istrn);
+      CHECK(memcmp(indexed_file.data_pointers, plot_file.data_pointers,
+                   (D3PLT_PTR_COUNT + plot_file.num_states) *
+                       sizeof(size_t)) == 0);
+      CHECK(d3plot_read_time(&indexed_file, 101) ==
+            d3plot_read_time(&plot_file, 101));
+
+      d3plot_close(&indexed_file);
+      j++;
+    }
+
+    remove(index_file_name);
+  }
+
+  {
+    const char *zone_map_file_name = "d3plot_test.zonemap";
+    remove(zone_map_file_name);
+
+    d3plot_zone_map zone_map;
+    REQUIRE(d3plot_build_zone_map(&plot_file, D3PLT_ZONE_ALL, D3PLT_SURFACE_MID,
+                                  &zone_map));
+    REQUIRE(zone_map.num_states == plot_file.num_states);
+    REQUIRE(zone_map.num_parts == plot_file.control_data.nmmat);
+    CHECK((zone_map.quantities & (1 << D3PLT_ZONE_PLASTIC_STRAIN)) != 0);
+
+    /* Every element of a part needs to lie inside the summary of the part*/
+    size_t num_mismatches = 0;
+    size_t p = 0;
+    while (p < zone_map.num_parts) {
+      const size_t zone = (101 * zone_map.num_parts + p) *
+                              D3PLT_ZONE_QUANTITY_COUNT +
+                          D3PLT_ZONE_PLASTIC_STRAIN;
+      d3plot_part_state part_state = d3plot_read_part_state(&plot_file, p, 101);
+      size_t i = 0;
+      while (i < part_state.num_shells) {
+        const double value = part_state.shells[i].mid.effective_plastic_strain;
+        if (value < zone_map.min[zone] || value > zone_map.max[zone]) {
+          num_mismatches++;
+        }
+        i++;
+      }
+      i = 0;
+      while (i < part_state.num_solids) {
+        const double value = part_state.solids[i].effective_plastic_strain;
+        if (value < zone_map.min[zone] || value > zone_map.max[zone]) {
+          num_mismatches++;
+        }
+        i++;
+      }
+      d3plot_free_part_state(&part_state);
+      p++;
+    }
+    CHECK(num_mismatches == 0);
+
+    /* The state at which the part with the largest value reaches it needs to
+     * be a candidate*/
+    size_t part_index = 0;
+    double max_value = -HUGE_VAL;
+    p = 0;
+    while (p < zone_map.num_parts) {
+      const double value =
+          zone_map.max[(101 * zone_map.num_parts + p) *
+                           D3PLT_ZONE_QUANTITY_COUNT +
+                       D3PLT_ZONE_PLASTIC_STRAIN];
+      if (value > max_value) {
+        max_value = value;
+        part_index = p;
+      }
+      p++;
+    }
+    size_t num_states;
+    size_t *states =
+        d3plot_zone_map_states(&zone_map, D3PLT_ZONE_PLASTIC_STRAIN, max_value,
+                               HUGE_VAL, &part_index, 1, &num_states);
+    CHECK(num_states <= zone_map.num_states);
+    int found = 0;
+    size_t i = 0;
+    while (i < num_states) {
+      found |= states[i] == 101;
+      i++;
+    }
+    CHECK(found);
+    free(states);
+
+    size_t num_parts;
+    size_t *parts =
+        d3plot_zone_map_parts(&zone_map, 101, D3PLT_ZONE_PLASTIC_STRAIN,
+                              max_value, HUGE_VAL, &num_parts);
+    found = 0;
+    i = 0;
+    while (i < num_parts) {
+      found |= parts[i] == part_index;
+      i++;
+    }
+    CHECK(found);
+    free(parts);
+
+    /* The first open writes the file and the second one reads it*/
+    int j = 0;
+    while (j < 2) {
+      d3plot_zone_map opened;
+      REQUIRE(d3plot_open_zone_map(&plot_file, D3PLT_ZONE_ALL,
+                                   D3PLT_SURFACE_MID, zone_map_file_name,
+                                   &opened));
+      REQUIRE(opened.num_states == zone_map.num_states);
+      CHECK(opened.quantities == zone_map.quantities);
+      const size_t num_values = zone_map.num_states * zone_map.num_parts *
+                                D3PLT_ZONE_QUANTITY_COUNT;
+      CHECK(memcmp(opened.min, zone_map.min, num_values * sizeof(double)) == 0);
+      CHECK(memcmp(opened.max, zone_map.max, num_values * sizeof(double)) == 0);
+      d3plot_free_zone_map(&opened);
+      j++;
+    }
+
+    d3plot_free_zone_map(&zone_map);
+    remove(zone_map_file_name);
+  }
+
   d3plot_close(&plot_file);
 }
 
@@ -382,6 +1253,11 @@ TEST_CASE("d3plot C++") {
     CHECK(node_ids[0] == 10);
     CHECK(node_ids[114892] == 84340381);
     CHECK(node_ids[2458] == 2852);
+
+    const auto node_indices = plot_file.node_indices({2852, 84285019});
+    REQUIRE(node_indices.size() == 2);
+    CHECK(node_indices[0] == 2458);
+    CHECK(node_indices[1] == 59530);
   }
 
   {
@@ -395,6 +1271,20 @@ TEST_CASE("d3plot C++") {
     CHECK(element_ids[133318] == 72044862);
   }
 
+  {
+    dro::Array<uint8_t> element_types(nullptr, 0);
+    dro::Array<size_t> element_indices(nullptr, 0);
+    const auto element_ids(
+        plot_file.read_all_element_ids_origin(element_types, element_indices));
+
+    REQUIRE(element_ids.size() == 133456);
+    REQUIRE(element_types.size() == 133456);
+    REQUIRE(element_indices.size() == 133456);
+    CHECK(element_ids[0] == 1);
+    CHECK(element_ids[133318] == 72044862);
+    CHECK(element_types[133318] < D3PLT_ELEMENT_TYPE_COUNT);
+  }
+
   CHECK_APPROX(plot_file.read_time(0), 0.0);
   CHECK_APPROX(plot_file.read_time(1), 0.0999492854);
   CHECK_APPROX(plot_file.read_time(2), 0.1998985708);
@@ -416,6 +1306,36 @@ TEST_CASE("d3plot C++") {
   CHECK_APPROX(plot_file.read_time(18), 1.799880);
   CHECK_APPROX(plot_file.read_time(19), 1.899986);
 
+  {
+    const auto times(plot_file.read_times());
+    REQUIRE(times.size() == 102);
+    CHECK_APPROX(times[0], 0.0);
+    CHECK_APPROX(times[1], 0.0999492854);
+    CHECK_APPROX(times[19], 1.899986);
+
+    CHECK(plot_file.find_state(0.15) == 1);
+    CHECK(plot_file.find_state(times[101] + 1.0) == 101);
+
+    size_t num_globals;
+    const auto global_history(plot_file.read_global_history(&num_globals));
+    REQUIRE(num_globals == plot_file.get_handle().control_data.nglbv);
+    CHECK(global_history.size() == 102 * num_globals);
+
+    size_t num_parts;
+    const auto part_histories(plot_file.read_part_global_history(
+        1 << D3PLT_PART_KINETIC_ENERGY, &num_parts));
+    REQUIRE(part_histories.size() == D3PLT_PART_QUANTITY_COUNT);
+    CHECK(part_histories[D3PLT_PART_KINETIC_ENERGY].size() == 102 * num_parts);
+    CHECK(part_histories[D3PLT_PART_MASS].empty());
+
+    const auto nodes0(plot_file.read_node_coordinates(18));
+    const auto nodes1(plot_file.read_node_coordinates(19));
+    const auto nodes_at_time(
+        plot_file.read_node_coordinates_at_time((times[18] + times[19]) * 0.5));
+    REQUIRE(nodes_at_time.size() == nodes0.size());
+    CHECK_APPROX(nodes_at_time[0][2], (nodes0[0][2] + nodes1[0][2]) * 0.5);
+  }
+
   {
     const auto node_data(plot_file.read_node_coordinates(0));
     REQUIRE(node_data.size() == 114893);
@@ -605,6 +1525,262 @@ TEST_CASE("d3plot C++") {
     const auto shells = plot_file.read_shells_state(101);
     REQUIRE(shells.size() == 88456);
   }
+
+  {
+    dro::Array<d3plot_shell> shells(nullptr, 0);
+    plot_file.read_shells_state(101, shells);
+    REQUIRE(shells.size() == 88456);
+    const d3plot_shell *shells_data = shells.data();
+
+    const auto shells100 = plot_file.read_shells_state(100);
+    plot_file.read_shells_state(100, shells);
+    REQUIRE(shells.size() == 88456);
+    CHECK(shells.data() == shells_data);
+    CHECK(memcmp(shells.data(), shells100.data(),
+                 88456 * sizeof(d3plot_shell)) == 0);
+
+    dro::Array<dro::dVec3> nodes(nullptr, 0);
+    plot_file.read_node_coordinates(50, nodes);
+    CHECK(nodes.size() == plot_file.read_node_coordinates(50).size());
+  }
+
+  {
+    plot_file.set_cache_size(64 * 1024 * 1024);
+    const auto nodes = plot_file.cached_node_coordinates(50);
+    const auto nodes_again = plot_file.cached_node_coordinates(50);
+    CHECK(nodes.data() == nodes_again.data());
+    const auto read_nodes = plot_file.read_node_coordinates(50);
+    REQUIRE(nodes.size() == read_nodes.size());
+    CHECK(memcmp(nodes.data(), read_nodes.data(),
+                 nodes.size() * sizeof(dro::dVec3)) == 0);
+
+    plot_file.set_cache_size(0);
+    CHECK(nodes[0] == read_nodes[0]);
+    CHECK(plot_file.cached_solids_state(101).size() == 45000);
+  }
+
+  {
+    const auto solids = plot_file.read_solids_state(101);
+    dro::Array<size_t> alive_indices(nullptr, 0);
+    const auto alive_solids =
+        plot_file.read_solids_state_alive(101, alive_indices);
+    REQUIRE(alive_indices.size() == alive_solids.size());
+    REQUIRE(alive_solids.size() <= solids.size());
+
+    size_t num_mismatches = 0;
+    size_t i = 0;
+    while (i < alive_solids.size()) {
+      if (memcmp(&alive_solids[i], &solids[alive_indices[i]],
+                 sizeof(d3plot_solid)) != 0) {
+        num_mismatches++;
+      }
+      i++;
+    }
+    CHECK(num_mismatches == 0);
+
+    try {
+      const auto flags = plot_file.read_solids_deletion(101);
+      CHECK(flags.size() == 45000);
+    } catch (const dro::D3plot::Exception &e) {
+      CHECK(alive_solids.size() == 45000);
+    }
+  }
+
+  {
+    const auto solids = plot_file.read_solids_state(101);
+    size_t num_iterated = 0;
+    for (const auto state : plot_file.states(1 << D3PLT_CACHE_SOLIDS)) {
+      CHECK(state.state() == num_iterated);
+      CHECK(state.node_coordinates().empty());
+      REQUIRE(state.solids().size() == 45000);
+      if (state.state() == 101) {
+        CHECK(memcmp(state.solids().data(), solids.data(),
+                     45000 * sizeof(d3plot_solid)) == 0);
+      }
+      num_iterated++;
+    }
+    CHECK(num_iterated == plot_file.read_times().size());
+  }
+
+  {
+    const auto solids = plot_file.read_solids_state(101);
+    const auto principal = plot_file.read_solids_principal_stresses(101);
+    REQUIRE(principal.size() == 45000);
+    CHECK(principal[20000][0] >= principal[20000][1]);
+    CHECK(principal[20000][1] >= principal[20000][2]);
+    CHECK_APPROX(principal[20000][0] + principal[20000][1] +
+                     principal[20000][2],
+                 solids[20000].sigma.x + solids[20000].sigma.y +
+                     solids[20000].sigma.z);
+
+    const auto von_mises = plot_file.read_shells_von_mises(101);
+    REQUIRE(von_mises.size() == 88456);
+  }
+
+  {
+    const auto initial = plot_file.read_node_initial_coordinates();
+    dro::Array<dro::dVec3> displacement(nullptr, 0);
+    dro::Array<double> magnitudes(nullptr, 0);
+    size_t num_mismatches = 0;
+    for (const auto state :
+         plot_file.states((1 << D3PLT_CACHE_NODE_COORDINATES) |
+                          (1 << D3PLT_CACHE_NODE_DISPLACEMENT))) {
+      plot_file.read_node_displacement(state.state(), displacement,
+                                       magnitudes);
+      REQUIRE(state.node_displacement().size() == initial.size());
+      REQUIRE(displacement.size() == initial.size());
+      if (memcmp(state.node_displacement().data(), displacement.data(),
+                 initial.size() * sizeof(dro::dVec3)) != 0 ||
+          state.node_coordinates()[100][0] - initial[100][0] !=
+              displacement[100][0]) {
+        num_mismatches++;
+      }
+    }
+    CHECK(num_mismatches == 0);
+    CHECK(magnitudes.size() == initial.size());
+
+    try {
+      plot_file.read_node_displacement(102);
+      FAIL("No exception was thrown");
+    } catch (const dro::D3plot::Exception &e) {
+      CHECK(strcmp(e.what(), "102 is out of bounds for the states") == 0);
+    }
+  }
+
+  {
+    const auto envelopes = plot_file.read_envelopes(
+        1 << D3PLT_ENVELOPE_SOLID_PLASTIC_STRAIN, D3PLT_SURFACE_MID, 2);
+    REQUIRE(envelopes.size() == D3PLT_ENVELOPE_QUANTITY_COUNT);
+    CHECK(envelopes[D3PLT_ENVELOPE_SHELL_VON_MISES].max.empty());
+
+    const auto &envelope = envelopes[D3PLT_ENVELOPE_SOLID_PLASTIC_STRAIN];
+    REQUIRE(envelope.max.size() == 45000);
+    const auto solids = plot_file.read_solids_state(envelope.max_state[20000]);
+    CHECK(solids[20000].effective_plastic_strain == envelope.max[20000]);
+    CHECK(envelope.min[20000] <= envelope.max[20000]);
+
+    try {
+      plot_file.read_envelopes(D3PLT_ENVELOPE_ALL, 3);
+      FAIL("No exception was thrown");
+    } catch (const dro::D3plot::Exception &e) {
+      CHECK(strcmp(e.what(), "3 is not a valid surface") == 0);
+    }
+  }
+
+  {
+    const dro::ZoneMap zone_map =
+        plot_file.build_zone_map(1 << D3PLT_ZONE_VON_MISES);
+    REQUIRE(zone_map.num_states() == plot_file.num_time_steps());
+    CHECK(zone_map.quantities() == (1 << D3PLT_ZONE_VON_MISES));
+
+    // Velocities have not been summarized, so no state can be skipped
+    CHECK(zone_map.states(D3PLT_ZONE_VELOCITY, 1.0e300, HUGE_VAL).size() ==
+          zone_map.num_states());
+
+    size_t part_index = 0;
+    for (size_t p = 1; p < zone_map.num_parts(); p++) {
+      if (zone_map.max(101, p, D3PLT_ZONE_VON_MISES) >
+          zone_map.max(101, part_index, D3PLT_ZONE_VON_MISES)) {
+        part_index = p;
+      }
+    }
+
+    const double max_value =
+        zone_map.max(101, part_index, D3PLT_ZONE_VON_MISES);
+    const auto states = zone_map.states(D3PLT_ZONE_VON_MISES, max_value,
+                                        HUGE_VAL, {part_index});
+    CHECK(std::find(states.begin(), states.end(), 101) != states.end());
+    const auto parts =
+        zone_map.parts(101, D3PLT_ZONE_VON_MISES, max_value, HUGE_VAL);
+    CHECK(std::find(parts.begin(), parts.end(), part_index) != parts.end());
+
+    try {
+      zone_map.min(zone_map.num_states(), 0, D3PLT_ZONE_VON_MISES);
+      FAIL("No exception was thrown");
+    } catch (const std::runtime_error &e) {
+      CHECK(strcmp(e.what(), "Index out of Range") == 0);
+    }
+
+    try {
+      plot_file.build_zone_map(D3PLT_ZONE_ALL, 3);
+      FAIL("No exception was thrown");
+    } catch (const dro::D3plot::Exception &e) {
+      CHECK(strcmp(e.what(), "3 is not a valid surface") == 0);
+    }
+  }
+
+  {
+    const auto nodes = plot_file.read_node_coordinates(50);
+    const auto nodes32 = plot_file.read_node_coordinates_f32(50);
+    REQUIRE(nodes32.size() == nodes.size());
+    CHECK(nodes32[59530][1] == static_cast<float>(nodes[59530][1]));
+
+    const auto solids = plot_file.read_solids_state(101);
+    const auto solids32 = plot_file.read_solids_state_f32(101);
+    REQUIRE(solids32.size() == 45000);
+    CHECK(solids32[20000].sigma.y == static_cast<float>(solids[20000].sigma.y));
+
+    const auto shells32 = plot_file.read_shells_state_f32(101);
+    REQUIRE(shells32.size() == 88456);
+  }
+
+  {
+    const auto nodes = plot_file.read_node_coordinates(50);
+    const auto nodes_soa = plot_file.read_node_coordinates_soa(50);
+    REQUIRE(nodes_soa.size() == 3);
+    REQUIRE(nodes_soa[1].size() == nodes.size());
+    CHECK(nodes_soa[1][59530] == nodes[59530][1]);
+
+    const auto shells = plot_file.read_shells_state(101);
+    const auto shells_soa = plot_file.read_shells_state_soa(101);
+    REQUIRE(shells_soa.size() == sizeof(d3plot_shell) / sizeof(double));
+    CHECK(shells_soa[D3PLT_COMPONENT(d3plot_shell, outer.sigma.yz)][88455] ==
+          shells[88455].outer.sigma.yz);
+    CHECK(shells_soa[D3PLT_COMPONENT(d3plot_shell, internal_energy)][4000] ==
+          shells[4000].internal_energy);
+  }
+
+  {
+    const auto solids = plot_file.read_solids_state(101);
+    size_t num_values;
+    const auto eps = plot_file.read_solids_state_fields(
+        101, D3PLT_FIELD_EFFECTIVE_PLASTIC_STRAIN, &num_values);
+    REQUIRE(num_values == 1);
+    REQUIRE(eps.size() == solids.size());
+    CHECK(eps[11] == solids[11].effective_plastic_strain);
+  }
+
+  {
+    const auto nodes = plot_file.read_node_velocity(20);
+    const auto history = plot_file.read_node_velocity_history({4000, 2});
+    REQUIRE(history.size() == plot_file.num_time_steps() * 2);
+    CHECK(history[20 * 2 + 0] == nodes[4000]);
+    CHECK(history[20 * 2 + 1] == nodes[2]);
+  }
+
+  {
+    const auto solids = plot_file.read_solids_state(101);
+    size_t num_values;
+    const auto history = plot_file.read_solids_history(
+        {11, 0}, D3PLT_FIELD_EFFECTIVE_PLASTIC_STRAIN, &num_values);
+    REQUIRE(num_values == 1);
+    REQUIRE(history.size() == plot_file.num_time_steps() * 2);
+    CHECK(history[101 * 2 + 0] == solids[11].effective_plastic_strain);
+    CHECK(history[101 * 2 + 1] == solids[0].effective_plastic_strain);
+  }
+
+  {
+    const auto part_state = plot_file.read_part_state(1, 101);
+    CHECK(part_state.shells.size() == 10);
+    CHECK(part_state.solids.size() == 0);
+
+    try {
+      plot_file.read_part_state(1, 102);
+      FAIL("No exception was thrown");
+    } catch (const dro::D3plot::Exception &e) {
+      CHECK(strlen(e.what()) > 0);
+    }
+  }
 }
 #endif
 
@@ -625,80 +1801,159 @@ TEST_CASE("_get_nth_digit") {
   CHECK(_get_nth_digit(value1, 4) == 0);
 }
 
-TEST_CASE("_insert_sorted") {
-  {
-    const d3_word dst[7] = {1, 2, 3, 10, 11, 12, 13};
-    const d3_word src[6] = {4, 5, 6, 7, 8, 9};
-    d3_word *_dst = (d3_word *)malloc(7 * sizeof(d3_word));
-    memcpy(_dst, dst, sizeof(dst));
+TEST_CASE("d3_kernels") {
+  const int best_isa = d3_kernels_get_isa();
+  const size_t lengths[] = {0, 1, 3, 7, 8, 15, 16, 17, 33, 100};
 
-    _dst = _insert_sorted(_dst, 7, src, 6);
-    size_t i = 1;
-    while (i <= 13) {
-      CHECK(_dst[i - 1] == i);
-      i++;
+  int isa = D3_KERNELS_SCALAR;
+  while (isa <= D3_KERNELS_AVX512) {
+    if (d3_kernels_set_isa(isa) != isa) {
+      isa++;
+      continue;
     }
 
-    free(_dst);
-  }
-  {
-    const d3_word dst[4] = {10, 11, 12, 13};
-    const d3_word src[6] = {4, 5, 6, 7, 8, 9};
-    d3_word *_dst = (d3_word *)malloc(4 * sizeof(d3_word));
-    memcpy(_dst, dst, sizeof(dst));
+    for (const size_t n : lengths) {
+      float f32[100];
+      double f64[100];
+      uint32_t u32[100];
+      uint64_t u64[100];
+      size_t i = 0;
+      while (i < n) {
+        f32[i] = (float)i * 0.25f - 3.0f;
+        u32[i] = 0xFFFFFFF0u + (uint32_t)i;
+        i++;
+      }
+
+      d3_kernel_widen_f32(f64, f32, n);
+      d3_kernel_widen_u32(u64, u32, n);
+      i = 0;
+      while (i < n) {
+        CHECK(f64[i] == (double)f32[i]);
+        CHECK(u64[i] == (uint64_t)u32[i]);
+        i++;
+      }
+
+      float narrowed[100];
+      d3_kernel_narrow_f64(narrowed, f64, n);
+      i = 0;
+      while (i < n) {
+        CHECK(narrowed[i] == f32[i]);
+        i++;
+      }
+
+      /* In place*/
+      double in_place[100];
+      memcpy((float *)in_place + n, f32, n * sizeof(float));
+      d3_kernel_widen_f32(in_place, (float *)in_place + n, n);
+      i = 0;
+      while (i < n) {
+        CHECK(in_place[i] == (double)f32[i]);
+        i++;
+      }
+      d3_kernel_narrow_f64((float *)in_place, in_place, n);
+      i = 0;
+      while (i < n) {
+        CHECK(((float *)in_place)[i] == f32[i]);
+        i++;
+      }
+
+      /* Displacement of n nodes*/
+      float coords32[300];
+      double coords64[300], ref[300], displacement[300], magnitudes[100];
+      i = 0;
+      while (i < n * 3) {
+        coords32[i] = (float)i * 0.5f - 7.0f;
+        coords64[i] = coords32[i];
+        ref[i] = (double)(i % 7);
+        i++;
+      }
+      d3_kernel_displacement_f32(displacement, magnitudes, coords32, ref, n);
+      i = 0;
+      while (i < n) {
+        const double x = coords64[i * 3] - ref[i * 3],
+                     y = coords64[i * 3 + 1] - ref[i * 3 + 1],
+                     z = coords64[i * 3 + 2] - ref[i * 3 + 2];
+        CHECK(displacement[i * 3] == x);
+        CHECK(displacement[i * 3 + 1] == y);
+        CHECK(displacement[i * 3 + 2] == z);
+        CHECK_APPROX(magnitudes[i], sqrt(x * x + y * y + z * z));
+        i++;
+      }
+
+      /* In place*/
+      double in_place_displacement[300];
+      memcpy((float *)in_place_displacement + n * 3, coords32,
+             n * 3 * sizeof(float));
+      d3_kernel_displacement_f32(in_place_displacement, NULL,
+                                 (float *)in_place_displacement + n * 3, ref,
+                                 n);
+      CHECK(memcmp(in_place_displacement, displacement,
+                   n * 3 * sizeof(double)) == 0);
+      d3_kernel_displacement_f64(coords64, NULL, coords64, ref, n);
+      CHECK(memcmp(coords64, displacement, n * 3 * sizeof(double)) == 0);
+
+      /* Running maximum and minimum over two states*/
+      double max[100], min[100];
+      size_t max_state[100], min_state[100];
+      i = 0;
+      while (i < n) {
+        max[i] = -HUGE_VAL;
+        min[i] = HUGE_VAL;
+        max_state[i] = min_state[i] = 0;
+        i++;
+      }
+      d3_kernel_envelope(max, min, max_state, min_state, f64, 3, n);
+      d3_kernel_envelope(max, min, max_state, min_state, ref, 5, n);
+      i = 0;
+      while (i < n) {
+        CHECK(max[i] == (f64[i] >= ref[i] ? f64[i] : ref[i]));
+        CHECK(max_state[i] == (f64[i] >= ref[i] ? 3 : 5));
+        CHECK(min[i] == (f64[i] <= ref[i] ? f64[i] : ref[i]));
+        CHECK(min_state[i] == (f64[i] <= ref[i] ? 3 : 5));
+        i++;
+      }
+    }
 
-    _dst = _insert_sorted(_dst, 4, src, 6);
-    size_t i = 4;
-    while (i <= 13) {
-      CHECK(_dst[i - 4] == i);
+    /* Take 3 values starting at 2 and 2 values starting at 0 out of elements
+     * with 7 values and put zeros in between*/
+    float src[10 * 7];
+    double dst[10 * 6];
+    size_t i = 0;
+    while (i < 10 * 7) {
+      src[i] = (float)i;
       i++;
     }
-
-    free(_dst);
-  }
-  {
-    const d3_word dst[6] = {4, 5, 6, 7, 8, 9};
-    const d3_word src[4] = {10, 11, 12, 13};
-    d3_word *_dst = (d3_word *)malloc(6 * sizeof(d3_word));
-    memcpy(_dst, dst, sizeof(dst));
-
-    _dst = _insert_sorted(_dst, 6, src, 4);
-    size_t i = 4;
-    while (i <= 13) {
-      CHECK(_dst[i - 4] == i);
+    const size_t runs[] = {0, 2, 3, 3, D3_KERNELS_ZERO_RUN, 1, 4, 0, 2};
+    d3_kernel_widen_f32_runs(dst, 6, src, 7, 10, runs, 3);
+    i = 0;
+    while (i < 10) {
+      CHECK(dst[i * 6 + 0] == (double)(i * 7 + 2));
+      CHECK(dst[i * 6 + 1] == (double)(i * 7 + 3));
+      CHECK(dst[i * 6 + 2] == (double)(i * 7 + 4));
+      CHECK(dst[i * 6 + 3] == 0.0);
+      CHECK(dst[i * 6 + 4] == (double)(i * 7 + 0));
+      CHECK(dst[i * 6 + 5] == (double)(i * 7 + 1));
       i++;
     }
 
-    free(_dst);
-  }
-  {
-    const d3_word dst[1] = {4};
-    const d3_word src[4] = {10, 11, 12, 13};
-    d3_word *_dst = (d3_word *)malloc(1 * sizeof(d3_word));
-    memcpy(_dst, dst, sizeof(dst));
-
-    _dst = _insert_sorted(_dst, 1, src, 4);
-    CHECK(_dst[0] == 4);
-    CHECK(_dst[1] == 10);
-    CHECK(_dst[2] == 11);
-    CHECK(_dst[3] == 12);
-    CHECK(_dst[4] == 13);
+    /* Runs that are longer than a SIMD register*/
+    float wide_src[3 * 40];
+    double wide_dst[3 * 40];
+    i = 0;
+    while (i < 3 * 40) {
+      wide_src[i] = (float)i;
+      i++;
+    }
+    const size_t wide_runs[] = {0, 1, 37, 37, D3_KERNELS_ZERO_RUN, 3};
+    d3_kernel_widen_f32_runs(wide_dst, 40, wide_src, 40, 3, wide_runs, 2);
+    i = 0;
+    while (i < 3 * 40) {
+      CHECK(wide_dst[i] == (i % 40 < 37 ? (double)(i + 1) : 0.0));
+      i++;
+    }
 
-    free(_dst);
+    isa++;
   }
-  {
-    const d3_word dst[1] = {14};
-    const d3_word src[4] = {10, 11, 12, 13};
-    d3_word *_dst = (d3_word *)malloc(1 * sizeof(d3_word));
-    memcpy(_dst, dst, sizeof(dst));
 
-    _dst = _insert_sorted(_dst, 1, src, 4);
-    CHECK(_dst[0] == 10);
-    CHECK(_dst[1] == 11);
-    CHECK(_dst[2] == 12);
-    CHECK(_dst[3] == 13);
-    CHECK(_dst[4] == 14);
-
-    free(_dst);
-  }
-}
\ No newline at end of file
+  d3_kernels_set_isa(best_isa);
+}
@@ -31,6 +31,7 @@ target("d3plot")
     set_languages("ansi")
     if is_plat("linux") then
         add_cxxflags("-fPIC")
+        add_syslinks("pthread", "m", {public = true})
     end
     add_files("src/d3*.c")
     add_headerfiles("src/d3*.h")